@@ -0,0 +1,404 @@
+#ifndef BASELINE_OPERATORS_H
+#define BASELINE_OPERATORS_H
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+/**
+    Operators of the four tp modules as they were before any engine replaced
+    them (naive loops on float / int images), kept as the baseline of
+    goldenCheck: the current operators must give the same outputs, except
+    where a change of behaviour is documented. Debug prints are removed, the
+    Mat arithmetic of morphologicalGradient is spelled out per pixel.
+*/
+namespace baseline {
+
+using namespace cv;
+using namespace std;
+
+/********************************************
+                CONVOLUTION
+*********************************************/
+
+inline float pixelMeanValue(Mat image, int k, int i, int j) {
+    int min_row = max(i - k, 0);
+    int max_row = min(i + k, image.rows - 1);
+    int min_col = max(j - k, 0);
+    int max_col = min(j + k, image.cols - 1);
+
+    float sum_px = 0.0;
+    for (int m = min_row ; m <= max_row; m++ ) {
+        for (int n = min_col; n <= max_col; n++) {
+            sum_px += image.at<float>(m,n);
+        }
+    }
+    int size_window = (2*k+1) * (2*k+1);
+    return sum_px / (float)size_window;
+}
+
+inline Mat meanFilter(Mat image, int k) {
+    Mat res = image.clone();
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            res.at<float>(i,j) = pixelMeanValue(image, k, i, j);
+        }
+    }
+    return res;
+}
+
+inline float pxValue(Mat mat, int i, int j) {
+    if (i < 0 || j < 0 || i >= mat.rows || j >= mat.cols)
+        return 0;
+    else
+        return mat.at<float>(i,j);
+}
+
+inline float pxConvolution(Mat image, Mat kernel, int i, int j) {
+    int k = (kernel.rows - 1) / 2;
+    float sum_px = 0.0;
+    for (int m = -k; m <=k; m++) {
+        for (int n = -k; n <=k; n++) {
+            sum_px += pxValue(image, i + m, j + n) * kernel.at<float>(m + k, n + k);
+        }
+    }
+    return sum_px;
+}
+
+inline Mat convolution(Mat image, Mat kernel) {
+    Mat res = image.clone();
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            res.at<float>(i,j) = pxConvolution(image, kernel, i, j);
+        }
+    }
+    return res;
+}
+
+inline Mat edgeSobel(Mat image) {
+    Mat res = image.clone();
+    Mat sobel_x(3, 3, CV_32FC1), sobel_y(3, 3, CV_32FC1);
+    const float x[] = {-1, 0, 1, -2, 0, 2, -1, 0, 1}, y[] = {1, 2, 1, 0, 0, 0, -1, -2, -1};
+    for (int t = 0; t < 9; t++) {
+        sobel_x.at<float>(t / 3, t % 3) = x[t];
+        sobel_y.at<float>(t / 3, t % 3) = y[t];
+    }
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            float dfdx = pxConvolution(image, sobel_x, i, j);
+            float dfdy = pxConvolution(image, sobel_y, i, j);
+            res.at<float>(i,j) = abs(dfdx) + abs(dfdy);
+        }
+    }
+    return res;
+}
+
+inline float gaussian(float x, float sigma2) {
+    return 1.0/(2*M_PI*sigma2)*exp(-x*x/(2*sigma2));
+}
+
+inline float pxBilateralFilter(Mat image, Mat kernel, int i, int j, double sigma_r) {
+    int k = (kernel.rows - 1) / 2;
+    float sum_px = 0.0;
+    float norm_fact = 0.0;
+    float pxVal = image.at<float>(i,j);
+
+    for (int m = -k; m <=k; m++) {
+        for (int n = -k; n <=k; n++) {
+            if (((i+m) >= 0) && ((j+n) >=0) && ((i+m) < image.rows) && ((j+n) < image.cols)) {
+                float neighVal = image.at<float>(i + m, j  + n);
+                float temp = kernel.at<float>(m + k, n + k);
+                sum_px += temp * gaussian(abs(pxVal - neighVal), (float) pow(sigma_r,2)) * neighVal;
+                norm_fact += temp * gaussian(abs(pxVal - neighVal), (float) pow(sigma_r,2));
+            }
+        }
+    }
+    return sum_px / norm_fact;
+}
+
+inline Mat bilateralFilter(Mat image, Mat kernel, double sigma_r) {
+    Mat res = image.clone();
+    for (int i = 0; i < res.rows; i++) {
+        for (int j = 0; j < res.cols; j ++) {
+            res.at<float>(i,j) = pxBilateralFilter(image, kernel, i, j, sigma_r);
+        }
+    }
+    return res;
+}
+
+/********************************************
+                MORPHOLOGY
+*********************************************/
+
+inline float pixelMedianValue(Mat image, int k, int n, int m) {
+    vector<float> pixelsValues;
+    int min_row = max(n - k, 0);
+    int max_row = min(n + k, image.rows - 1);
+    int min_col = max(m - k, 0);
+    int max_col = min(m + k, image.cols - 1);
+
+    for (int i = min_row ; i <= max_row; i++) {
+        for (int j = min_col; j <= max_col; j++) {
+            pixelsValues.push_back(image.at<float>(i,j));
+        }
+    }
+    sort(pixelsValues.begin(), pixelsValues.end());
+
+    if (pixelsValues.size() % 2 == 0)
+        return (pixelsValues[pixelsValues.size()/2-1] + pixelsValues[pixelsValues.size()/2])/2;
+    return pixelsValues[pixelsValues.size()/2];
+}
+
+inline float pixelDilate(Mat image, Mat structuringElement, int i, int j) {
+    vector<float> pixelsValues = {};
+    int window_width = (structuringElement.rows - 1) / 2;
+    int window_height = (structuringElement.cols - 1) / 2;
+
+    for (int x = -window_width; x <= window_width; x++) {
+        for (int y = -window_height; y <= window_height; y++) {
+            if((i+x >= 0 && i+x < image.rows && j+y >= 0 && j+y < image.cols) && structuringElement.at<float>(x + window_width, y + window_height) == 1) {
+                pixelsValues.push_back(image.at<float>(i+x, j+y));
+            }
+        }
+    }
+    return *max_element(pixelsValues.begin(), pixelsValues.end());
+}
+
+inline Mat median(Mat image, int size) {
+    Mat res = image.clone();
+    assert(size>0);
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            res.at<float>(i,j) = pixelMedianValue(image, size, i, j);
+        }
+    }
+    return res;
+}
+
+inline Mat erode(Mat image, Mat structuringElement) {
+    Mat res = image.clone();
+    Mat negated = -image;
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            res.at<float>(i,j) = -pixelDilate(negated, structuringElement, i, j);
+        }
+    }
+    return res;
+}
+
+inline Mat dilate(Mat image, Mat structuringElement) {
+    Mat res = image.clone();
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            res.at<float>(i,j) = pixelDilate(image, structuringElement, i, j);
+        }
+    }
+    return res;
+}
+
+inline Mat open(Mat image, Mat structuringElement) {
+    return dilate(erode(image, structuringElement), structuringElement);
+}
+
+inline Mat close(Mat image, Mat structuringElement) {
+    return erode(dilate(image, structuringElement), structuringElement);
+}
+
+/**
+    (image - erode(image)) - dilate(image) - image, as written in the baseline.
+*/
+inline Mat morphologicalGradient(Mat image, Mat structuringElement) {
+    Mat eroded = erode(image, structuringElement), dilated = dilate(image, structuringElement);
+    Mat res = image.clone();
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            float v = image.at<float>(i,j);
+            res.at<float>(i,j) = ((v - eroded.at<float>(i,j)) - dilated.at<float>(i,j)) - v;
+        }
+    }
+    return res;
+}
+
+/********************************************
+                GEOMETRY
+*********************************************/
+
+inline Mat transpose(Mat image) {
+    Mat res = Mat::zeros(image.cols, image.rows, CV_32FC1);
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            res.at<int>(j,i) = image.at<int>(i,j);
+        }
+    }
+    return res;
+}
+
+inline float interpolate_nearest(Mat image, float x, float y) {
+    int a = (int) round(x);
+    int b = (int) round(y);
+    return image.at<float>(a,b);
+}
+
+inline float interpolate_bilinear(Mat image, float x, float y) {
+    int x1 = int(x);
+    int y1 = int(y);
+    int x2 = x1 + 1;
+    int y2 = y1 + 1;
+
+    float alpha = image.at<float>(x2, y1) - image.at<float>(x1, y1);
+    float beta = image.at<float>(x2, y2) - image.at<float>(x1, y2);
+
+    float f_x_y1 = image.at<float>(x1, y1) + alpha * (x - x1);
+    float f_x_y2 = image.at<float>(x1, y2) + beta * (x - x1);
+
+    float gamma = f_x_y2 - f_x_y1;
+    return f_x_y1 + (y - y1) * gamma;
+}
+
+inline Mat expand(Mat image, int factor, float(* interpolationFunction)(Mat image, float y, float x)) {
+    assert(factor>0);
+    Mat res = Mat::zeros((image.rows -1) * factor,(image.cols -1) * factor,CV_32FC1);
+    for (int i = 0 ; i < res.rows; i++) {
+        for(int j = 0; j < res.cols; j++) {
+            res.at<float>(i,j) = interpolationFunction(image, (float) i  / factor, (float) j / factor);
+        }
+    }
+    return res;
+}
+
+inline Mat rotate(Mat image, float angle, float(* interpolationFunction)(Mat image, float y, float x)) {
+    int height = image.rows;
+    int width = image.cols;
+
+    float alpha = angle * M_PI / 180;
+    double twoPi = 2.0 * M_PI;
+    alpha = alpha - twoPi * floor(alpha / twoPi);
+
+    float old_center_x = (float) (width - 1) / 2.0;
+    float old_center_y = (float) (height - 1) / 2.0;
+
+    int newWidth, newHeight;
+    if (alpha < M_PI / 2.0) {
+        newWidth = int((width-1) * cos(alpha) + (height-1) * sin(alpha)) + 1 ;
+        newHeight = int((width-1) * sin(alpha) + (height-1) * cos(alpha)) + 1;
+    } else {
+        newWidth = int( - (width - 1) * cos(alpha) + (height - 1) * sin(alpha) );
+        newHeight = int( (width - 1) * sin(alpha) - (height - 1) * cos(alpha) );
+    }
+
+    Mat res = Mat::zeros(newHeight, newWidth,CV_32FC1);
+    float center_x = (float) (newWidth - 1) / 2.0;
+    float center_y = (float) (newHeight - 1) / 2.0;
+
+    for (int i = 0 ; i < res.rows; i++) {
+        for(int j = 0; j < res.cols; j++) {
+            float u = ((float) j) - center_x;
+            float v = ((float) i) - center_y;
+
+            float x = u * cos(alpha) - v * sin(alpha);
+            float y = u * sin(alpha) + v * cos(alpha);
+
+            x = x + old_center_x;
+            y = y + old_center_y;
+
+            if (x > 0 && x < image.cols - 1  && y > 0 && y < image.rows - 1 ) {
+                res.at<float>(i, j) = interpolationFunction(image, y, x);
+            }
+        }
+    }
+    return res;
+}
+
+/********************************************
+            CONNECTED COMPONENTS
+*********************************************/
+
+inline bool isInImage(Point2i p, Mat image) {
+    return (p.x >=0 && p.x < image.rows && p.y >= 0 && p.y < image.cols);
+}
+
+inline bool hasSameColor(Point2i p1, Point2i p2, Mat image) {
+    return image.at<int>(p1.x, p1.y) == image.at<int>(p2.x, p2.y);
+}
+
+inline vector<Point2i> getUnvisitedNeighboursOfSameColour(Mat image, vector<vector<bool>> &visited, Point2i p) {
+    vector<Point2i> result = {};
+    vector<Point2i> neighbours = {{-1,0}, {0,-1}, {0,1}, {1,0}};
+    for (Point2i d: neighbours) {
+        Point2i neighbour(p.x + d.x, p.y + d.y);
+        if (isInImage(neighbour, image) && !visited[neighbour.x][neighbour.y] && hasSameColor(p, neighbour, image))
+            result.push_back(neighbour);
+    }
+    return result;
+}
+
+inline int extractCC(Mat image, Mat res, vector<vector<bool>> &visited, Point2i p, int compteur) {
+    int cc_size = 0;
+    vector<Point2i> cc_neighbours = {p};
+    while (cc_neighbours.size() > 0) {
+        cc_size ++;
+        Point2i v = cc_neighbours[0];
+        cc_neighbours.erase(cc_neighbours.begin());
+        res.at<int>(v.x, v.y) = compteur;
+        visited[v.x][v.y] = true;
+        for (Point2i n: getUnvisitedNeighboursOfSameColour(image, visited, v)) {
+            bool known = std::any_of(cc_neighbours.begin(), cc_neighbours.end(),
+                                     [&](const Point2i &q) { return q.x == n.x && q.y == n.y; });
+            if (!known)
+                cc_neighbours.push_back(n);
+        }
+    }
+    return cc_size;
+}
+
+inline Mat ccLabel(Mat image) {
+    Mat res = Mat::zeros(image.rows, image.cols, CV_32SC1);
+    vector<vector<bool>> visited(image.rows, vector<bool>(image.cols));
+    int compteur = 0;
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            if ( ! visited[i][j]) {
+                visited[i][j] = true;
+                if (image.at<int>(i,j) != 0) {
+                    compteur += 1;
+                    extractCC(image, res, visited, {i,j}, compteur);
+                }
+            }
+        }
+    }
+    return res;
+}
+
+inline Mat ccAreaFilter(Mat image, int size) {
+    Mat res = image.clone();
+    Mat cc = Mat::zeros(image.rows, image.cols, CV_32SC1);
+    vector<vector<bool>> visited(image.rows, vector<bool>(image.cols));
+    int compteur = 0;
+    vector<int> cc_sizes = {};
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            if ( ! visited[i][j]) {
+                visited[i][j] = true;
+                if (image.at<int>(i,j) != 0) {
+                    compteur += 1;
+                    cc_sizes.push_back(extractCC(image, cc, visited, {i,j}, compteur));
+                }
+            }
+        }
+    }
+    // res.setTo(0, cc == label) of the small components
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            int label = cc.at<int>(i,j);
+            if (label > 0 && cc_sizes[label - 1] < size)
+                res.at<int>(i,j) = 0;
+        }
+    }
+    return res;
+}
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include "../bufferPool.h"
+#include "../convolutionEngine.h"
+#include "../morphologyEngine.h"
+#include "../boxFilter.h"
+#include "../rankFilters.h"
+#include "../pipeline.h"
+#include "../parallel.h"
+#include "benchCommon.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+using namespace cv;
+
+/**
+    Heap calls of the whole process (library, OpenCV, standard library)
+    while counting is on: malloc and its variants are interposed on glibc,
+    elsewhere the global operator new is replaced.
+*/
+static std::atomic<bool> countingHeap{false};
+static std::atomic<long long> heapCalls{0};
+
+static inline void countHeapCall() {
+    if (countingHeap.load(std::memory_order_relaxed))
+        heapCalls.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef __GLIBC__
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size) {
+    countHeapCall();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    countHeapCall();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+    countHeapCall();
+    return __libc_realloc(p, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+    countHeapCall();
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    countHeapCall();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **p, size_t alignment, size_t size) {
+    countHeapCall();
+    *p = __libc_memalign(alignment, size);
+    return *p == nullptr ? ENOMEM : 0;
+}
+}
+#else
+void *operator new(size_t size) {
+    countHeapCall();
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+#endif
+
+/**
+    Steady state check: after two warm-up frames, processing frames of the
+    same size through the dst / buffers overloads must allocate neither
+    images nor scratch memory, and make no heap call at all. Exits with 1
+    otherwise, so it can run in CI.
+
+    The frames run on the calling thread: the buffers of the pool workers
+    grow the first time a worker gets a given tile, which depends on the
+    scheduling, so a multi-threaded count would not be reproducible.
+*/
+int main()
+{
+    setNumThreads(1);
+    Mat image = randomImage(1080, 1920);
+    Mat gauss(5, 5, CV_32FC1);
+    const float binomial[5] = {1, 4, 6, 4, 1};
+    for (int m = 0; m < 5; m++) {
+        for (int n = 0; n < 5; n++)
+            gauss.at<float>(m, n) = binomial[m] * binomial[n] / 256;
+    }
+    Mat element(3, 3, CV_32FC1, Scalar(1));
+
+    Pipeline pipeline;
+    Pipeline::Node edges = pipeline.threshold(pipeline.sobel(pipeline.convolve(pipeline.input(), gauss)), 100);
+    Pipeline::Node closedEdges = pipeline.close(edges, element);
+
+    Mat blurred, direct, sobel, mean, median, dilated, eroded, opened, closed, gradient, fused;
+    MorphologyBuffers buffers;
+    auto frame = [&]() {
+        convolve(image, gauss, blurred, CONV_SEPARABLE);
+        convolve(image, gauss, direct, CONV_DIRECT);
+        sobelEdges(blurred, sobel);
+        boxFilter(image, 3, mean);
+        medianFilter(image, 2, median);
+        dilateFilter(image, element, dilated, buffers);
+        erodeFilter(image, element, eroded, buffers);
+        openFilter(image, element, opened, buffers);
+        closeFilter(image, element, closed, buffers);
+        gradientFilter(image, element, gradient, buffers);
+        pipeline.run(image, closedEdges, fused);
+    };
+
+    frame();
+    frame();
+    resetAllocationCounters();
+    heapCalls = 0;
+    countingHeap = true;
+    const int frames = 5;
+    double t = bestTime(frame, frames);
+    countingHeap = false;
+    AllocationCounters counters = allocationCounters();
+
+    printf("frame_ms,images,image_bytes,scratch_blocks,scratch_bytes,heap_calls_per_frame\n");
+    printf("%.1f,%lld,%lld,%lld,%lld,%lld\n", t * 1e3, (long long) counters.images, (long long) counters.imageBytes,
+           (long long) counters.scratchBlocks, (long long) counters.scratchBytes, heapCalls.load() / frames);
+    return counters.images == 0 && counters.scratchBlocks == 0 && heapCalls.load() == 0 ? 0 : 1;
+}
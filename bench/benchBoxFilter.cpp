@@ -0,0 +1,22 @@
+#include "../boxFilter.h"
+#include "benchCommon.h"
+#include <cstdio>
+using namespace cv;
+
+/**
+    Sweep the box filter half-size k from 1 to 64 on a 4K frame (3840x2160)
+    for both normalisation modes. Throughput should stay flat as k grows.
+*/
+int main()
+{
+    Mat image = randomImage(2160, 3840);
+    double mpx = image.rows * (double) image.cols / 1e6;
+
+    printf("k,zero_padding_mpx_s,valid_pixels_mpx_s\n");
+    for (int k = 1; k <= 64; k++) {
+        double tZero = bestTime([&]() { boxFilter(image, k, BOX_NORM_ZERO_PADDING); });
+        double tValid = bestTime([&]() { boxFilter(image, k, BOX_NORM_VALID_PIXELS); });
+        printf("%d,%.1f,%.1f\n", k, mpx / tZero, mpx / tValid);
+    }
+    return 0;
+}
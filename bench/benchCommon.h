@@ -0,0 +1,112 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <opencv2/core.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#endif
+
+/**
+    Random float image with values in [0, 255].
+*/
+inline cv::Mat randomImage(int rows, int cols, unsigned seed = 42)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(0.f, 255.f);
+    cv::Mat res(rows, cols, CV_32FC1);
+    for (int i = 0; i < rows; i++) {
+        float *row = res.ptr<float>(i);
+        for (int j = 0; j < cols; j++) {
+            row[j] = dist(gen);
+        }
+    }
+    return res;
+}
+
+/**
+    Noisy binary mask (CV_32SC1, values 0 or 1): each pixel is set with the
+    given probability.
+*/
+inline cv::Mat randomMask(int rows, int cols, double density, unsigned seed = 42)
+{
+    std::mt19937 gen(seed);
+    std::bernoulli_distribution dist(density);
+    cv::Mat res(rows, cols, CV_32SC1);
+    for (int i = 0; i < rows; i++) {
+        int *row = res.ptr<int>(i);
+        for (int j = 0; j < cols; j++) {
+            row[j] = dist(gen) ? 1 : 0;
+        }
+    }
+    return res;
+}
+
+/**
+    Best wall-clock time in seconds of f over a number of repetitions.
+*/
+template<typename F>
+double bestTime(F f, int repetitions = 3)
+{
+    double best = 1e30;
+    for (int r = 0; r < repetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+/**
+    Time stamp counter (reference cycles at the nominal frequency of the
+    CPU), 0 where there is none.
+*/
+inline uint64_t readCycles()
+{
+#ifdef BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+    Restarts the peak resident set size of the process from its current
+    size (Linux only, elsewhere the peak never goes down).
+*/
+inline void resetPeakRss()
+{
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (f != nullptr) {
+        fputs("5", f);
+        fclose(f);
+    }
+}
+
+/**
+    Peak resident set size of the process in kilobytes since its start or
+    the last resetPeakRss(), -1 if unknown.
+*/
+inline long peakRssKb()
+{
+    long res = -1;
+    FILE *f = fopen("/proc/self/status", "r");
+    if (f != nullptr) {
+        char line[256];
+        while (fgets(line, sizeof(line), f) != nullptr) {
+            if (strncmp(line, "VmHWM:", 6) == 0)
+                res = atol(line + 6);
+        }
+        fclose(f);
+    }
+    return res;
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include "../convolutionEngine.h"
+#include "../morphologyEngine.h"
+#include "../fixedKernels.h"
+#include "benchCommon.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+using namespace cv;
+using namespace std;
+
+/**
+    Throughput of the fixed kernels and elements against the generic paths
+    on the same 1080p frames: the direct and separable convolutions by the
+    same kernel, and the morphology by the same element embedded in a 5x5
+    one, which the fixed elements do not match.
+*/
+template<typename K>
+static Mat kernelOf()
+{
+    Mat res(K::size, K::size, CV_32FC1);
+    for (int t = 0; t < K::taps; t++)
+        res.at<float>(t / K::size, t % K::size) = (float) K::coefficient(t) / (float) K::divisor;
+    return res;
+}
+
+template<typename E>
+static Mat elementOf(int size)
+{
+    Mat res(size, size, CV_32FC1, Scalar(0));
+    int offset = (size - E::size) / 2;
+    for (int t = 0; t < E::taps; t++)
+        res.at<float>(offset + t / E::size, offset + t % E::size) = E::inside(t) ? 1 : 0;
+    return res;
+}
+
+int main()
+{
+    Mat image = randomImage(1080, 1920);
+    double mpx = image.rows * (double) image.cols / 1e6;
+    vector<pair<string, Mat>> kernels = {
+        {"sobel_x", kernelOf<SobelX>()}, {"scharr_x", kernelOf<ScharrX>()},
+        {"laplacian_8", kernelOf<Laplacian8>()}, {"gaussian_3", kernelOf<Gaussian3>()},
+        {"gaussian_5", kernelOf<Gaussian5>()}, {"gaussian_7", kernelOf<Gaussian7>()}};
+    vector<pair<string, pair<Mat, Mat>>> elements = {
+        {"cross_3", {elementOf<Cross3>(3), elementOf<Cross3>(5)}},
+        {"square_3", {elementOf<Square3>(3), elementOf<Square3>(5)}}};
+
+    printf("operator,type,fixed_mpixel_s,direct_mpixel_s,separable_mpixel_s\n");
+    for (int type : {CV_8UC1, CV_16UC1, CV_32FC1}) {
+        Mat input;
+        image.convertTo(input, type);
+        const char *name = type == CV_8UC1 ? "8U" : type == CV_16UC1 ? "16U" : "32F";
+        Mat dst;
+        for (auto &k : kernels) {
+            double fixed = bestTime([&]() { convolve(input, k.second, dst, CONV_FIXED); });
+            double direct = bestTime([&]() { convolve(input, k.second, dst, CONV_DIRECT); });
+            printf("%s,%s,%.1f,%.1f,", k.first.c_str(), name, mpx / fixed, mpx / direct);
+            Mat column, row;
+            if (separableKernel(k.second, column, row))
+                printf("%.1f", mpx / bestTime([&]() { convolve(input, k.second, dst, CONV_SEPARABLE); }));
+            printf("\n");
+        }
+        MorphologyBuffers buffers;
+        for (auto &e : elements) {
+            double fixed = bestTime([&]() { dilateFilter(input, e.second.first, dst, buffers); });
+            double generic = bestTime([&]() { dilateFilter(input, e.second.second, dst, buffers); });
+            printf("dilate_%s,%s,%.1f,%.1f,\n", e.first.c_str(), name, mpx / fixed, mpx / generic);
+        }
+    }
+    return 0;
+}
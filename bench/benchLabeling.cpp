@@ -0,0 +1,40 @@
+#include "../labeling.h"
+#include "benchCommon.h"
+#include "legacyLabeling.h"
+#include <cstdio>
+using namespace cv;
+
+/**
+    Connected component labeling of noisy binary masks, union-find engine
+    (4 and 8 connectivity) against the previous equivalence vector
+    implementation. The latter is quadratic in the number of components and
+    only timed on the smaller masks.
+*/
+int main()
+{
+    const int sizes[] = {128, 256, 512, 1024, 2048};
+    const double densities[] = {0.3, 0.5, 0.7};
+    const double legacyMaxPixels = 256 * 256;
+
+    printf("size,density,components,legacy_ms,union_find_4_ms,union_find_8_ms\n");
+    for (int size : sizes) {
+        for (double density : densities) {
+            Mat mask = randomMask(size, size, density);
+            Mat labels;
+            int components = labelComponents(mask, labels, CONNECTIVITY_4);
+
+            double tLegacy = -1;
+            if (size * (double) size <= legacyMaxPixels)
+                tLegacy = bestTime([&]() { legacy::ccTwoPassLabel(mask); }, 1);
+            double t4 = bestTime([&]() { labelComponents(mask, labels, CONNECTIVITY_4); });
+            double t8 = bestTime([&]() { labelComponents(mask, labels, CONNECTIVITY_8); });
+
+            if (tLegacy >= 0)
+                printf("%d,%.1f,%d,%.2f,%.2f,%.2f\n", size, density, components,
+                       1e3 * tLegacy, 1e3 * t4, 1e3 * t8);
+            else
+                printf("%d,%.1f,%d,,%.2f,%.2f\n", size, density, components, 1e3 * t4, 1e3 * t8);
+        }
+    }
+    return 0;
+}
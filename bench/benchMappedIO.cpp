@@ -0,0 +1,307 @@
+#include "../convolutionEngine.h"
+#include "../mappedImage.h"
+#include "../morphologyEngine.h"
+#include "../rankFilters.h"
+#include "benchCommon.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace cv;
+using namespace std;
+
+/**
+    Round trips through every file layout of MappedImage (the run fails
+    when a pixel differs), files with malformed headers that open() must
+    reject, then the cost of filtering a float scan of
+    size x size pixels (argument, 4096 by default):
+
+    fread        : whole file read into an image, then convolved.
+    mapped       : convolution of a view of the whole mapping, written
+                   into a view of the mapped output file.
+    mapped_bands : same by bands of rows, each band (with its halo) being
+                   prefetched before and evicted after, which bounds the
+                   resident memory.
+*/
+static bool sameImage(const Mat &a, const Mat &b, double tolerance = 0)
+{
+    if (a.size() != b.size() || a.type() != b.type())
+        return false;
+    if (tolerance == 0) {
+        size_t bytes = (size_t) a.cols * a.elemSize();
+        for (int i = 0; i < a.rows; i++) {
+            if (memcmp(a.ptr(i), b.ptr(i), bytes) != 0)
+                return false;
+        }
+        return true;
+    }
+    for (int i = 0; i < a.rows; i++) {
+        for (int j = 0; j < a.cols; j++) {
+            if (fabs(a.at<float>(i, j) - b.at<float>(i, j)) > tolerance)
+                return false;
+        }
+    }
+    return true;
+}
+
+static int failures = 0;
+
+static void check(const char *name, bool ok)
+{
+    if (!ok) {
+        printf("FAILED %s\n", name);
+        failures++;
+    }
+}
+
+static void roundTrip(const char *name, const Mat &image, ImageFileFormat format, Size tileSize = Size())
+{
+    string path = string("mappedIO_") + name;
+    check(name, writeImageFile(path, image, format, tileSize));
+    MappedImage file;
+    bool opened = format == FILE_RAW ? file.openRaw(path, image.rows, image.cols, image.type()) : file.open(path);
+    check(name, opened && file.size() == image.size() && file.type() == image.type());
+    if (opened) {
+        check(name, sameImage(file.read(Rect(0, 0, file.cols(), file.rows())), image));
+        Rect region(image.cols / 3, image.rows / 4, image.cols / 2, image.rows / 2);
+        check(name, sameImage(file.read(region), image(region)));
+        if (file.nativeByteOrder()) {
+            for (int b = 0; b < file.blockCount(); b++)
+                check(name, sameImage(file.block(b), image(file.blockRect(b))));
+            Mat view = file.view(region);
+            check(name, view.empty() == (tileSize.area() > 0) && (view.empty() || sameImage(view, image(region))));
+        }
+    }
+    file.close();
+    remove(path.c_str());
+}
+
+static void putLittle(vector<uchar> &bytes, size_t offset, uint64_t value, int size)
+{
+    if (bytes.size() < offset + size)
+        bytes.resize(offset + size);
+    for (int b = 0; b < size; b++)
+        bytes[offset + b] = (uchar) (value >> (8 * b));
+}
+
+struct TiffEntry {
+    int tag, type;
+    vector<uint64_t> values;
+};
+
+/**
+    Little endian TIFF (or BigTIFF) whose first directory holds entries,
+    the arrays that do not fit in an entry following it, padded with zeros
+    to fileBytes.
+*/
+static vector<uchar> tiffBytes(bool big, const vector<TiffEntry> &entries, size_t fileBytes)
+{
+    vector<uchar> bytes;
+    size_t header = big ? 16 : 8, entrySize = big ? 20 : 12, fieldBytes = big ? 8 : 4;
+    putLittle(bytes, 0, 'I' | 'I' << 8, 2);
+    putLittle(bytes, 2, big ? 43 : 42, 2);
+    if (big) {
+        putLittle(bytes, 4, 8, 2);
+        putLittle(bytes, 8, header, 8);
+    }
+    else {
+        putLittle(bytes, 4, header, 4);
+    }
+    size_t p = header + (big ? 8 : 2);
+    size_t external = p + entries.size() * entrySize + (big ? 8 : 4);
+    putLittle(bytes, header, entries.size(), big ? 8 : 2);
+    for (const TiffEntry &e : entries) {
+        size_t size = e.type == 3 ? 2 : e.type == 4 ? 4 : 8;
+        putLittle(bytes, p, e.tag, 2);
+        putLittle(bytes, p + 2, e.type, 2);
+        putLittle(bytes, p + 4, e.values.size(), big ? 8 : 4);
+        size_t values = p + (big ? 12 : 8);
+        if (e.values.size() * size > fieldBytes) {
+            putLittle(bytes, values, external, (int) fieldBytes);
+            values = external;
+            external += e.values.size() * size;
+        }
+        for (size_t v = 0; v < e.values.size(); v++)
+            putLittle(bytes, values + v * size, e.values[v], (int) size);
+        p += entrySize;
+    }
+    putLittle(bytes, p, 0, big ? 8 : 4);
+    if (bytes.size() < fileBytes)
+        bytes.resize(fileBytes);
+    return bytes;
+}
+
+static void rejected(const char *name, const vector<uchar> &bytes)
+{
+    string path = string("mappedIO_") + name;
+    FILE *f = fopen(path.c_str(), "wb");
+    check(name, f != nullptr && fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size());
+    if (f != nullptr)
+        fclose(f);
+    MappedImage file;
+    check(name, !file.open(path) && !file.isOpen());
+    remove(path.c_str());
+}
+
+static void truncated(const char *name, const Mat &image, ImageFileFormat format, Size tileSize = Size())
+{
+    string path = string("mappedIO_") + name;
+    check(name, writeImageFile(path, image, format, tileSize));
+    struct stat st;
+    check(name, stat(path.c_str(), &st) == 0 && truncate(path.c_str(), st.st_size / 2) == 0);
+    MappedImage file;
+    check(name, !file.open(path) && !file.isOpen());
+    remove(path.c_str());
+}
+
+/**
+    Headers whose sizes or offsets, taken at face value, point outside of
+    the file or overflow the size computations.
+*/
+static void malformedHeaders(const Mat &image)
+{
+    truncated("truncated_pgm", image, FILE_PNM);
+    truncated("truncated_tiff_strips", image, FILE_TIFF);
+    truncated("truncated_tiff_tiles", image, FILE_TIFF, Size(32, 32));
+
+    string pgm = "P5\n4294967297 1\n255\n ";
+    rejected("huge_pgm_width", vector<uchar>(pgm.begin(), pgm.end()));
+    pgm = "P5\n1 99999999999\n255\n ";
+    rejected("huge_pgm_height", vector<uchar>(pgm.begin(), pgm.end()));
+
+    // 2^30 x 2^30 pixels of 4 doubles: the end of the strip wraps to 0 mod 2^64
+    rejected("huge_tiff", tiffBytes(false, {{256, 4, {1u << 30}}, {257, 4, {1u << 30}}, {258, 3, {64, 64, 64, 64}},
+                                            {273, 4, {8}}, {277, 3, {4}}, {339, 3, {3, 3, 3, 3}}}, 100));
+    rejected("huge_tile", tiffBytes(true, {{256, 4, {1u << 30}}, {257, 4, {1}}, {322, 16, {1ull << 31}},
+                                           {323, 4, {16}}, {324, 4, {4096}}}, 8192));
+    rejected("tile_count", tiffBytes(false, {{256, 4, {64}}, {257, 4, {64}}, {258, 3, {8}}, {322, 4, {16}},
+                                             {323, 4, {16}}, {324, 4, vector<uint64_t>(15, 4096)}}, 8192));
+    rejected("strip_count", tiffBytes(false, {{256, 4, {64}}, {257, 4, {64}}, {258, 3, {8}}, {273, 4, {4096, 5120}},
+                                              {278, 4, {16}}}, 8192));
+
+    vector<uchar> bytes = tiffBytes(true, {{256, 4, {16}}}, 0);
+    putLittle(bytes, 8, ~0ull - 3, 8); // first directory at 2^64 - 4
+    rejected("wrapping_directory", bytes);
+    bytes = tiffBytes(true, {{256, 16, {16, 16}}}, 0);
+    putLittle(bytes, 16 + 8 + 12, ~0ull - 3, 8); // array of the entry at 2^64 - 4
+    rejected("wrapping_values", bytes);
+}
+
+template<typename T>
+static Mat scaled(const Mat &noise, int type, double scale)
+{
+    Mat res(noise.rows, noise.cols, type);
+    int channels = res.channels();
+    for (int i = 0; i < res.rows; i++) {
+        T *row = res.ptr<T>(i);
+        for (int j = 0; j < res.cols * channels; j++)
+            row[j] = (T) (noise.at<float>(i, (j / channels + j % channels * 7) % noise.cols) * scale);
+    }
+    return res;
+}
+
+/**
+    The filters take views of a mapping as any other image.
+*/
+static void filtersOnViews(const Mat &image)
+{
+    check("filters_write", writeImageFile("mappedIO_filters", image, FILE_TIFF));
+    MappedImage file;
+    check("filters_open", file.open("mappedIO_filters"));
+    Mat view = file.view(), copy = file.read(Rect(0, 0, file.cols(), file.rows()));
+    Mat kernel(3, 3, CV_32FC1, Scalar(1.0f / 9));
+    Mat element(5, 5, CV_32FC1, Scalar(1));
+    check("filters_convolve", sameImage(convolve(view, kernel), convolve(copy, kernel)));
+    check("filters_median", sameImage(medianFilter(view, 5), medianFilter(copy, 5)));
+    check("filters_dilate", sameImage(dilateFilter(view, element), dilateFilter(copy, element)));
+    file.close();
+    remove("mappedIO_filters");
+}
+
+int main(int argc, char **argv)
+{
+    int size = argc > 1 ? atoi(argv[1]) : 4096;
+    Mat noise = randomImage(203, 317);
+    roundTrip("raw_32f", noise, FILE_RAW);
+    roundTrip("pgm_8u", scaled<uchar>(noise, CV_8UC1, 1), FILE_PNM);
+    roundTrip("pgm_16u", scaled<ushort>(noise, CV_16UC1, 257), FILE_PNM);
+    roundTrip("ppm_8u", scaled<uchar>(noise, CV_8UC3, 1), FILE_PNM);
+    roundTrip("tiff_strips_32f", noise, FILE_TIFF);
+    roundTrip("tiff_strips_16u_c3", scaled<ushort>(noise, CV_MAKETYPE(CV_16U, 3), 257), FILE_TIFF);
+    roundTrip("tiff_tiles_8u", scaled<uchar>(noise, CV_8UC1, 1), FILE_TIFF, Size(64, 32));
+    roundTrip("tiff_tiles_16u", scaled<ushort>(noise, CV_16UC1, 257), FILE_TIFF, Size(48, 48));
+    roundTrip("tiff_tiles_32f_c4", scaled<float>(noise, CV_MAKETYPE(CV_32F, 4), 1), FILE_TIFF, Size(16, 128));
+    roundTrip("tiff_strips_64f", scaled<double>(noise, CV_64FC1, 0.5), FILE_TIFF);
+    filtersOnViews(scaled<uchar>(noise, CV_8UC1, 1));
+    malformedHeaders(scaled<uchar>(noise, CV_8UC1, 1));
+
+    // 5x5 binomial kernel, forced separable so that bands give the same sums
+    float binomial[] = {1, 4, 6, 4, 1};
+    Mat kernel(5, 5, CV_32FC1);
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 5; j++)
+            kernel.at<float>(i, j) = binomial[i] * binomial[j] / 256;
+    }
+    int radius = kernel.rows / 2, bandRows = 256;
+
+    check("scan_write", writeImageFile("mappedIO_scan", randomImage(size, size), FILE_RAW));
+    printf("mode,size,ms,peak_rss_mb\n");
+    Mat reference;
+    {
+        resetPeakRss();
+        auto start = chrono::steady_clock::now();
+        Mat image(size, size, CV_32FC1);
+        FILE *f = fopen("mappedIO_scan", "rb");
+        size_t got = 0;
+        if (f != nullptr) {
+            got = fread(image.ptr(), sizeof(float), (size_t) size * size, f);
+            fclose(f);
+        }
+        check("scan_fread", got == (size_t) size * size);
+        convolve(image, kernel, reference, CONV_SEPARABLE);
+        double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("fread,%d,%.1f,%.1f\n", size, t * 1e3, peakRssKb() / 1024.0);
+    }
+    {
+        resetPeakRss();
+        auto start = chrono::steady_clock::now();
+        MappedImage input, output;
+        check("scan_open", input.openRaw("mappedIO_scan", size, size, CV_32FC1));
+        check("scan_create", output.create("mappedIO_out", FILE_RAW, size, size, CV_32FC1));
+        input.advise(MAPPED_SEQUENTIAL);
+        Mat dst = output.view();
+        convolve(input.view(), kernel, dst, CONV_SEPARABLE);
+        output.flush();
+        double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("mapped,%d,%.1f,%.1f\n", size, t * 1e3, peakRssKb() / 1024.0);
+        check("scan_mapped", sameImage(output.view(), reference, 1e-3));
+    }
+    {
+        resetPeakRss();
+        auto start = chrono::steady_clock::now();
+        MappedImage input, output;
+        check("scan_open", input.openRaw("mappedIO_scan", size, size, CV_32FC1));
+        check("scan_create", output.create("mappedIO_out", FILE_RAW, size, size, CV_32FC1));
+        Mat band;
+        for (int y = 0; y < size; y += bandRows) {
+            int rows = min(bandRows, size - y);
+            int top = max(0, y - radius), bottom = min(size, y + rows + radius);
+            Rect halo(0, top, size, bottom - top);
+            if (y + bandRows < size)
+                input.prefetch(Rect(0, y + bandRows, size, min(bandRows, size - y - bandRows)));
+            convolve(input.view(halo), kernel, band, CONV_SEPARABLE);
+            output.write(band.rowRange(y - top, y - top + rows), Point(0, y));
+            input.evict(Rect(0, top, size, max(0, y + rows - radius - top)));
+            output.evict(Rect(0, y, size, rows));
+        }
+        double t = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("mapped_bands,%d,%.1f,%.1f\n", size, t * 1e3, peakRssKb() / 1024.0);
+        check("scan_bands", sameImage(output.view(), reference, 1e-3));
+    }
+    remove("mappedIO_scan");
+    remove("mappedIO_out");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include "../tpConvolution.h"
+#include "../tpGeometry.h"
+#include "../tpMorphology.h"
+#include "../tpConnectedComponents.h"
+#include "benchCommon.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+using namespace cv;
+using namespace std;
+
+/**
+    Sweep of the operators of the four tp modules over the image size, the
+    kernel / structuring element size, the pixel type and the foreground
+    density of the masks given to the connected component functions.
+
+    For each case: throughput in Mpixel/s and time stamp counter cycles per
+    pixel of the best of 3 runs, and peak resident set size of the process
+    while the case runs (input included). The first argument caps the image
+    size (2048 by default).
+*/
+
+static const char *typeName(int type)
+{
+    switch (type) {
+    case CV_8UC1:
+        return "8U";
+    case CV_16UC1:
+        return "16U";
+    case CV_32SC1:
+        return "32S";
+    default:
+        return "32F";
+    }
+}
+
+static Mat converted(const Mat &image, int type)
+{
+    if (image.type() == type)
+        return image;
+    Mat res;
+    image.convertTo(res, type);
+    return res;
+}
+
+static Mat gaussianKernel(int k)
+{
+    double sigma = max(1, k) / 2.0;
+    Mat kernel(2 * k + 1, 2 * k + 1, CV_32FC1);
+    double sum = 0;
+    for (int m = -k; m <= k; m++) {
+        for (int n = -k; n <= k; n++)
+            sum += exp(-(m * m + n * n) / (2 * sigma * sigma));
+    }
+    for (int m = -k; m <= k; m++) {
+        for (int n = -k; n <= k; n++)
+            kernel.at<float>(m + k, n + k) = (float) (exp(-(m * m + n * n) / (2 * sigma * sigma)) / sum);
+    }
+    return kernel;
+}
+
+static void report(const char *op, int type, int size, int param, double density, const function<void()> &f)
+{
+    double pixels = (double) size * size;
+    uint64_t bestCycles = 0;
+    resetPeakRss();
+    f(); // warm-up (thread pool, scratch buffers)
+    double t = bestTime([&]() {
+        uint64_t start = readCycles();
+        f();
+        uint64_t cycles = readCycles() - start;
+        if (bestCycles == 0 || cycles < bestCycles)
+            bestCycles = cycles;
+    });
+    long rss = peakRssKb();
+
+    printf("%s,%s,%d,%d,", op, typeName(type), size, param);
+    if (density >= 0)
+        printf("%.2f,", density);
+    else
+        printf(",");
+    printf("%.1f,", pixels / t * 1e-6);
+    if (bestCycles > 0)
+        printf("%.2f,", bestCycles / pixels);
+    else
+        printf(",");
+    if (rss >= 0)
+        printf("%.1f\n", rss / 1024.0);
+    else
+        printf("\n");
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    int maxSize = argc > 1 ? atoi(argv[1]) : 2048;
+    const int sizes[] = {256, 512, 1024, 2048};
+    const int halfSizes[] = {1, 2, 4, 7};   // windows of 3, 5, 9 and 15 pixels
+    const double densities[] = {0.3, 0.5, 0.7};
+
+    printf("operator,type,size,kernel,density,mpixel_s,cycles_per_pixel,peak_rss_mb\n");
+    for (int size : sizes) {
+        if (size > maxSize)
+            break;
+        Mat image = randomImage(size, size);
+
+        for (int k : halfSizes) {
+            int side = 2 * k + 1;
+            Mat kernel = gaussianKernel(k);
+            Mat element(side, side, CV_32FC1, Scalar(1));
+
+            for (int type : {CV_8UC1, CV_16UC1, CV_32FC1}) {
+                Mat input = converted(image, type);
+                report("meanFilter", type, size, side, -1, [&]() { meanFilter(input, k); });
+                report("convolution", type, size, side, -1, [&]() { convolution(input, kernel); });
+            }
+            if (k <= 2)
+                report("bilateralFilter", CV_32FC1, size, side, -1, [&]() { bilateralFilter(image, kernel, 20); });
+            for (int type : {CV_8UC1, CV_16UC1, CV_32FC1}) {
+                Mat input = converted(image, type);
+                report("median", type, size, side, -1, [&]() { median(input, k); });
+                report("erode", type, size, side, -1, [&]() { erode(input, element); });
+                report("dilate", type, size, side, -1, [&]() { dilate(input, element); });
+                report("open", type, size, side, -1, [&]() { open(input, element); });
+                report("close", type, size, side, -1, [&]() { close(input, element); });
+                report("morphologicalGradient", type, size, side, -1,
+                       [&]() { morphologicalGradient(input, element); });
+            }
+        }
+
+        for (int type : {CV_8UC1, CV_16UC1, CV_32FC1}) {
+            Mat input = converted(image, type);
+            report("edgeSobel", type, size, 3, -1, [&]() { edgeSobel(input); });
+            report("transpose", type, size, 0, -1, [&]() { transpose(input); });
+            report("expand_2", type, size, 0, -1, [&]() { expand(input, 2, interpolate_bilinear); });
+        }
+        report("rotate_30", CV_32FC1, size, 0, -1, [&]() { rotate(image, 30, interpolate_bilinear); });
+        report("rotate_90", CV_32FC1, size, 0, -1, [&]() { rotate(image, 90, interpolate_bilinear); });
+
+        for (double density : densities) {
+            Mat mask = randomMask(size, size, density);
+            Mat mask8 = converted(mask, CV_8UC1);
+            report("ccLabel", CV_32SC1, size, 0, density, [&]() { ccLabel(mask); });
+            report("ccLabel", CV_8UC1, size, 0, density, [&]() { ccLabel(mask8); });
+            report("ccTwoPassLabel", CV_32SC1, size, 0, density, [&]() { ccTwoPassLabel(mask); });
+            report("ccTwoPassLabel", CV_8UC1, size, 0, density, [&]() { ccTwoPassLabel(mask8); });
+            report("ccAreaFilter", CV_32SC1, size, 10, density, [&]() { ccAreaFilter(mask, 10); });
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include "../labeling.h"
+#include "../parallel.h"
+#include "benchCommon.h"
+#include <cstdio>
+#include <cstdlib>
+using namespace cv;
+
+/**
+    Scaling of the strip parallel labeling from 1 to 64 threads on noisy
+    16k x 16k masks (the size can be given as first argument), 4 and 8
+    connectivity, against the sequential labelComponents.
+*/
+int main(int argc, char **argv)
+{
+    int size = argc > 1 ? atoi(argv[1]) : 16384;
+    const int threads[] = {1, 2, 4, 8, 16, 32, 64};
+    const double densities[] = {0.3, 0.5};
+    double mpx = size * (double) size / 1e6;
+
+    printf("density,connectivity,threads,components,sequential_mpx_s,parallel_mpx_s,speedup\n");
+    for (double density : densities) {
+        Mat mask = randomMask(size, size, density);
+        Mat labels;
+        for (Connectivity connectivity : {CONNECTIVITY_4, CONNECTIVITY_8}) {
+            int components = labelComponents(mask, labels, connectivity);
+            double tSeq = bestTime([&]() { labelComponents(mask, labels, connectivity); }, 1);
+            for (int n : threads) {
+                setNumThreads(n);
+                double tPar = bestTime([&]() { labelComponentsParallel(mask, labels, connectivity); });
+                printf("%.1f,%d,%d,%d,%.1f,%.1f,%.2f\n", density, (int) connectivity, n,
+                       components, mpx / tSeq, mpx / tPar, tSeq / tPar);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include "../pipeline.h"
+#include "../convolutionEngine.h"
+#include "../morphologyEngine.h"
+#include "benchCommon.h"
+#include <cstdio>
+using namespace cv;
+
+/**
+    blur -> Sobel -> threshold -> close on a 4K frame, one whole-image
+    operator after the other against the fused tile by tile pipeline.
+*/
+int main()
+{
+    Mat image = randomImage(2160, 3840);
+    Mat gauss(5, 5, CV_32FC1);
+    const float binomial[5] = {1, 4, 6, 4, 1};
+    for (int m = 0; m < 5; m++) {
+        for (int n = 0; n < 5; n++)
+            gauss.at<float>(m, n) = binomial[m] * binomial[n] / 256;
+    }
+    Mat element(3, 3, CV_32FC1, Scalar(1));
+
+    double separate = bestTime([&]() {
+        Mat edges = sobelEdges(convolve(image, gauss, CONV_DIRECT));
+        for (int i = 0; i < edges.rows; i++) {
+            float *row = edges.ptr<float>(i);
+            for (int j = 0; j < edges.cols; j++)
+                row[j] = row[j] > 100 ? 1.0f : 0.0f;
+        }
+        closeFilter(edges, element);
+    });
+
+    Pipeline pipeline;
+    Pipeline::Node edges = pipeline.threshold(pipeline.sobel(pipeline.convolve(pipeline.input(), gauss)), 100);
+    Pipeline::Node closed = pipeline.close(edges, element);
+    double fused = bestTime([&]() { pipeline.run(image, closed); });
+
+    printf("method,ms\n");
+    printf("separate_operators,%.1f\n", separate * 1e3);
+    printf("fused_pipeline,%.1f\n", fused * 1e3);
+    return 0;
+}
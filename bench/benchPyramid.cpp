@@ -0,0 +1,52 @@
+#include "../pyramid.h"
+#include "../convolutionEngine.h"
+#include "benchCommon.h"
+#include <cmath>
+#include <cstdio>
+using namespace cv;
+
+/**
+    Gaussian pyramid and scale space of a 4K frame, against the same scales
+    obtained by convolving the full resolution image by gaussians of
+    sigma 2^k (what coarse-to-fine code did on top of convolve).
+*/
+static Mat gaussianKernel(double sigma) {
+    int radius = (int) ceil(3 * sigma);
+    Mat kernel(2 * radius + 1, 2 * radius + 1, CV_32FC1);
+    double sum = 0;
+    for (int m = -radius; m <= radius; m++) {
+        for (int n = -radius; n <= radius; n++)
+            sum += exp(-(m * m + n * n) / (2 * sigma * sigma));
+    }
+    for (int m = -radius; m <= radius; m++) {
+        for (int n = -radius; n <= radius; n++)
+            kernel.at<float>(m + radius, n + radius) = (float) (exp(-(m * m + n * n) / (2 * sigma * sigma)) / sum);
+    }
+    return kernel;
+}
+
+int main()
+{
+    Mat image = randomImage(2160, 3840);
+    const int levels = 5;
+
+    double full = bestTime([&]() {
+        for (int k = 1; k < levels; k++)
+            convolve(image, gaussianKernel(pow(2.0, k)), CONV_AUTO, PAD_REFLECT);
+    }, 1);
+    double pyramid = bestTime([&]() { GaussianPyramid(image, levels); });
+    double lazyTop = bestTime([&]() {
+        GaussianPyramid lazy(image, levels, true);
+        lazy.level(levels - 1);
+    });
+    double laplacian = bestTime([&]() { laplacianPyramid(image, levels); });
+    double scaleSpace = bestTime([&]() { ScaleSpace(image, levels - 1); }, 1);
+
+    printf("method,ms\n");
+    printf("full_resolution_convolutions,%.1f\n", full * 1e3);
+    printf("gaussian_pyramid,%.1f\n", pyramid * 1e3);
+    printf("lazy_top_level,%.1f\n", lazyTop * 1e3);
+    printf("laplacian_pyramid,%.1f\n", laplacian * 1e3);
+    printf("scale_space_%d_octaves,%.1f\n", levels - 1, scaleSpace * 1e3);
+    return 0;
+}
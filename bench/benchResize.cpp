@@ -0,0 +1,29 @@
+#include "../resize.h"
+#include "benchCommon.h"
+#include <cstdio>
+using namespace cv;
+
+/**
+    Thumbnail and pyramid style resizes of a 4K frame, float and 8-bit,
+    for each filter (plans come from the cache after the first call).
+*/
+int main()
+{
+    Mat image = randomImage(2160, 3840);
+    Mat bytes;
+    image.convertTo(bytes, CV_8UC1);
+    const Size sizes[] = {Size(1920, 1080), Size(960, 540), Size(256, 144), Size(7680, 4320)};
+    const char *names[] = {"nearest", "area", "bilinear", "bicubic", "lanczos3"};
+    double mpx = image.rows * (double) image.cols / 1e6;
+
+    printf("filter,dst,f32_src_mpx_s,u8_src_mpx_s\n");
+    for (int f = RESIZE_NEAREST; f <= RESIZE_LANCZOS3; f++) {
+        for (Size size : sizes) {
+            ResizeFilter filter = (ResizeFilter) f;
+            double tf = bestTime([&]() { resize(image, size, filter); });
+            double tu = bestTime([&]() { resize(bytes, size, filter); });
+            printf("%s,%dx%d,%.1f,%.1f\n", names[f], size.width, size.height, mpx / tf, mpx / tu);
+        }
+    }
+    return 0;
+}
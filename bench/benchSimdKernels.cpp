@@ -0,0 +1,30 @@
+#include "../convolutionEngine.h"
+#include "../simdKernels.h"
+#include "benchCommon.h"
+#include <cstdio>
+using namespace cv;
+
+/**
+    Throughput of the direct convolution and of the fused Sobel for each
+    instruction set, on float and 8-bit 1080p frames.
+*/
+int main()
+{
+    Mat image = randomImage(1080, 1920);
+    Mat bytes;
+    image.convertTo(bytes, CV_8UC1);
+    Mat kernel = randomImage(5, 5);
+    double mpx = image.rows * (double) image.cols / 1e6;
+    const char *names[] = {"scalar", "sse4.1", "avx2"};
+
+    printf("simd,conv5x5_f32,conv5x5_u8,sobel_f32,sobel_u8 (Mpixel/s)\n");
+    for (int level = SIMD_SCALAR; level <= detectSimdLevel(); level++) {
+        setSimdLevel((SimdLevel) level);
+        double t0 = bestTime([&]() { convolve(image, kernel, CONV_DIRECT); });
+        double t1 = bestTime([&]() { convolve(bytes, kernel, CONV_DIRECT); });
+        double t2 = bestTime([&]() { sobelEdges(image); });
+        double t3 = bestTime([&]() { sobelEdges(bytes); });
+        printf("%s,%.1f,%.1f,%.1f,%.1f\n", names[level], mpx / t0, mpx / t1, mpx / t2, mpx / t3);
+    }
+    return 0;
+}
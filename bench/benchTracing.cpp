@@ -0,0 +1,59 @@
+#include "../tpConvolution.h"
+#include "../tpGeometry.h"
+#include "../tpMorphology.h"
+#include "../tpConnectedComponents.h"
+#include "../trace.h"
+#include "benchCommon.h"
+#include <cstdio>
+using namespace cv;
+
+/**
+    Cost of the tracing layer on small images, where the diagnostics the
+    operators used to print dominated: the same calls with tracing off
+    (the default) and on, then the counters and the size of the exported
+    Chrome trace of one call of each.
+*/
+int main()
+{
+    Mat image = randomImage(64, 64);
+    Mat mask = randomMask(64, 64, 0.5);
+    Mat kernel(3, 3, CV_32FC1, Scalar(1.0 / 9));
+    Mat element(3, 3, CV_32FC1, Scalar(1));
+    const int calls = 200;
+
+    auto run = [&]() {
+        for (int c = 0; c < calls; c++) {
+            meanFilter(image, 1);
+            convolution(image, kernel);
+            edgeSobel(image);
+            dilate(image, element);
+            rotate(image, 30, interpolate_bilinear);
+            ccLabel(mask);
+            ccTwoPassLabel(mask);
+        }
+    };
+
+    setTracing(false);
+    double off = bestTime(run);
+    setTracing(true);
+    double on = bestTime(run);
+    clearTrace();
+
+    setTracing(true);
+    meanFilter(image, 1);
+    edgeSobel(image);
+    ccLabel(mask);
+    ccTwoPassLabel(mask);
+    setTracing(false);
+
+    printf("tracing,us_per_call\n");
+    printf("off,%.2f\n", off / (7.0 * calls) * 1e6);
+    printf("on,%.2f\n", on / (7.0 * calls) * 1e6);
+    printf("\ncounter,value\n");
+    printf("pixels,%lld\n", (long long) traceCounter(TRACE_PIXELS));
+    printf("components,%lld\n", (long long) traceCounter(TRACE_COMPONENTS));
+    printf("merges,%lld\n", (long long) traceCounter(TRACE_MERGES));
+    printf("allocations,%lld\n", (long long) traceCounter(TRACE_ALLOCATIONS));
+    printf("trace_bytes,%zu\n", traceJson().size());
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include "../transposeEngine.h"
+#include "benchCommon.h"
+#include <cstdio>
+using namespace cv;
+
+/**
+    Transpose of 8, 16 and 32-bit images against the naive element by element
+    copy, plus the in-place transpose and a quarter turn.
+*/
+template<typename T>
+static void naiveTranspose(const Mat &image, Mat &res) {
+    res.create(image.cols, image.rows, image.type());
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++)
+            res.at<T>(j, i) = image.at<T>(i, j);
+    }
+}
+
+int main()
+{
+    Mat image = randomImage(4096, 4096);
+    Mat images[3];
+    image.convertTo(images[0], CV_8UC1);
+    image.convertTo(images[1], CV_16UC1);
+    images[2] = image;
+    const char *names[] = {"u8", "u16", "f32"};
+    double mpx = image.rows * (double) image.cols / 1e6;
+
+    printf("type,naive_mpx_s,blocked_mpx_s,in_place_mpx_s,quarter_turn_mpx_s\n");
+    for (int t = 0; t < 3; t++) {
+        Mat res, copy = images[t].clone();
+        double tn = bestTime([&]() {
+            if (t == 0) naiveTranspose<uchar>(images[t], res);
+            else if (t == 1) naiveTranspose<ushort>(images[t], res);
+            else naiveTranspose<float>(images[t], res);
+        });
+        double tb = bestTime([&]() { transposeImage(images[t], res); });
+        double ti = bestTime([&]() { transposeInPlace(copy); });
+        double tq = bestTime([&]() { rotateQuarterTurns(images[t], 1); });
+        printf("%s,%.1f,%.1f,%.1f,%.1f\n", names[t], mpx / tn, mpx / tb, mpx / ti, mpx / tq);
+    }
+    return 0;
+}
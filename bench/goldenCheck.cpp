@@ -0,0 +1,1315 @@
+#include "../tpConvolution.h"
+#include "../tpGeometry.h"
+#include "../tpMorphology.h"
+#include "../tpConnectedComponents.h"
+#include "../parallel.h"
+#include "../simdKernels.h"
+#include "../convolutionEngine.h"
+#include "../boxFilter.h"
+#include "../fixedKernels.h"
+#include "../bilateral.h"
+#include "../rankFilters.h"
+#include "../morphologyEngine.h"
+#include "../pipeline.h"
+#include "../interpolation.h"
+#include "../resize.h"
+#include "../transposeEngine.h"
+#include "../pyramid.h"
+#include "baselineOperators.h"
+#include "benchCommon.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+using namespace cv;
+using namespace std;
+
+/**
+    Golden output check of the operators of the four tp modules.
+
+    Each operator is run on fixed inputs (odd sizes, so that borders, tiles
+    and SIMD tails are all exercised) at every SIMD level of the machine,
+    with one thread and with the whole pool, and its output is compared to:
+     - the baseline implementation of the operator (baselineOperators.h),
+       for the float images it took: outputs only differ where the change
+       is documented, and then match the documented behaviour;
+     - a naive reference written from the specification of the operator
+       (direct loops, zero padding, no tiling, no SIMD), for the input
+       types the baseline did not take;
+     - with --compare DIR, the outputs recorded by --record DIR, e.g. by the
+       build of the current reference implementations before an optimised
+       path replaces them.
+    Labels are compared up to a renumbering of the components.
+
+    Prints one line per failure and exits with 1 if there is any.
+*/
+
+static int failures = 0;
+static bool recording = false, comparing = false;
+static string goldenDir;
+static bool firstConfiguration = true;
+static string configuration;
+
+static double value(const Mat &image, int i, int j)
+{
+    switch (image.depth()) {
+    case CV_8U:
+        return image.at<uchar>(i, j);
+    case CV_16U:
+        return image.at<ushort>(i, j);
+    case CV_32S:
+        return image.at<int>(i, j);
+    default:
+        return image.at<float>(i, j);
+    }
+}
+
+static void fail(const string &name, const string &message)
+{
+    failures++;
+    fprintf(stderr, "FAILED %s [%s]: %s\n", name.c_str(), configuration.c_str(), message.c_str());
+}
+
+/**
+    Largest difference between a and b, +inf if their sizes differ.
+    Infinities of the same sign are equal.
+*/
+static double maxDifference(const Mat &a, const Mat &b)
+{
+    if (a.rows != b.rows || a.cols != b.cols)
+        return numeric_limits<double>::infinity();
+    double res = 0;
+    for (int i = 0; i < a.rows; i++) {
+        for (int j = 0; j < a.cols; j++) {
+            double u = value(a, i, j), v = value(b, i, j);
+            if (u != v)
+                res = max(res, std::isinf(u) || std::isinf(v) ? numeric_limits<double>::infinity() : fabs(u - v));
+        }
+    }
+    return res;
+}
+
+/********************************************
+              RECORDED GOLDENS
+*********************************************/
+
+static bool writeGolden(const string &path, const Mat &image)
+{
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+    int header[3] = {image.rows, image.cols, image.type()};
+    fwrite(header, sizeof(int), 3, f);
+    for (int i = 0; i < image.rows; i++)
+        fwrite(image.ptr(i), image.elemSize(), image.cols, f);
+    fclose(f);
+    return true;
+}
+
+static bool readGolden(const string &path, Mat &image)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == nullptr)
+        return false;
+    int header[3];
+    bool ok = fread(header, sizeof(int), 3, f) == 3;
+    if (ok) {
+        image.create(header[0], header[1], header[2]);
+        for (int i = 0; ok && i < image.rows; i++)
+            ok = fread(image.ptr(i), image.elemSize(), image.cols, f) == (size_t) image.cols;
+    }
+    fclose(f);
+    return ok;
+}
+
+/**
+    Records result under name, or compares it to the recorded one.
+    compare(recorded) returns an error message, empty when they match.
+*/
+template<typename Compare>
+static void golden(const string &name, const Mat &result, Compare compare)
+{
+    string path = goldenDir + "/" + name + ".mat";
+    if (recording && firstConfiguration) {
+        if (!writeGolden(path, result))
+            fail(name, "cannot write " + path);
+    } else if (comparing) {
+        Mat recorded;
+        if (!readGolden(path, recorded)) {
+            fail(name, "cannot read " + path);
+            return;
+        }
+        string message = compare(recorded);
+        if (!message.empty())
+            fail(name, "recorded golden: " + message);
+    }
+}
+
+/********************************************
+                 COMPARISONS
+*********************************************/
+
+static void expectClose(const string &name, const Mat &result, const Mat &expected, double tolerance)
+{
+    auto compare = [&](const Mat &reference) {
+        double d = maxDifference(result, reference);
+        if (d <= tolerance)
+            return string();
+        char message[128];
+        snprintf(message, sizeof(message), "max difference %g (tolerance %g)", d, tolerance);
+        return string(message);
+    };
+    string message = compare(expected);
+    if (!message.empty())
+        fail(name, message);
+    golden(name, result, compare);
+}
+
+/**
+    Same non zero pixels, and a one to one map between the labels of both.
+*/
+static string partitionDifference(const Mat &labels, const Mat &expected)
+{
+    if (labels.rows != expected.rows || labels.cols != expected.cols)
+        return "sizes differ";
+    map<int, int> forward, backward;
+    for (int i = 0; i < labels.rows; i++) {
+        for (int j = 0; j < labels.cols; j++) {
+            int a = (int) value(labels, i, j), b = (int) value(expected, i, j);
+            if ((a == 0) != (b == 0))
+                return "different background at (" + to_string(i) + ", " + to_string(j) + ")";
+            if (a == 0)
+                continue;
+            auto f = forward.emplace(a, b).first;
+            auto g = backward.emplace(b, a).first;
+            if (f->second != b || g->second != a)
+                return "different components at (" + to_string(i) + ", " + to_string(j) + ")";
+        }
+    }
+    return string();
+}
+
+/**
+    Same size, type and bytes (for the types value does not read, e.g. 64-bit
+    pixels).
+*/
+static void expectIdentical(const string &name, const Mat &result, const Mat &expected)
+{
+    if (result.rows != expected.rows || result.cols != expected.cols || result.type() != expected.type()) {
+        fail(name, "sizes or types differ");
+        return;
+    }
+    size_t rowBytes = (size_t) result.cols * result.elemSize();
+    for (int i = 0; i < result.rows; i++) {
+        if (memcmp(result.ptr(i), expected.ptr(i), rowBytes) != 0) {
+            fail(name, "different bytes in row " + to_string(i));
+            return;
+        }
+    }
+}
+
+static void expectSamePartition(const string &name, const Mat &labels, const Mat &expected)
+{
+    string message = partitionDifference(labels, expected);
+    if (!message.empty())
+        fail(name, message);
+    golden(name, labels, [&](const Mat &recorded) { return partitionDifference(labels, recorded); });
+}
+
+/**
+    NaN exactly where image is NaN, and elsewhere a value within the range
+    of the other pixels of image (a convex combination of them).
+*/
+static void expectNaNKept(const string &name, const Mat &result, const Mat &image)
+{
+    if (result.rows != image.rows || result.cols != image.cols) {
+        fail(name, "sizes differ");
+        return;
+    }
+    float minVal = numeric_limits<float>::infinity(), maxVal = -minVal;
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++) {
+            float v = image.at<float>(i, j);
+            if (!std::isnan(v)) {
+                minVal = min(minVal, v);
+                maxVal = max(maxVal, v);
+            }
+        }
+    }
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++) {
+            float u = result.at<float>(i, j);
+            bool expectedNaN = std::isnan(image.at<float>(i, j));
+            if (std::isnan(u) != expectedNaN || (!expectedNaN && (u < minVal || u > maxVal))) {
+                fail(name, "value " + to_string(u) + " at (" + to_string(i) + ", " + to_string(j) + ")");
+                return;
+            }
+        }
+    }
+}
+
+/********************************************
+             NAIVE REFERENCES
+*********************************************/
+
+static bool inside(const Mat &image, int i, int j)
+{
+    return i >= 0 && j >= 0 && i < image.rows && j < image.cols;
+}
+
+static Mat referenceCorrelation(const Mat &image, const Mat &kernel)
+{
+    int ky = kernel.rows / 2, kx = kernel.cols / 2;
+    Mat res(image.rows, image.cols, CV_32FC1);
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++) {
+            double sum = 0;
+            for (int m = -ky; m <= ky; m++) {
+                for (int n = -kx; n <= kx; n++) {
+                    if (inside(image, i + m, j + n))
+                        sum += value(image, i + m, j + n) * kernel.at<float>(m + ky, n + kx);
+                }
+            }
+            res.at<float>(i, j) = (float) sum;
+        }
+    }
+    return res;
+}
+
+static Mat referenceMean(const Mat &image, int k)
+{
+    Mat kernel(2 * k + 1, 2 * k + 1, CV_32FC1, Scalar(1.0 / ((2 * k + 1) * (2 * k + 1))));
+    return referenceCorrelation(image, kernel);
+}
+
+static Mat referenceSobel(const Mat &image)
+{
+    Mat dx = (Mat_<float>(3, 3) << -1, 0, 1, -2, 0, 2, -1, 0, 1);
+    Mat dy = (Mat_<float>(3, 3) << -1, -2, -1, 0, 0, 0, 1, 2, 1);
+    Mat gx = referenceCorrelation(image, dx), gy = referenceCorrelation(image, dy);
+    Mat res(image.rows, image.cols, CV_32FC1);
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++)
+            res.at<float>(i, j) = fabs(gx.at<float>(i, j)) + fabs(gy.at<float>(i, j));
+    }
+    return res;
+}
+
+static Mat referenceBilateral(const Mat &image, const Mat &kernel, double sigma_r)
+{
+    int ky = kernel.rows / 2, kx = kernel.cols / 2;
+    Mat res(image.rows, image.cols, CV_32FC1);
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++) {
+            double center = value(image, i, j), sum = 0, weights = 0;
+            for (int m = -ky; m <= ky; m++) {
+                for (int n = -kx; n <= kx; n++) {
+                    if (!inside(image, i + m, j + n))
+                        continue;
+                    double v = value(image, i + m, j + n);
+                    double w = kernel.at<float>(m + ky, n + kx) * exp(-(v - center) * (v - center) / (2 * sigma_r * sigma_r));
+                    sum += w * v;
+                    weights += w;
+                }
+            }
+            res.at<float>(i, j) = (float) (weights > 0 ? sum / weights : 0);
+        }
+    }
+    return res;
+}
+
+static Mat referenceMedian(const Mat &image, int k, PaddingMode padding = PAD_ZERO)
+{
+    Mat res(image.rows, image.cols, CV_32FC1);
+    vector<double> window;
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++) {
+            window.clear();
+            for (int m = -k; m <= k; m++) {
+                for (int n = -k; n <= k; n++) {
+                    int y = borderIndex(i + m, image.rows, padding), x = borderIndex(j + n, image.cols, padding);
+                    if (y >= 0 && x >= 0)
+                        window.push_back(value(image, y, x));
+                }
+            }
+            sort(window.begin(), window.end());
+            size_t s = window.size();
+            res.at<float>(i, j) = (float) (s % 2 == 1 ? window[s / 2] : (window[s / 2 - 1] + window[s / 2]) / 2);
+        }
+    }
+    return res;
+}
+
+/**
+    Maximum (dilation) or minimum of the samples under the non zero pixels of
+    the structuring element, samples outside of the image being ignored.
+*/
+static Mat referenceRank(const Mat &image, const Mat &element, bool dilation)
+{
+    int ky = element.rows / 2, kx = element.cols / 2;
+    double empty = dilation ? -numeric_limits<double>::infinity() : numeric_limits<double>::infinity();
+    Mat res(image.rows, image.cols, CV_32FC1);
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++) {
+            double v = empty;
+            for (int m = -ky; m <= ky; m++) {
+                for (int n = -kx; n <= kx; n++) {
+                    if (element.at<float>(m + ky, n + kx) == 0 || !inside(image, i + m, j + n))
+                        continue;
+                    double s = value(image, i + m, j + n);
+                    v = dilation ? max(v, s) : min(v, s);
+                }
+            }
+            res.at<float>(i, j) = (float) v;
+        }
+    }
+    return res;
+}
+
+static Mat referenceDifference(const Mat &a, const Mat &b)
+{
+    Mat res(a.rows, a.cols, CV_32FC1);
+    for (int i = 0; i < a.rows; i++) {
+        for (int j = 0; j < a.cols; j++)
+            res.at<float>(i, j) = a.at<float>(i, j) - b.at<float>(i, j);
+    }
+    return res;
+}
+
+static Mat referenceThreshold(const Mat &image, float threshold)
+{
+    Mat res(image.rows, image.cols, CV_32FC1);
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++)
+            res.at<float>(i, j) = image.at<float>(i, j) > threshold ? 1.0f : 0.0f;
+    }
+    return res;
+}
+
+static Mat referenceTranspose(const Mat &image)
+{
+    Mat res(image.cols, image.rows, image.type());
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++)
+            memcpy(res.ptr(j) + i * image.elemSize(), image.ptr(i) + j * image.elemSize(), image.elemSize());
+    }
+    return res;
+}
+
+/**
+    5-tap binomial blur (1 4 6 4 1) / 16 of image read with padding, at the
+    even rows and columns only.
+*/
+static Mat referencePyramidDown(const Mat &image, PaddingMode padding)
+{
+    const double binomial[5] = {1 / 16.0, 4 / 16.0, 6 / 16.0, 4 / 16.0, 1 / 16.0};
+    Mat res((image.rows + 1) / 2, (image.cols + 1) / 2, CV_32FC1);
+    for (int i = 0; i < res.rows; i++) {
+        for (int j = 0; j < res.cols; j++) {
+            double sum = 0;
+            for (int m = 0; m < 5; m++) {
+                int y = borderIndex(2 * i + m - 2, image.rows, padding);
+                for (int n = 0; n < 5; n++) {
+                    int x = borderIndex(2 * j + n - 2, image.cols, padding);
+                    if (y >= 0 && x >= 0)
+                        sum += binomial[m] * binomial[n] * value(image, y, x);
+                }
+            }
+            res.at<float>(i, j) = (float) sum;
+        }
+    }
+    return res;
+}
+
+/**
+    Image of the given type with random bytes, so that every bit of a pixel
+    is checked whatever its size.
+*/
+static Mat randomBytes(int rows, int cols, int type, unsigned seed)
+{
+    mt19937 gen(seed);
+    Mat res(rows, cols, type);
+    size_t rowBytes = (size_t) cols * res.elemSize();
+    for (int i = 0; i < rows; i++) {
+        uchar *row = res.ptr(i);
+        for (size_t b = 0; b < rowBytes; b++)
+            row[b] = (uchar) gen();
+    }
+    return res;
+}
+
+static Mat referenceFlip(const Mat &image, FlipMode mode)
+{
+    Mat res(image.rows, image.cols, image.type());
+    size_t elemSize = image.elemSize();
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++) {
+            int si = mode == FLIP_HORIZONTAL ? i : image.rows - 1 - i;
+            int sj = mode == FLIP_VERTICAL ? j : image.cols - 1 - j;
+            memcpy(res.ptr(i) + j * elemSize, image.ptr(si) + sj * elemSize, elemSize);
+        }
+    }
+    return res;
+}
+
+/**
+    One quarter turn of any type, dst(i, j) = src(j, cols-1-i).
+*/
+static Mat referenceTurn(const Mat &image)
+{
+    Mat res(image.cols, image.rows, image.type());
+    size_t elemSize = image.elemSize();
+    for (int i = 0; i < res.rows; i++) {
+        for (int j = 0; j < res.cols; j++)
+            memcpy(res.ptr(i) + j * elemSize, image.ptr(j) + (image.cols - 1 - i) * elemSize, elemSize);
+    }
+    return res;
+}
+
+/**
+    One clockwise quarter turn about the center.
+*/
+static Mat referenceQuarterTurn(const Mat &image)
+{
+    Mat res(image.cols, image.rows, CV_32FC1);
+    for (int i = 0; i < res.rows; i++) {
+        for (int j = 0; j < res.cols; j++)
+            res.at<float>(i, j) = (float) value(image, j, image.cols - 1 - i);
+    }
+    return res;
+}
+
+/**
+    Bilinear interpolation at (x, y), x being the row, positions clamped to
+    the image (the generic function pointer path of expand and rotate).
+*/
+static float referenceBilinear(Mat image, float x, float y)
+{
+    x = min(max(x, 0.f), (float) (image.rows - 1));
+    y = min(max(y, 0.f), (float) (image.cols - 1));
+    int i = min((int) x, image.rows - 2 < 0 ? 0 : image.rows - 2);
+    int j = min((int) y, image.cols - 2 < 0 ? 0 : image.cols - 2);
+    int i1 = min(i + 1, image.rows - 1), j1 = min(j + 1, image.cols - 1);
+    float a = x - i, b = y - j;
+    return (1 - a) * (1 - b) * image.at<float>(i, j) + (1 - a) * b * image.at<float>(i, j1)
+         + a * (1 - b) * image.at<float>(i1, j) + a * b * image.at<float>(i1, j1);
+}
+
+/**
+    Image read at (x, y) in double precision: coordinates clamped to the
+    image, neighbours replicated past the first and last rows and columns,
+    Keys (a = -0.5) and normalised Lanczos-3 weights from their formulas.
+*/
+static double referenceInterpolate(const Mat &image, double x, double y, Interpolation interpolation)
+{
+    x = min(max(x, 0.0), image.cols - 1.0);
+    y = min(max(y, 0.0), image.rows - 1.0);
+    if (interpolation == INTERP_NEAREST)
+        return value(image, (int) (y + 0.5), (int) (x + 0.5));
+
+    auto weight = [&](double d) {
+        d = fabs(d);
+        if (interpolation == INTERP_BILINEAR)
+            return max(0.0, 1 - d);
+        if (interpolation == INTERP_BICUBIC) {
+            const double a = -0.5;
+            if (d <= 1)
+                return ((a + 2) * d - (a + 3)) * d * d + 1;
+            return d < 2 ? ((a * d - 5 * a) * d + 8 * a) * d - 4 * a : 0.0;
+        }
+        if (d == 0)
+            return 1.0;
+        return d < 3 ? 3 * sin(M_PI * d) * sin(M_PI * d / 3) / (M_PI * M_PI * d * d) : 0.0;
+    };
+    int taps = interpolation == INTERP_BILINEAR ? 2 : interpolation == INTERP_BICUBIC ? 4 : 6;
+    int first = 1 - taps / 2;
+    int j0 = (int) x, i0 = (int) y;
+    double sum = 0, norm = 0;
+    for (int r = 0; r < taps; r++) {
+        int i = min(max(i0 + first + r, 0), image.rows - 1);
+        for (int c = 0; c < taps; c++) {
+            int j = min(max(j0 + first + c, 0), image.cols - 1);
+            double w = weight(y - (i0 + first + r)) * weight(x - (j0 + first + c));
+            sum += w * value(image, i, j);
+            norm += w;
+        }
+    }
+    return sum / norm;
+}
+
+static Mat referenceExpand(const Mat &image, int factor)
+{
+    Mat res((image.rows - 1) * factor, (image.cols - 1) * factor, CV_32FC1);
+    for (int i = 0; i < res.rows; i++) {
+        for (int j = 0; j < res.cols; j++)
+            res.at<float>(i, j) = referenceBilinear(image, (float) i / factor, (float) j / factor);
+    }
+    return res;
+}
+
+/**
+    4 connected components of the non zero pixels (sameValue = false) or of
+    the flat zones, by breadth first search.
+*/
+static Mat referenceLabels(const Mat &image, bool sameValue)
+{
+    Mat res(image.rows, image.cols, CV_32SC1, Scalar(0));
+    vector<Point2i> queue;
+    int count = 0;
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++) {
+            if (value(image, i, j) == 0 || res.at<int>(i, j) != 0)
+                continue;
+            double v = value(image, i, j);
+            res.at<int>(i, j) = ++count;
+            queue.assign(1, Point2i(j, i));
+            for (size_t q = 0; q < queue.size(); q++) {
+                const int di[4] = {-1, 1, 0, 0}, dj[4] = {0, 0, -1, 1};
+                for (int d = 0; d < 4; d++) {
+                    int y = queue[q].y + di[d], x = queue[q].x + dj[d];
+                    if (!inside(image, y, x) || res.at<int>(y, x) != 0 || value(image, y, x) == 0)
+                        continue;
+                    if (sameValue && value(image, y, x) != v)
+                        continue;
+                    res.at<int>(y, x) = count;
+                    queue.push_back(Point2i(x, y));
+                }
+            }
+        }
+    }
+    return res;
+}
+
+static Mat referenceAreaFilter(const Mat &image, int size)
+{
+    Mat labels = referenceLabels(image, true);
+    map<int, int> area;
+    for (int i = 0; i < labels.rows; i++) {
+        for (int j = 0; j < labels.cols; j++)
+            area[labels.at<int>(i, j)]++;
+    }
+    Mat res = image.clone();
+    for (int i = 0; i < labels.rows; i++) {
+        for (int j = 0; j < labels.cols; j++) {
+            if (labels.at<int>(i, j) != 0 && area[labels.at<int>(i, j)] < size)
+                res.at<int>(i, j) = 0;
+        }
+    }
+    return res;
+}
+
+/********************************************
+                  CHECKS
+*********************************************/
+
+static Mat converted(const Mat &image, int type)
+{
+    Mat res;
+    image.convertTo(res, type);
+    return res;
+}
+
+static Mat rounded(const Mat &image, double scale)
+{
+    Mat res(image.rows, image.cols, CV_32FC1);
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++)
+            res.at<float>(i, j) = (float) floor(image.at<float>(i, j) * scale);
+    }
+    return res;
+}
+
+/**
+    Float image rounded to nearest and saturated to an 8-bit or 16-bit type.
+*/
+static Mat saturated(const Mat &image, int type)
+{
+    Mat res(image.rows, image.cols, type);
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++) {
+            if (type == CV_8UC1)
+                res.at<uchar>(i, j) = saturate_cast<uchar>(image.at<float>(i, j));
+            else
+                res.at<ushort>(i, j) = saturate_cast<ushort>(image.at<float>(i, j));
+        }
+    }
+    return res;
+}
+
+template<typename K>
+static Mat fixedKernel()
+{
+    Mat res(K::size, K::size, CV_32FC1);
+    for (int t = 0; t < K::taps; t++)
+        res.at<float>(t / K::size, t % K::size) = (float) K::coefficient(t) / (float) K::divisor;
+    return res;
+}
+
+static void checkAll(const Size &size)
+{
+    string tag = to_string(size.height) + "x" + to_string(size.width);
+    Mat image = randomImage(size.height, size.width, 7);
+    Mat bytes = rounded(image, 1);          // integer valued, 8-bit range
+    Mat words = rounded(image, 200);        // integer valued, 16-bit range
+
+    Mat gauss(5, 5, CV_32FC1);
+    const float binomial[5] = {1, 4, 6, 4, 1};
+    for (int m = 0; m < 5; m++) {
+        for (int n = 0; n < 5; n++)
+            gauss.at<float>(m, n) = binomial[m] * binomial[n] / 256;
+    }
+    Mat skewed = (Mat_<float>(3, 3) << 0, 1, 2, -1, 0.5f, 3, 0.25f, -2, 1);
+    Mat square(3, 3, CV_32FC1, Scalar(1));
+    Mat cross = (Mat_<float>(5, 5) << 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0);
+    Mat cross3 = (Mat_<float>(3, 3) << 0, 1, 0, 1, 1, 1, 0, 1, 0);
+    Mat line(1, 7, CV_32FC1, Scalar(1));
+
+    // values are in [0, 255]: the tolerances cover float sums taken in
+    // another order, the coefficient tables of expand and the range table
+    // of the bilateral filter; 16-bit inputs go up to 51000 and integer
+    // outputs may round a sum that lands on .5 the other way
+
+    // convolution module
+    for (int k : {1, 3})
+        expectClose("meanFilter_" + to_string(k) + "_" + tag, meanFilter(image, k), referenceMean(image, k), 1e-3);
+    expectClose("convolution_gauss_" + tag, convolution(image, gauss), referenceCorrelation(image, gauss), 1e-3);
+    expectClose("convolution_skewed_" + tag, convolution(image, skewed), referenceCorrelation(image, skewed), 1e-3);
+    for (int k : {1, 3}) {
+        string suffix = to_string(k) + "_" + tag;
+        expectClose("meanFilter_8u_" + suffix, meanFilter(converted(bytes, CV_8UC1), k), referenceMean(bytes, k), 1e-3);
+        expectClose("meanFilter_16u_" + suffix, meanFilter(converted(words, CV_16UC1), k), referenceMean(words, k), 1e-1);
+        expectClose("boxFilter_to_8u_" + suffix, boxFilter(converted(bytes, CV_8UC1), k, BOX_NORM_ZERO_PADDING, CV_8U),
+                    saturated(referenceMean(bytes, k), CV_8UC1), 1);
+    }
+    expectClose("convolution_8u_" + tag, convolution(converted(bytes, CV_8UC1), gauss),
+                referenceCorrelation(bytes, gauss), 1e-3);
+    expectClose("convolution_16u_" + tag, convolution(converted(words, CV_16UC1), gauss),
+                referenceCorrelation(words, gauss), 1e-1);
+    for (int depth : {CV_8U, CV_16U}) {
+        Mat input = converted(depth == CV_8U ? bytes : words, CV_MAKETYPE(depth, 1));
+        Mat expected = saturated(referenceCorrelation(depth == CV_8U ? bytes : words, skewed), CV_MAKETYPE(depth, 1));
+        for (ConvolutionStrategy strategy : {CONV_DIRECT, CONV_FFT})
+            expectClose("convolve_to_" + to_string(depth) + "_" + to_string(strategy) + "_" + tag,
+                        convolve(input, skewed, strategy, PAD_ZERO, depth), expected, 1);
+    }
+    vector<pair<string, Mat>> fixedKernels = {
+        {"sobel_y", fixedKernel<SobelY>()}, {"scharr_x", fixedKernel<ScharrX>()},
+        {"laplacian_4", fixedKernel<Laplacian4>()}, {"gaussian_3", fixedKernel<Gaussian3>()},
+        {"gaussian_7", fixedKernel<Gaussian7>()}};
+    for (auto &k : fixedKernels) {
+        string suffix = k.first + "_" + tag;
+        expectClose("convolve_fixed_" + suffix, convolve(image, k.second, CONV_FIXED), referenceCorrelation(image, k.second), 1e-3);
+        expectClose("convolve_fixed_8u_" + suffix, convolve(converted(bytes, CV_8UC1), k.second, CONV_FIXED),
+                    referenceCorrelation(bytes, k.second), 1e-3);
+        expectClose("convolve_fixed_16u_" + suffix, convolve(converted(words, CV_16UC1), k.second, CONV_FIXED),
+                    referenceCorrelation(words, k.second), 1e-1);
+        expectClose("convolve_fixed_to_8u_" + suffix,
+                    convolve(converted(bytes, CV_8UC1), k.second, CONV_FIXED, PAD_ZERO, CV_8U),
+                    saturated(referenceCorrelation(bytes, k.second), CV_8UC1), 1);
+        expectClose("convolve_fixed_reflect_" + suffix, convolve(image, k.second, CONV_FIXED, PAD_REFLECT),
+                    convolve(image, k.second, CONV_DIRECT, PAD_REFLECT), 1e-3);
+    }
+    expectClose("edgeSobel_" + tag, edgeSobel(image), referenceSobel(image), 1e-3);
+    expectClose("edgeSobel_8u_" + tag, edgeSobel(converted(bytes, CV_8UC1)), referenceSobel(bytes), 0);
+    expectClose("edgeSobel_16u_" + tag, edgeSobel(converted(words, CV_16UC1)), referenceSobel(words), 0);
+    expectClose("bilateralFilter_" + tag, bilateralFilter(image, gauss, 30), referenceBilateral(image, gauss, 30), 5e-2);
+    Mat holes = image.clone();
+    for (int i = 0; i < holes.rows; i += 5) {
+        for (int j = i % 3; j < holes.cols; j += 7)
+            holes.at<float>(i, j) = numeric_limits<float>::quiet_NaN();
+    }
+    for (BilateralMode mode : {BILATERAL_LUT, BILATERAL_GRID})
+        expectNaNKept("bilateral_nan_" + to_string(mode) + "_" + tag, bilateral(holes, gauss, 30, PAD_ZERO, mode), holes);
+
+    // morphology module
+    for (int k : {1, 2}) {
+        string suffix = to_string(k) + "_" + tag;
+        expectClose("median_float_" + suffix, median(image, k), referenceMedian(image, k), 0);
+        expectClose("median_bytes_" + suffix, median(bytes, k), referenceMedian(bytes, k), 0);
+        expectClose("median_words_" + suffix, median(words, k), referenceMedian(words, k), 0);
+        expectClose("median_8u_" + suffix, median(converted(bytes, CV_8UC1), k), referenceMedian(bytes, k), 0);
+        for (PaddingMode padding : {PAD_REPLICATE, PAD_REFLECT})
+            expectClose("medianFilter_float_" + to_string(padding) + "_" + suffix, medianFilter(image, k, padding),
+                        referenceMedian(image, k, padding), 0);
+    }
+    vector<pair<string, Mat>> elements = {{"square", square}, {"cross", cross}, {"cross3", cross3}, {"line", line}};
+    for (auto &e : elements) {
+        string suffix = e.first + "_" + tag;
+        Mat dilated = referenceRank(image, e.second, true), eroded = referenceRank(image, e.second, false);
+        expectClose("dilate_" + suffix, dilate(image, e.second), dilated, 0);
+        expectClose("erode_" + suffix, erode(image, e.second), eroded, 0);
+        expectClose("open_" + suffix, open(image, e.second), referenceRank(eroded, e.second, true), 0);
+        expectClose("close_" + suffix, close(image, e.second), referenceRank(dilated, e.second, false), 0);
+        expectClose("morphologicalGradient_" + suffix, morphologicalGradient(image, e.second),
+                    referenceDifference(dilated, eroded), 0);
+        for (int type : {CV_8UC1, CV_16UC1}) {
+            Mat integer = type == CV_8UC1 ? bytes : words;
+            Mat input = converted(integer, type);
+            string typed = to_string(type) + "_" + suffix;
+            Mat integerDilated = referenceRank(integer, e.second, true);
+            Mat integerEroded = referenceRank(integer, e.second, false);
+            expectClose("dilate_" + typed, dilate(input, e.second), integerDilated, 0);
+            expectClose("erode_" + typed, erode(input, e.second), integerEroded, 0);
+            expectClose("open_" + typed, open(input, e.second), referenceRank(integerEroded, e.second, true), 0);
+            expectClose("morphologicalGradient_" + typed, morphologicalGradient(input, e.second),
+                        referenceDifference(integerDilated, integerEroded), 0);
+        }
+    }
+
+    // geometry module
+    for (int type : {CV_8UC1, CV_16UC1, CV_32FC1}) {
+        Mat input = converted(words, type);
+        expectClose("transpose_" + to_string(type) + "_" + tag, transpose(input), referenceTranspose(input), 0);
+    }
+    expectClose("expand_3_" + tag, expand(image, 3, interpolate_bilinear), referenceExpand(image, 3), 1e-2);
+    expectClose("expand_generic_3_" + tag, expand(image, 3, referenceBilinear), referenceExpand(image, 3), 1e-3);
+    expectClose("expand_16u_3_" + tag, expand(converted(words, CV_16UC1), 3, interpolate_bilinear),
+                saturated(referenceExpand(words, 3), CV_16UC1), 1);
+
+    // connected components module
+    for (double density : {0.3, 0.6}) {
+        string suffix = to_string((int) (density * 10)) + "_" + tag;
+        Mat mask = randomMask(size.height, size.width, density, 11);
+        Mat expected = referenceLabels(mask, false);
+        expectSamePartition("ccLabel_" + suffix, ccLabel(mask), expected);
+        expectSamePartition("ccLabel_8u_" + suffix, ccLabel(converted(mask, CV_8UC1)), expected);
+        expectSamePartition("ccLabel_16u_" + suffix, ccLabel(converted(mask, CV_16UC1)), expected);
+        expectSamePartition("ccTwoPassLabel_" + suffix, ccTwoPassLabel(mask), expected);
+        expectSamePartition("ccTwoPassLabel_8u_" + suffix, ccTwoPassLabel(converted(mask, CV_8UC1)), expected);
+
+        Mat zones = mask.clone();
+        for (int i = 0; i < zones.rows; i++) {
+            for (int j = 0; j < zones.cols; j++)
+                zones.at<int>(i, j) *= 1 + (i / 8 + j / 8) % 3;
+        }
+        expectClose("ccAreaFilter_" + suffix, ccAreaFilter(zones, 4), referenceAreaFilter(zones, 4), 0);
+    }
+}
+
+/**
+    Batch interpolators (interpolation.h) at sample points covering the
+    interior, integer coordinates, the last row and column and points
+    outside of the image (clamped):
+     - interpolate on float and 8-bit images against the double precision
+       reference, within the float rounding of the weights;
+     - the AVX2 gathers (nearest, bilinear, bicubic) bit identical to the
+       scalar kernels;
+     - interpolateFixed against the same reference: exact on integer
+       coordinates, elsewhere within the quantisation of the coordinates to
+       1/32 pixel and of the weights to Q14 on 8-bit noise: 4 levels for
+       bilinear, 8 for bicubic and Lanczos-3, whose negative lobes amplify
+       the shift of up to 1/64 pixel (4 and 6 levels measured).
+*/
+static void checkInterpolation(const Size &size)
+{
+    string tag = to_string(size.height) + "x" + to_string(size.width);
+    Mat image = randomImage(size.height, size.width, 7);
+    Mat bytes = rounded(image, 1);
+    Mat bytes8 = converted(bytes, CV_8UC1);
+    float maxX = (float) (size.width - 1), maxY = (float) (size.height - 1);
+
+    // a grid of the special coordinates, then random and integer points
+    vector<float> xs, ys, integerXs, integerYs;
+    vector<float> specialX = {-3.7f, -0.5f, 0, 0.25f, 1, maxX - 1, maxX - 0.5f, maxX - 0.01f, maxX, maxX + 0.3f, maxX + 2.2f};
+    vector<float> specialY = {-3.7f, -0.5f, 0, 0.25f, 1, maxY - 1, maxY - 0.5f, maxY - 0.01f, maxY, maxY + 0.3f, maxY + 2.2f};
+    for (float y : specialY) {
+        for (float x : specialX) {
+            xs.push_back(x);
+            ys.push_back(y);
+        }
+    }
+    mt19937 gen(3);
+    uniform_real_distribution<float> randomX(-2, maxX + 2), randomY(-2, maxY + 2);
+    for (int k = 0; k < 1001; k++) {
+        xs.push_back(randomX(gen));
+        ys.push_back(randomY(gen));
+        integerXs.push_back(floor(randomX(gen)));
+        integerYs.push_back(floor(randomY(gen)));
+    }
+
+    auto reference = [&](const Mat &values, const vector<float> &x, const vector<float> &y, Interpolation interpolation) {
+        Mat res(1, (int) x.size(), CV_32FC1);
+        for (size_t k = 0; k < x.size(); k++)
+            res.at<float>(0, (int) k) = (float) referenceInterpolate(values, x[k], y[k], interpolation);
+        return res;
+    };
+    auto batch = [&](const Mat &input, const vector<float> &x, const vector<float> &y, Interpolation interpolation) {
+        Mat res(1, (int) x.size(), CV_32FC1);
+        interpolate(input, x.data(), y.data(), (int) x.size(), res.ptr<float>(0), interpolation);
+        return res;
+    };
+    auto fixed = [&](const vector<float> &x, const vector<float> &y, Interpolation interpolation) {
+        Mat res(1, (int) x.size(), CV_8UC1);
+        interpolateFixed(bytes8, x.data(), y.data(), (int) x.size(), res.ptr<uchar>(0), interpolation);
+        return res;
+    };
+
+    const Interpolation kernels[] = {INTERP_NEAREST, INTERP_BILINEAR, INTERP_BICUBIC, INTERP_LANCZOS3};
+    const double tolerance[] = {0, 1e-3, 1e-3, 1e-3};
+    const double fixedTolerance[] = {0, 4, 8, 8};
+    for (Interpolation interpolation : kernels) {
+        string suffix = to_string(interpolation) + "_" + tag;
+        Mat expected = reference(image, xs, ys, interpolation);
+        Mat result = batch(image, xs, ys, interpolation);
+        expectClose("interpolate_" + suffix, result, expected, tolerance[interpolation]);
+        expectClose("interpolate_integer_" + suffix, batch(image, integerXs, integerYs, interpolation),
+                    reference(image, integerXs, integerYs, interpolation), 0);
+        expectClose("interpolate_8u_" + suffix, batch(bytes8, xs, ys, interpolation),
+                    reference(bytes, xs, ys, interpolation), tolerance[interpolation]);
+
+        SimdLevel level = simdLevel();
+        setSimdLevel(SIMD_SCALAR);
+        Mat scalar = batch(image, xs, ys, interpolation);
+        setSimdLevel(level);
+        if (interpolation != INTERP_LANCZOS3)
+            expectClose("interpolate_simd_" + suffix, result, scalar, 0);
+
+        expectClose("interpolateFixed_" + suffix, fixed(xs, ys, interpolation),
+                    saturated(reference(bytes, xs, ys, interpolation), CV_8UC1), fixedTolerance[interpolation]);
+        expectClose("interpolateFixed_integer_" + suffix, fixed(integerXs, integerYs, interpolation),
+                    converted(reference(bytes, integerXs, integerYs, interpolation), CV_8UC1), 0);
+    }
+}
+
+/**
+    Resize filters (resize.h) through properties that hold whatever the
+    rounding of the weights:
+     - a constant image stays constant, for every filter and pixel type,
+       upscaling and downscaling;
+     - a 2x RESIZE_AREA downscale is the mean of the 2x2 blocks;
+     - resizing to the size of the image returns the image;
+     - 8-bit bicubic and Lanczos-3 results are the float results (which
+       overshoot [0, 255] on a step) rounded and saturated;
+     - downscaling antialiases: every source pixel has a weight, and a 4x
+       downscale of noise at least halves its standard deviation;
+     - a plan rebuilt after its eviction from the cache gives the same
+       result as the cached one.
+*/
+static void checkResize(const Size &size)
+{
+    string tag = to_string(size.height) + "x" + to_string(size.width);
+    Mat image = randomImage(size.height, size.width, 7);
+    const ResizeFilter filters[] = {RESIZE_NEAREST, RESIZE_AREA, RESIZE_BILINEAR, RESIZE_BICUBIC, RESIZE_LANCZOS3};
+    const Size targets[] = {Size(size.width * 2 + 1, size.height * 3 / 2), Size(size.width / 3, size.height / 2 + 1)};
+
+    for (ResizeFilter filter : filters) {
+        string suffix = to_string(filter) + "_" + tag;
+        for (int type : {CV_8UC1, CV_16UC1, CV_32FC1}) {
+            Mat flat(size.height, size.width, type, Scalar(type == CV_32FC1 ? 100.25 : 100));
+            for (const Size &target : targets) {
+                string name = "resize_constant_" + to_string(type) + "_" + to_string(target.width) + "_" + suffix;
+                expectClose(name, resize(flat, target, filter), Mat(target.height, target.width, type, Scalar(type == CV_32FC1 ? 100.25 : 100)),
+                            type == CV_32FC1 ? 1e-3 : 0);
+            }
+        }
+        expectClose("resize_identity_" + suffix, resize(image, size, filter), image, 0);
+    }
+
+    Size even(size.width / 2 * 2, size.height / 2 * 2);
+    Mat cropped = image(Rect(0, 0, even.width, even.height));
+    Mat blocks(even.height / 2, even.width / 2, CV_32FC1);
+    for (int i = 0; i < blocks.rows; i++) {
+        for (int j = 0; j < blocks.cols; j++) {
+            blocks.at<float>(i, j) = (cropped.at<float>(2 * i, 2 * j) + cropped.at<float>(2 * i, 2 * j + 1)
+                                      + cropped.at<float>(2 * i + 1, 2 * j) + cropped.at<float>(2 * i + 1, 2 * j + 1)) / 4;
+        }
+    }
+    expectClose("resize_area_half_" + tag, resize(cropped, blocks.size(), RESIZE_AREA), blocks, 1e-3);
+
+    // vertical step from 0 to 255: the kernels with negative lobes ring on both sides
+    Mat step(size.height, size.width, CV_32FC1, Scalar(0));
+    step(Rect(0, 0, size.width, size.height / 2)).setTo(255);
+    Mat step8 = converted(step, CV_8UC1);
+    for (ResizeFilter filter : {RESIZE_BICUBIC, RESIZE_LANCZOS3}) {
+        string name = "resize_saturate_" + to_string(filter) + "_" + tag;
+        Size target(size.width * 2 + 1, size.height * 3);
+        Mat floating = resize(step, target, filter);
+        double lowest = 0, highest = 255;
+        for (int i = 0; i < floating.rows; i++) {
+            lowest = min(lowest, (double) floating.at<float>(i, 0));
+            highest = max(highest, (double) floating.at<float>(i, 0));
+        }
+        if (lowest >= 0 || highest <= 255)
+            fail(name, "no overshoot to saturate");
+        expectClose(name, resize(step8, target, filter), saturated(floating, CV_8UC1), 1);
+    }
+
+    Size quarter(size.width / 4, size.height / 4);
+    auto deviation = [](const Mat &m) {
+        double sum = 0, sum2 = 0;
+        for (int i = 0; i < m.rows; i++) {
+            for (int j = 0; j < m.cols; j++) {
+                sum += m.at<float>(i, j);
+                sum2 += m.at<float>(i, j) * (double) m.at<float>(i, j);
+            }
+        }
+        double n = (double) m.total();
+        return sqrt(max(0.0, sum2 / n - (sum / n) * (sum / n)));
+    };
+    for (ResizeFilter filter : {RESIZE_AREA, RESIZE_BILINEAR, RESIZE_BICUBIC, RESIZE_LANCZOS3}) {
+        string name = "resize_antialias_" + to_string(filter) + "_" + tag;
+        shared_ptr<const ResizePlan> plan = resizePlan(size, quarter, filter);
+        for (const ResizeAxis *axis : {&plan->horizontal, &plan->vertical}) {
+            int sourceLength = axis == &plan->horizontal ? size.width : size.height;
+            vector<bool> covered(sourceLength, false);
+            for (size_t k = 0; k < axis->first.size(); k++) {
+                for (int t = 0; t < axis->count[k]; t++)
+                    covered[axis->first[k] + t] = covered[axis->first[k] + t] || axis->weights[k * axis->taps + t] != 0;
+            }
+            if (find(covered.begin(), covered.end(), false) != covered.end())
+                fail(name, "a source pixel has no weight");
+        }
+        double before = deviation(image), after = deviation(resize(image, *plan));
+        if (after > before / 2)
+            fail(name, "standard deviation " + to_string(after) + " of " + to_string(before));
+    }
+
+    Size target(size.width * 3 / 2, size.height * 3 / 2);
+    for (ResizeFilter filter : filters) {
+        string name = "resize_cache_" + to_string(filter) + "_" + tag;
+        shared_ptr<const ResizePlan> cached = resizePlan(size, target, filter);
+        if (resizePlan(size, target, filter) != cached)
+            fail(name, "plan not reused");
+        Mat expected = resize(image, *cached);
+        // more plans than the cache holds, the next request builds a new plan
+        for (int w = 1; w <= 20; w++)
+            resizePlan(size, Size(w, w), filter);
+        shared_ptr<const ResizePlan> rebuilt = resizePlan(size, target, filter);
+        if (rebuilt == cached)
+            fail(name, "plan not evicted");
+        expectClose(name, resize(image, *rebuilt), expected, 0);
+        expectClose(name + "_by_size", resize(image, target, filter), expected, 0);
+    }
+}
+
+/**
+    Pipeline::run against the whole-image operators of each stage, for float
+    and 8-bit inputs under the paddings the pipeline takes. 517 columns are
+    cut in a full and a partial tile and the rows in several tiles, so that
+    the halos cross both tile edges and image borders. Chains of windowed
+    stages (sobel of a blur, gradient of a blur) check that the halos grow
+    along the chain.
+*/
+static void checkPipeline(const Size &size)
+{
+    string tag = to_string(size.height) + "x" + to_string(size.width);
+    Mat image = randomImage(size.height, size.width, 7);
+    Mat bytes = rounded(image, 1);
+    Mat gauss(5, 5, CV_32FC1);
+    const float binomial[5] = {1, 4, 6, 4, 1};
+    for (int m = 0; m < 5; m++) {
+        for (int n = 0; n < 5; n++)
+            gauss.at<float>(m, n) = binomial[m] * binomial[n] / 256;
+    }
+    Mat box(5, 5, CV_32FC1, Scalar(1.0 / 25));
+    Mat square(3, 3, CV_32FC1, Scalar(1));
+    Mat cross = (Mat_<float>(5, 5) << 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0);
+    vector<pair<string, Mat>> elements = {{"square", square}, {"cross", cross}};
+
+    for (PaddingMode padding : {PAD_ZERO, PAD_REPLICATE, PAD_REFLECT}) {
+        for (bool eightBit : {false, true}) {
+            Mat values = eightBit ? bytes : image;  // float image of the input values
+            Mat input = eightBit ? converted(bytes, CV_8UC1) : image;
+            string suffix = to_string(padding) + (eightBit ? "_8u_" : "_") + tag;
+            auto expectRun = [&](const string &name, const Pipeline &p, Pipeline::Node node,
+                                 const Mat &expected, double tolerance) {
+                expectClose("pipeline_" + name + "_" + suffix, p.run(input, node), expected, tolerance);
+            };
+
+            Pipeline p(padding);
+            Mat blurred = convolve(values, gauss, CONV_DIRECT, padding);
+            expectRun("convolve", p, p.convolve(p.input(), gauss), blurred, 1e-3);
+            expectRun("mean", p, p.mean(p.input(), 2), convolve(values, box, CONV_DIRECT, padding), 1e-3);
+            expectRun("sobel", p, p.sobel(p.input()), sobelEdges(values, padding), 1e-3);
+            expectRun("sobel_convolve", p, p.sobel(p.convolve(p.input(), gauss)), sobelEdges(blurred, padding), 1e-2);
+            expectRun("subtract", p, p.subtract(p.convolve(p.input(), gauss), p.input()),
+                      referenceDifference(blurred, values), 1e-3);
+            for (auto &e : elements) {
+                string name = e.first;
+                Mat dilated = dilateFilter(values, e.second, padding);
+                expectRun("threshold_" + name, p, p.threshold(p.dilate(p.input(), e.second), 100),
+                          referenceThreshold(dilated, 100), 0);
+                expectRun("erode_" + name, p, p.erode(p.input(), e.second), erodeFilter(values, e.second, padding), 0);
+                expectRun("open_" + name, p, p.open(p.input(), e.second), openFilter(values, e.second, padding), 0);
+                expectRun("close_" + name, p, p.close(p.input(), e.second), closeFilter(values, e.second, padding), 0);
+                expectRun("gradient_" + name, p, p.gradient(p.input(), e.second),
+                          gradientFilter(values, e.second, padding), 0);
+                expectRun("gradient_convolve_" + name, p, p.gradient(p.convolve(p.input(), gauss), e.second),
+                          gradientFilter(blurred, e.second, padding), 1e-3);
+            }
+        }
+    }
+}
+
+/**
+    Float operators against the baseline implementations (baselineOperators.h)
+    on the same inputs. The documented changes of behaviour are checked as
+    such:
+     - morphologicalGradient returns dilate - erode, where the baseline
+       computed -(erode + dilate);
+     - rotate by a multiple of 90 degrees is an exact quarter turn / flip of
+       size rows x cols or cols x rows (see tpGeometry.h), the baseline
+       truncated the size and resampled.
+    Expand and rotate compute their coordinates in another order (tables,
+    double precision), hence the tolerance of the bilinear cases.
+*/
+static void checkBaseline(const Size &size)
+{
+    string tag = to_string(size.height) + "x" + to_string(size.width);
+    Mat image = randomImage(size.height, size.width, 7);
+    Mat gauss(5, 5, CV_32FC1);
+    const float binomial[5] = {1, 4, 6, 4, 1};
+    for (int m = 0; m < 5; m++) {
+        for (int n = 0; n < 5; n++)
+            gauss.at<float>(m, n) = binomial[m] * binomial[n] / 256;
+    }
+    Mat skewed = (Mat_<float>(3, 3) << 0, 1, 2, -1, 0.5f, 3, 0.25f, -2, 1);
+    Mat square(3, 3, CV_32FC1, Scalar(1));
+    Mat cross = (Mat_<float>(5, 5) << 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0);
+    Mat line(1, 7, CV_32FC1, Scalar(1));
+
+    for (int k : {1, 3})
+        expectClose("baseline_meanFilter_" + to_string(k) + "_" + tag, meanFilter(image, k), baseline::meanFilter(image, k), 1e-3);
+    expectClose("baseline_convolution_gauss_" + tag, convolution(image, gauss), baseline::convolution(image, gauss), 1e-3);
+    expectClose("baseline_convolution_skewed_" + tag, convolution(image, skewed), baseline::convolution(image, skewed), 1e-3);
+    expectClose("baseline_edgeSobel_" + tag, edgeSobel(image), baseline::edgeSobel(image), 1e-3);
+    expectClose("baseline_bilateralFilter_" + tag, bilateralFilter(image, gauss, 30),
+                baseline::bilateralFilter(image, gauss, 30), 5e-2);
+
+    for (int k : {1, 2})
+        expectClose("baseline_median_" + to_string(k) + "_" + tag, median(image, k), baseline::median(image, k), 0);
+    vector<pair<string, Mat>> elements = {{"square", square}, {"cross", cross}, {"line", line}};
+    for (auto &e : elements) {
+        string suffix = e.first + "_" + tag;
+        expectClose("baseline_dilate_" + suffix, dilate(image, e.second), baseline::dilate(image, e.second), 0);
+        expectClose("baseline_erode_" + suffix, erode(image, e.second), baseline::erode(image, e.second), 0);
+        expectClose("baseline_open_" + suffix, open(image, e.second), baseline::open(image, e.second), 0);
+        expectClose("baseline_close_" + suffix, close(image, e.second), baseline::close(image, e.second), 0);
+        expectClose("baseline_morphologicalGradient_" + suffix, morphologicalGradient(image, e.second),
+                    referenceDifference(baseline::dilate(image, e.second), baseline::erode(image, e.second)), 0);
+    }
+
+    expectClose("baseline_transpose_" + tag, transpose(image), baseline::transpose(image), 0);
+    expectClose("baseline_expand_bilinear_" + tag, expand(image, 3, interpolate_bilinear),
+                baseline::expand(image, 3, baseline::interpolate_bilinear), 1e-2);
+    expectClose("baseline_expand_nearest_" + tag, expand(image, 3, interpolate_nearest),
+                baseline::expand(image, 3, baseline::interpolate_nearest), 0);
+    for (float angle : {30.f, 135.f, 200.f}) {
+        string suffix = to_string((int) angle) + "_" + tag;
+        expectClose("baseline_rotate_bilinear_" + suffix, rotate(image, angle, interpolate_bilinear),
+                    baseline::rotate(image, angle, baseline::interpolate_bilinear), 2e-2);
+        expectClose("baseline_rotate_nearest_" + suffix, rotate(image, angle, interpolate_nearest),
+                    baseline::rotate(image, angle, baseline::interpolate_nearest), 0);
+    }
+
+    for (double density : {0.3, 0.6}) {
+        string suffix = to_string((int) (density * 10)) + "_" + tag;
+        Mat zones = randomMask(size.height, size.width, density, 11);
+        for (int i = 0; i < zones.rows; i++) {
+            for (int j = 0; j < zones.cols; j++)
+                zones.at<int>(i, j) *= 1 + (i / 8 + j / 8) % 3;
+        }
+        expectSamePartition("baseline_ccLabel_" + suffix, ccLabel(zones), baseline::ccLabel(zones));
+        expectClose("baseline_ccAreaFilter_" + suffix, ccAreaFilter(zones, 4), baseline::ccAreaFilter(zones, 4), 0);
+    }
+
+    Mat turned = referenceQuarterTurn(image);
+    expectClose("baseline_rotate_90_" + tag, rotate(image, 90, interpolate_bilinear), turned, 0);
+    expectClose("baseline_rotate_180_" + tag, rotate(image, 180, interpolate_nearest),
+                referenceQuarterTurn(turned), 0);
+}
+
+/**
+    Transpose engine (transposeEngine.h) on random bytes of 1, 2, 4 and 8-byte
+    pixels, whose 8x8 register tiles are different (or absent for 8 bytes):
+     - transposeImage, and transposeInPlace on squares smaller than, equal
+       to and not multiple of the 32x32 tile and of the 8x8 register tile,
+       whole or as a view inside a wider image;
+     - the three flip modes and the quarter turns, against bytewise loops;
+     - rotate by 270 and -90 degrees (three quarter turns).
+    All exact.
+*/
+static void checkTranspose(const Size &size)
+{
+    string tag = to_string(size.height) + "x" + to_string(size.width);
+    const FlipMode modes[] = {FLIP_VERTICAL, FLIP_HORIZONTAL, FLIP_BOTH};
+
+    for (int type : {CV_8UC1, CV_16UC1, CV_32FC1, CV_64FC1}) {
+        string suffix = to_string(type) + "_" + tag;
+        Mat image = randomBytes(size.height, size.width, type, 13);
+        Mat transposed;
+        transposeImage(image, transposed);
+        expectIdentical("transposeImage_" + suffix, transposed, referenceTranspose(image));
+
+        int side = min(size.width, size.height);
+        for (int n : {1, 8, 31, 32, 33, 100, side}) {
+            if (n > side)
+                continue;
+            string name = "transposeInPlace_" + to_string(type) + "_" + to_string(n) + "_" + tag;
+            Mat square = image(Rect(0, 0, n, n)).clone();
+            Mat expected = referenceTranspose(square);
+            transposeInPlace(square);
+            expectIdentical(name, square, expected);
+
+            Mat wider = image.clone();
+            Mat view = wider(Rect(size.width - n, 0, n, n));
+            expected = referenceTranspose(view);
+            transposeInPlace(view);
+            expectIdentical(name + "_view", view, expected);
+        }
+
+        for (FlipMode mode : modes)
+            expectIdentical("flipImage_" + to_string(mode) + "_" + suffix, flipImage(image, mode), referenceFlip(image, mode));
+
+        Mat turned = image;
+        for (int turns = 1; turns <= 3; turns++) {
+            turned = referenceTurn(turned);
+            expectIdentical("rotateQuarterTurns_" + to_string(turns) + "_" + suffix, rotateQuarterTurns(image, turns), turned);
+        }
+        expectIdentical("rotateQuarterTurns_-1_" + suffix, rotateQuarterTurns(image, -1), turned);
+    }
+
+    Mat image = randomImage(size.height, size.width, 17);
+    Mat threeTurns = referenceQuarterTurn(referenceQuarterTurn(referenceQuarterTurn(image)));
+    expectClose("rotate_270_" + tag, rotate(image, 270, interpolate_nearest), threeTurns, 0);
+    expectClose("rotate_-90_" + tag, rotate(image, -90, interpolate_bilinear), threeTurns, 0);
+}
+
+/**
+    Pyramids (pyramid.h), on the odd sizes of the other checks:
+     - pyramidDown is the 5-tap binomial blur followed by the 2x decimation,
+       for float and 8-bit inputs and every padding (1e-3: float sums);
+     - the levels of a lazy GaussianPyramid, asked from the top down, are
+       those of the eager one, bit for bit;
+     - collapseLaplacian(laplacianPyramid(x)) gives x back within 1e-3 on
+       [0, 255] (float rounding of the differences and of their sums);
+     - ScaleSpace follows Lowe's layout: intervals + 3 images per octave of
+       scales sigma0 * 2^(o + s / intervals); the base of octave o + 1 is
+       image intervals of octave o with every other row and column dropped
+       (exact), and lazy levels are the eager ones. The blur of an impulse
+       at image (o, s), measured in pixels of the input, is sigma(o, s)
+       within 2% (the gaussians are cut at 3 sigma).
+*/
+static void checkPyramid(const Size &size)
+{
+    string tag = to_string(size.height) + "x" + to_string(size.width);
+    Mat image = randomImage(size.height, size.width, 19);
+
+    for (PaddingMode padding : {PAD_ZERO, PAD_REPLICATE, PAD_REFLECT, PAD_WRAP}) {
+        string suffix = to_string(padding) + "_" + tag;
+        for (int type : {CV_32FC1, CV_8UC1}) {
+            Mat input = converted(image, type);
+            expectClose("pyramidDown_" + to_string(type) + "_" + suffix, pyramidDown(input, padding),
+                        referencePyramidDown(input, padding), 1e-3);
+        }
+        // the levels of the first octaves are odd again
+        Mat half = pyramidDown(image, padding);
+        expectClose("pyramidDown_twice_" + suffix, pyramidDown(half, padding), referencePyramidDown(half, padding), 1e-3);
+    }
+
+    GaussianPyramid eager(image);
+    GaussianPyramid lazy(image, 0, true);
+    if (lazy.levels() != eager.levels())
+        fail("gaussianPyramid_lazy_" + tag, "different number of levels");
+    for (int k = min(lazy.levels(), eager.levels()) - 1; k >= 0; k--)
+        expectClose("gaussianPyramid_lazy_" + to_string(k) + "_" + tag, lazy.level(k), eager.level(k), 0);
+
+    for (PaddingMode padding : {PAD_REPLICATE, PAD_REFLECT}) {
+        expectClose("collapseLaplacian_" + to_string(padding) + "_" + tag,
+                    collapseLaplacian(laplacianPyramid(image, 0, padding), padding), image, 1e-3);
+    }
+
+    const int octaves = 3, intervals = 3;
+    const double sigma0 = 1.6;
+    ScaleSpace space(image, octaves, intervals, sigma0);
+    ScaleSpace lazySpace(image, octaves, intervals, sigma0, 0.5, true);
+    if (space.levelsPerOctave() != intervals + 3)
+        fail("scaleSpace_levels_" + tag, "levelsPerOctave is not intervals + 3");
+    for (int o = octaves - 1; o >= 0; o--) {
+        for (int s = space.levelsPerOctave() - 1; s >= 0; s--) {
+            string name = to_string(o) + "_" + to_string(s) + "_" + tag;
+            if (fabs(space.sigma(o, s) - sigma0 * pow(2.0, o + s / (double) intervals)) > 1e-9)
+                fail("scaleSpace_sigma_" + name, "not sigma0 * 2^(o + s / intervals)");
+            expectClose("scaleSpace_lazy_" + name, lazySpace.level(o, s), space.level(o, s), 0);
+        }
+        if (o > 0) {
+            const Mat &previous = space.level(o - 1, intervals);
+            Mat decimated((previous.rows + 1) / 2, (previous.cols + 1) / 2, CV_32FC1);
+            for (int i = 0; i < decimated.rows; i++) {
+                for (int j = 0; j < decimated.cols; j++)
+                    decimated.at<float>(i, j) = previous.at<float>(2 * i, 2 * j);
+            }
+            expectClose("scaleSpace_base_" + to_string(o) + "_" + tag, space.level(o, 0), decimated, 0);
+        }
+    }
+
+    // impulse on even coordinates of every octave, far enough from the border
+    Mat impulse(257, 257, CV_32FC1, Scalar(0));
+    impulse.at<float>(128, 128) = 1;
+    ScaleSpace blurred(impulse, octaves, intervals, sigma0, 0);
+    for (int o = 0; o < octaves; o++) {
+        for (int s = 0; s < blurred.levelsPerOctave(); s++) {
+            const Mat &level = blurred.level(o, s);
+            double mass = 0, moment = 0, center = 128 >> o;
+            for (int i = 0; i < level.rows; i++) {
+                for (int j = 0; j < level.cols; j++) {
+                    double v = level.at<float>(i, j);
+                    mass += v;
+                    moment += v * ((i - center) * (i - center) + (j - center) * (j - center)) / 2;
+                }
+            }
+            double measured = sqrt(moment / mass) * (1 << o);
+            double expected = blurred.sigma(o, s);
+            if (fabs(measured - expected) > 0.02 * expected) {
+                char message[128];
+                snprintf(message, sizeof(message), "impulse blurred by %g input pixels, sigma is %g", measured, expected);
+                fail("scaleSpace_impulse_" + to_string(o) + "_" + to_string(s) + "_" + tag, message);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    for (int a = 1; a + 1 < argc; a += 2) {
+        recording = recording || strcmp(argv[a], "--record") == 0;
+        comparing = comparing || strcmp(argv[a], "--compare") == 0;
+        goldenDir = argv[a + 1];
+    }
+    if ((argc > 1 && goldenDir.empty()) || (recording && comparing)) {
+        fprintf(stderr, "usage: %s [--record DIR | --compare DIR]\n", argv[0]);
+        return 2;
+    }
+
+    const Size sizes[] = {Size(53, 37), Size(517, 301)};
+    SimdLevel best = simdLevel();
+    int threads = getNumThreads();
+
+    for (int level = SIMD_SCALAR; level <= best; level++) {
+        // several threads even on a single core, for the strip and tile splits
+        for (int n : {1, max(threads, 4)}) {
+            setSimdLevel((SimdLevel) level);
+            setNumThreads(n);
+            configuration = "simd " + to_string(level) + ", " + to_string(n) + " threads";
+            for (const Size &size : sizes) {
+                checkAll(size);
+                checkBaseline(size);
+                checkPipeline(size);
+                checkInterpolation(size);
+                checkResize(size);
+                checkTranspose(size);
+                checkPyramid(size);
+            }
+            firstConfiguration = false;
+        }
+    }
+    setSimdLevel(best);
+    setNumThreads(threads);
+
+    printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
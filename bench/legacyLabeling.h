@@ -0,0 +1,215 @@
+#ifndef LEGACY_LABELING_H
+#define LEGACY_LABELING_H
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <vector>
+
+/**
+    Previous ccTwoPassLabel (label equivalences kept in vectors of vectors,
+    searched linearly), kept as the baseline of benchLabeling.
+*/
+namespace legacy {
+
+using namespace cv;
+using namespace std;
+
+inline bool contains(vector<int> v, int element) {
+    return std::find(v.begin(), v.end(), element) != v.end();
+}
+
+inline vector<int> uniqFusion(vector<int> v1, vector<int> v2) {// Fusion with unicity
+    for (int p2: v2) {
+        if (!contains (v1, p2)) {
+            v1.push_back(p2);
+        }
+    } 
+    return v1;
+}
+
+inline bool firstPass(Mat image, Mat res, Point2i p, int compteur, vector<vector<int>> &equivalenceArray) { // Returns true if compteur needs to be increased
+    //printf("f");
+    if (image.at<int>(p.x, p.y) == 0) return false;
+    // So p is not background.
+
+    if (p.x == 0 && p.y == 0) { // Neither above nor left exist:
+        res.at<int>(p.x, p.y) = compteur;
+        return true;
+    }
+    if (p.x == 0) { // No left neighbour, but above exists
+        int aboveLabel = res.at<int>(p.x, p.y - 1);
+
+        if (aboveLabel == 0 ) { // above not labeled
+            res.at<int>(p.x, p.y) = compteur;
+            return true; 
+        }
+        else { // above labeled
+            res.at<int>(p.x, p.y) =  aboveLabel;
+            return false;
+        }
+
+    }
+    if (p.y == 0) { // No above neighbour, but left exists
+        int leftLabel = res.at<int>(p.x - 1, p.y);
+
+        if (leftLabel == 0) { // left not labeled
+            res.at<int>(p.x, p.y) = compteur;
+            return true;
+        } 
+        else { // left labeled
+            res.at<int>(p.x, p.y) = leftLabel;
+            return false;
+        }
+    }
+
+    // Both above and left exist
+    int aboveLabel = res.at<int>(p.x, p.y - 1);
+    int leftLabel = res.at<int>(p.x - 1, p.y);
+
+    if (aboveLabel == 0 && leftLabel == 0) { // None assigned
+         res.at<int>(p.x, p.y) = compteur;
+         return true;
+    }
+   
+    if (aboveLabel == 0 && leftLabel != 0) { // only left exists
+         res.at<int>(p.x, p.y) = leftLabel;
+         return false;
+    }
+
+    if (aboveLabel != 0 && leftLabel == 0) { // only right exists
+         res.at<int>(p.x, p.y) = aboveLabel;
+         return false;
+    }
+    // Both values exist.
+    // If they are the same :
+    if (aboveLabel == leftLabel) {
+        res.at<int>(p.x, p.y) = aboveLabel;
+        return false;
+    }
+    // else 
+    int smallestLabel = min(aboveLabel, leftLabel);
+    int largestLabel = max(aboveLabel, leftLabel);
+    res.at<int>(p.x, p.y) = smallestLabel;
+
+    // We must now indicate the equiv smallestLabel = largestLabel
+    vector<int> joinIndex = {};
+    for (int k = 0 ; k < (int) equivalenceArray.size(); k++ ) {
+        
+         if (contains(equivalenceArray[k], smallestLabel) &&  contains(equivalenceArray[k], largestLabel)) { // both are already registered !
+            //printf("This CC is already known\n");
+            return false;
+         }
+
+        if (contains(equivalenceArray[k], smallestLabel) && ! contains(equivalenceArray[k], largestLabel)) { // smallestLabel is in the array, but largestLabel isn't
+            equivalenceArray[k].push_back(largestLabel);
+            joinIndex.push_back(k);
+            //printf("%d added to equiv[%d] \n", largestLabel, k);
+        }
+        if (contains(equivalenceArray[k], largestLabel) && ! contains(equivalenceArray[k], smallestLabel)) { // largestLabel is in the array, but smallestLabel isn't
+            equivalenceArray[k].push_back(smallestLabel);
+            joinIndex.push_back(k);
+            //printf("%d added to equiv[%d] \n", largestLabel, k);
+        }
+
+    }
+    //printf("joinIndex's size is now %d\n", (int) joinIndex.size());
+
+    if (joinIndex.size() > 1) { 
+        equivalenceArray[joinIndex[0]] = uniqFusion(equivalenceArray[joinIndex[0]], equivalenceArray[joinIndex[1]]);
+        equivalenceArray.erase(equivalenceArray.begin() + joinIndex[1]); 
+        //printf("Deleted one class\n");
+    }
+    if (joinIndex.size() == 0) {
+        vector<int> newVec;
+        newVec.push_back(smallestLabel);
+        newVec.push_back(largestLabel);
+        equivalenceArray.push_back(newVec);
+        //printf("New class {%d, %d} added\n", smallestLabel, largestLabel);
+    }
+
+    return false;
+}
+
+inline int minElement(vector<int> &v) {
+    if (v.size() == 0) return 0;
+    int res = v[0];
+    for (int element: v) {
+        if (element < res)
+            res = element;
+    }
+    return res;
+}
+
+inline void secondPass(Mat res, Point2i p, vector<vector<int>> &equivalenceArray) {
+    if (res.at<int>(p.x, p.y) == 0) return;
+    for (int k = 0; k < (int) equivalenceArray.size(); k++) {
+        if (contains(equivalenceArray[k], res.at<int>(p.x, p.y))) {
+            
+        //res.at<int>(p.x, p.y) = equivalenceArray[k][0]; // equivalenceArray has been sorted
+            res.at<int>(p.x, p.y) = k + 1;
+            return;
+        }
+
+    }
+}
+
+/**
+    Performs a labeling of image connected component with 4 connectivity using a
+    2 pass algorithm.
+    Any non zero pixel of the image is considered as present.
+*/
+inline cv::Mat ccTwoPassLabel(cv::Mat image)
+{
+    Mat res = Mat::zeros(image.rows, image.cols, CV_32SC1); // 32 int image
+
+    int compteur = 1;
+    vector<vector<int>> equivalenceArray = {}; // will contain the equivalences : equivalenceArray[0] = {7,14} means component 7 and component 14 are the same.
+    
+    // First pass on all pixels
+
+    for(int i = 0; i < image.rows; i++) {     
+        for (int j = 0 ; j < image.cols; j++) {
+            if (firstPass(image, res, Point2i(i,j), compteur, equivalenceArray) ) {
+                compteur++;
+            }
+        }
+    }
+    
+    // Trick : We now add the "equivalence classes" of 1 element.
+    // This will allow our function "secondPass" to easily find the correct number to give to each class.
+
+    for(int u = 1; u < compteur; u++) {
+        bool shouldWeAdd = true;
+        for (vector<int> equiv: equivalenceArray) {
+            if (contains(equiv, u)) {
+                shouldWeAdd = false;
+            }
+        }
+        if (shouldWeAdd)
+            equivalenceArray.push_back({u});
+    }
+    // End of the trick.
+    
+    // Now we sort the equivalenceArrays in increasing order
+    for (int i = 0 ; i < (int) equivalenceArray.size(); i++) {
+        sort(equivalenceArray[i].begin(), equivalenceArray[i].end());
+    }
+
+    std::sort(equivalenceArray.begin(), equivalenceArray.end(),
+          [](const std::vector<int>& a, const std::vector<int>& b) {
+     return a[0] < b[0];
+    });
+    
+    // We now apply the secondPass
+    for (int i = 0 ; i < image.rows; i++) {
+        for(int j = 0; j < image.cols; j++) {
+            secondPass(res, Point2i(i,j), equivalenceArray);   
+        }
+    }
+
+    return res;
+}
+
+}
+
+#endif
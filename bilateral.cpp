@@ -0,0 +1,228 @@
+#include "bilateral.h"
+#include "tpConvolution.h"
+#include "parallel.h"
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+using namespace cv;
+using namespace std;
+
+// Range table resolution (entries per sigma_r) and extent (in sigma_r)
+static const int LUT_STEPS_PER_SIGMA = 1024;
+static const int LUT_EXTENT_SIGMAS = 6;
+
+/**
+    Windowed bilateral filter, rangeWeight(d) returning the range weight of
+    an intensity difference d >= 0.
+*/
+template<typename RangeWeight>
+static Mat bilateralWindow(const Mat &image, const Mat &kernel, PaddingMode padding, RangeWeight rangeWeight) {
+    int k = (kernel.rows - 1) / 2;
+    Mat res = Mat::zeros(image.rows, image.cols, CV_32FC1);
+
+    auto interior = [&](int i, int j0, int j1) {
+        float *out = res.ptr<float>(i);
+        for (int j = j0; j < j1; j++) {
+            float pxVal = image.at<float>(i, j);
+            float sum_px = 0.0;
+            float norm_fact = 0.0;
+            for (int m = -k; m <= k; m++) {
+                const float *in = image.ptr<float>(i + m) + j;
+                const float *w = kernel.ptr<float>(m + k) + k;
+                for (int n = -k; n <= k; n++) {
+                    float weight = w[n] * rangeWeight(abs(pxVal - in[n]));
+                    // skipped rather than added: 0 * NaN is NaN
+                    if (weight != 0.0f) {
+                        sum_px += weight * in[n];
+                        norm_fact += weight;
+                    }
+                }
+            }
+            out[j] = sum_px / norm_fact;
+        }
+    };
+    auto border = [&](int i, int j) {
+        float pxVal = image.at<float>(i, j);
+        float sum_px = 0.0;
+        float norm_fact = 0.0;
+        forEachWindowSample(image, i, j, k, k, padding, [&](int m, int n, float neighVal) {
+            float weight = kernel.at<float>(m + k, n + k) * rangeWeight(abs(pxVal - neighVal));
+            if (weight != 0.0f) {
+                sum_px += weight * neighVal;
+                norm_fact += weight;
+            }
+        });
+        res.at<float>(i, j) = sum_px / norm_fact;
+    };
+    parallel_for_2d(image.rows, image.cols, 2 * sizeof(float), [&](const Rect &tile) {
+        forEachPixelSplit(image.rows, image.cols, k, k, tile, interior, border);
+    });
+    return res;
+}
+
+/**
+    Scale of the isotropic gaussian having the same second moment as the kernel.
+*/
+static double kernelScale(const Mat &kernel) {
+    int ky = (kernel.rows - 1) / 2;
+    int kx = (kernel.cols - 1) / 2;
+    double sum = 0.0, moment = 0.0;
+    for (int m = -ky; m <= ky; m++) {
+        for (int n = -kx; n <= kx; n++) {
+            double w = kernel.at<float>(m + ky, n + kx);
+            sum += w;
+            moment += w * (m * m + n * n);
+        }
+    }
+    if (sum <= 0.0 || moment <= 0.0)
+        return 1.0;
+    return sqrt(moment / (2.0 * sum));
+}
+
+Mat bilateral(Mat image, Mat kernel, double sigma_r, PaddingMode padding, BilateralMode mode)
+{
+    assert(image.type() == CV_32FC1 && kernel.type() == CV_32FC1);
+    assert(sigma_r > 0);
+
+    if (mode == BILATERAL_GRID && padding == PAD_ZERO)
+        return bilateralGrid(image, kernelScale(kernel), sigma_r);
+
+    float sigma_r2 = (float) pow(sigma_r, 2);
+    if (mode == BILATERAL_DIRECT) {
+        return bilateralWindow(image, kernel, padding, [&](float d) {
+            return gaussian(d, sigma_r2);
+        });
+    }
+
+    // the 1/(2.pi.sigma_r^2) factor of gaussian() cancels out in the normalisation
+    int size = LUT_STEPS_PER_SIGMA * LUT_EXTENT_SIGMAS + 1;
+    vector<float> rangeLut(size);
+    double step = sigma_r / LUT_STEPS_PER_SIGMA;
+    for (int b = 0; b < size; b++) {
+        double d = b * step;
+        rangeLut[b] = (float) exp(-d * d / (2 * sigma_r2));
+    }
+    float invStep = (float) (1.0 / step);
+
+    return bilateralWindow(image, kernel, padding, [&](float d) {
+        // compared before the conversion: false for NaN, which gets no weight
+        float index = d * invStep + 0.5f;
+        return index < (float) size ? rangeLut[(int) index] : 0.0f;
+    });
+}
+
+/**
+    Blur of a grid of gh x gw x gd cells (row major, depth fastest) by the
+    [1 4 6 4 1]/16 kernel (a gaussian of one cell) along each of the 3 axes.
+*/
+static void blurGrid(vector<float> &grid, int gh, int gw, int gd) {
+    static const float w[5] = {1.f/16, 4.f/16, 6.f/16, 4.f/16, 1.f/16};
+    vector<float> tmp(grid.size());
+    int strides[3] = {gw * gd, gd, 1};
+    int sizes[3] = {gh, gw, gd};
+
+    for (int axis = 0; axis < 3; axis++) {
+        int stride = strides[axis];
+        int size = sizes[axis];
+        parallel_for_1d(gh, 4, [&](int begin, int end) {
+            for (int y = begin; y < end; y++) {
+                for (int x = 0; x < gw; x++) {
+                    for (int z = 0; z < gd; z++) {
+                        int coord = axis == 0 ? y : (axis == 1 ? x : z);
+                        int cell = (y * gw + x) * gd + z;
+                        float sum = 0.0f;
+                        for (int t = -2; t <= 2; t++) {
+                            if (coord + t >= 0 && coord + t < size)
+                                sum += w[t + 2] * grid[cell + t * stride];
+                        }
+                        tmp[cell] = sum;
+                    }
+                }
+            }
+        });
+        grid.swap(tmp);
+    }
+}
+
+Mat bilateralGrid(Mat image, double sigma_s, double sigma_r)
+{
+    assert(image.type() == CV_32FC1);
+    assert(sigma_s > 0 && sigma_r > 0);
+    Mat res = Mat::zeros(image.rows, image.cols, CV_32FC1);
+    if (image.rows == 0 || image.cols == 0)
+        return res;
+
+    // NaN and infinite samples are left out of the grid and copied as such
+    float minVal = numeric_limits<float>::infinity(), maxVal = -minVal;
+    for (int i = 0; i < image.rows; i++) {
+        const float *in = image.ptr<float>(i);
+        for (int j = 0; j < image.cols; j++) {
+            if (isfinite(in[j])) {
+                minVal = min(minVal, in[j]);
+                maxVal = max(maxVal, in[j]);
+            }
+        }
+    }
+    if (minVal > maxVal)
+        return image.clone();
+
+    // a margin of 2 cells keeps the blur support inside the grid
+    const int pad = 2;
+    int gh = (int) ((image.rows - 1) / sigma_s) + 1 + 2 * pad;
+    int gw = (int) ((image.cols - 1) / sigma_s) + 1 + 2 * pad;
+    int gd = (int) ((maxVal - minVal) / sigma_r) + 1 + 2 * pad;
+
+    // homogeneous coordinates: sum of intensities and number of samples per cell
+    vector<float> values((size_t) gh * gw * gd, 0.0f);
+    vector<float> weights((size_t) gh * gw * gd, 0.0f);
+    for (int i = 0; i < image.rows; i++) {
+        const float *in = image.ptr<float>(i);
+        int y = (int) lround(i / sigma_s) + pad;
+        for (int j = 0; j < image.cols; j++) {
+            if (!isfinite(in[j]))
+                continue;
+            int x = (int) lround(j / sigma_s) + pad;
+            int z = (int) lround((in[j] - minVal) / sigma_r) + pad;
+            size_t cell = ((size_t) y * gw + x) * gd + z;
+            values[cell] += in[j];
+            weights[cell] += 1.0f;
+        }
+    }
+
+    blurGrid(values, gh, gw, gd);
+    blurGrid(weights, gh, gw, gd);
+
+    parallel_for_2d(image.rows, image.cols, 2 * sizeof(float), [&](const Rect &tile) {
+        for (int i = tile.y; i < tile.y + tile.height; i++) {
+            const float *in = image.ptr<float>(i);
+            float *out = res.ptr<float>(i);
+            float fy = (float) (i / sigma_s) + pad;
+            int y0 = min((int) fy, gh - 2);
+            float ay = fy - y0;
+            for (int j = tile.x; j < tile.x + tile.width; j++) {
+                if (!isfinite(in[j])) {
+                    out[j] = in[j];
+                    continue;
+                }
+                float fx = (float) (j / sigma_s) + pad;
+                float fz = (float) ((in[j] - minVal) / sigma_r) + pad;
+                int x0 = min((int) fx, gw - 2);
+                int z0 = min((int) fz, gd - 2);
+                float ax = fx - x0, az = fz - z0;
+
+                float value = 0.0f, weight = 0.0f;
+                for (int c = 0; c < 8; c++) {
+                    int dy = c >> 2, dx = (c >> 1) & 1, dz = c & 1;
+                    float w = (dy ? ay : 1 - ay) * (dx ? ax : 1 - ax) * (dz ? az : 1 - az);
+                    size_t cell = ((size_t) (y0 + dy) * gw + x0 + dx) * gd + z0 + dz;
+                    value += w * values[cell];
+                    weight += w * weights[cell];
+                }
+                out[j] = weight > 0 ? value / weight : in[j];
+            }
+        }
+    });
+    return res;
+}
@@ -0,0 +1,56 @@
+#ifndef BILATERAL_H
+#define BILATERAL_H
+
+#include <opencv2/core.hpp>
+#include "border.h"
+
+/**
+    Algorithm used by the bilateral filter.
+
+    BILATERAL_DIRECT : the range gaussian is evaluated for every tap.
+    BILATERAL_LUT    : the range weights are read from a table precomputed once
+                       per call, the intensity difference being rounded to a
+                       multiple of sigma_r/1024 (absolute weight error below
+                       3e-4, relative error below 3e-3 at 6*sigma_r);
+                       differences above 6*sigma_r, and NaN ones, get a zero
+                       weight.
+    BILATERAL_GRID   : bilateral grid approximation, its cost does not depend
+                       on the kernel size (see bilateralGrid).
+*/
+enum BilateralMode {
+    BILATERAL_DIRECT,
+    BILATERAL_LUT,
+    BILATERAL_GRID
+};
+
+/**
+    Performs a bilateral filter of a float image with the given spatial
+    smoothing kernel and an intensity smoothing of scale sigma_r.
+
+    Samples missing under the padding mode (outside of the image with PAD_ZERO)
+    are ignored. BILATERAL_GRID only supports PAD_ZERO: with another padding
+    mode it falls back to BILATERAL_LUT.
+*/
+cv::Mat bilateral(cv::Mat image, cv::Mat kernel, double sigma_r, PaddingMode padding = PAD_ZERO,
+                  BilateralMode mode = BILATERAL_LUT);
+
+/**
+    Bilateral grid approximation (Paris & Durand) of a bilateral filter with
+    an isotropic gaussian spatial kernel of scale sigma_s and a range gaussian
+    of scale sigma_r.
+
+    Each pixel is splatted in the nearest cell of a grid sampled every sigma_s
+    in space and every sigma_r in intensity, the grid is blurred by a gaussian
+    of one cell and sliced with trilinear interpolation.
+    Error bound: every sample is moved by at most half a cell before being
+    weighted, so each spatial (resp. range) weight is the exact weight of a
+    distance within sigma_s/2 (resp. intensity difference within sigma_r/2)
+    of the true one. The output is a convex combination of input values,
+    hence always within the [min, max] range of the image. NaN and infinite
+    pixels are left out of the grid and copied to the output unchanged.
+    The grid has about (rows/sigma_s)*(cols/sigma_s)*(range/sigma_r) cells, the
+    mode is meant for large spatial kernels (sigma_s of a few pixels or more).
+*/
+cv::Mat bilateralGrid(cv::Mat image, double sigma_s, double sigma_r);
+
+#endif
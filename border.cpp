@@ -0,0 +1,29 @@
+#include "border.h"
+#include <vector>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+Mat padImage(Mat image, int ky, int kx, PaddingMode mode)
+{
+    assert(image.type() == CV_32FC1);
+    Mat res = Mat::zeros(image.rows + 2 * ky, image.cols + 2 * kx, CV_32FC1);
+
+    vector<int> colIndex(res.cols);
+    for (int j = 0; j < res.cols; j++) {
+        colIndex[j] = borderIndex(j - kx, image.cols, mode);
+    }
+
+    for (int i = 0; i < res.rows; i++) {
+        int y = borderIndex(i - ky, image.rows, mode);
+        if (y < 0)
+            continue;
+        const float *in = image.ptr<float>(y);
+        float *out = res.ptr<float>(i);
+        for (int j = 0; j < res.cols; j++) {
+            if (colIndex[j] >= 0)
+                out[j] = in[colIndex[j]];
+        }
+    }
+    return res;
+}
@@ -0,0 +1,143 @@
+#ifndef BORDER_H
+#define BORDER_H
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+
+/**
+    How samples read outside of the image domain are obtained.
+
+    PAD_ZERO      : samples outside the image do not exist. Linear filters read
+                    them as zero, rank filters (median, dilation, erosion) and the
+                    bilateral filter ignore them. This is the behaviour of the
+                    original operators.
+    PAD_REPLICATE : aaa|abcd|ddd
+    PAD_REFLECT   : cb|abcd|cb, mirror around the first and last pixel
+    PAD_WRAP      : cd|abcd|ab, the image is periodic
+*/
+enum PaddingMode {
+    PAD_ZERO,
+    PAD_REPLICATE,
+    PAD_REFLECT,
+    PAD_WRAP
+};
+
+/**
+    Index of the sample read at coordinate p of a line of len pixels,
+    or -1 when the sample does not exist (PAD_ZERO outside of [0, len)).
+*/
+inline int borderIndex(int p, int len, PaddingMode mode)
+{
+    if ((unsigned) p < (unsigned) len)
+        return p;
+
+    switch (mode) {
+    case PAD_REPLICATE:
+        return p < 0 ? 0 : len - 1;
+    case PAD_REFLECT: {
+        if (len == 1)
+            return 0;
+        int period = 2 * (len - 1);
+        p %= period;
+        if (p < 0)
+            p += period;
+        return p < len ? p : period - p;
+    }
+    case PAD_WRAP:
+        p %= len;
+        return p < 0 ? p + len : p;
+    default:
+        return -1;
+    }
+}
+
+/**
+    Rows [top, bottom) and columns [left, right) of the pixels whose window of
+    half size (ky, kx) lies entirely inside a rows x cols image.
+    The rectangle is empty (top >= bottom or left >= right) for small images.
+*/
+struct InteriorRect {
+    int top, bottom, left, right;
+};
+
+inline InteriorRect interiorRect(int rows, int cols, int ky, int kx)
+{
+    InteriorRect r;
+    r.top = std::min(ky, rows);
+    r.bottom = std::max(rows - ky, r.top);
+    r.left = std::min(kx, cols);
+    r.right = std::max(cols - kx, r.left);
+    return r;
+}
+
+/**
+    Visit every pixel of the region (a tile) of a rows x cols image exactly once.
+
+    interior(i, j0, j1) is called on the row segments [j0, j1) of pixels whose
+    window of half size (ky, kx) lies inside the image: it can read its
+    neighbours through raw row pointers without any bounds check.
+    border(i, j) is called on each of the remaining pixels.
+*/
+template<typename Interior, typename Border>
+void forEachPixelSplit(int rows, int cols, int ky, int kx, const cv::Rect &region,
+                       Interior interior, Border border)
+{
+    InteriorRect r = interiorRect(rows, cols, ky, kx);
+    int colBegin = region.x;
+    int colEnd = region.x + region.width;
+    int left = std::min(std::max(r.left, colBegin), colEnd);
+    int right = std::max(std::min(r.right, colEnd), left);
+
+    for (int i = region.y; i < region.y + region.height; i++) {
+        if (i < r.top || i >= r.bottom || left >= right) {
+            for (int j = colBegin; j < colEnd; j++) {
+                border(i, j);
+            }
+            continue;
+        }
+        for (int j = colBegin; j < left; j++) {
+            border(i, j);
+        }
+        interior(i, left, right);
+        for (int j = right; j < colEnd; j++) {
+            border(i, j);
+        }
+    }
+}
+
+template<typename Interior, typename Border>
+void forEachPixelSplit(int rows, int cols, int ky, int kx, Interior interior, Border border)
+{
+    forEachPixelSplit(rows, cols, ky, kx, cv::Rect(0, 0, cols, rows), interior, border);
+}
+
+/**
+    Call f(m, n, value) for each existing sample of the window of half size
+    (ky, kx) centered on pixel (i, j) of an image of pixel type T (float by
+    default), (m, n) being the offset of the sample in [-ky, ky] x [-kx, kx].
+    Meant for border pixels: every tap goes through borderIndex.
+*/
+template<typename T = float, typename F>
+void forEachWindowSample(const cv::Mat &image, int i, int j, int ky, int kx, PaddingMode mode, F f)
+{
+    for (int m = -ky; m <= ky; m++) {
+        int y = borderIndex(i + m, image.rows, mode);
+        if (y < 0)
+            continue;
+        const T *row = image.ptr<T>(y);
+        for (int n = -kx; n <= kx; n++) {
+            int x = borderIndex(j + n, image.cols, mode);
+            if (x < 0)
+                continue;
+            f(m, n, row[x]);
+        }
+    }
+}
+
+/**
+    Copy of a float image with ky rows and kx columns added on each side,
+    filled according to mode (zeros for PAD_ZERO).
+*/
+cv::Mat padImage(cv::Mat image, int ky, int kx, PaddingMode mode);
+
+#endif
@@ -0,0 +1,105 @@
+#include "boxFilter.h"
+#include "parallel.h"
+#include "bufferPool.h"
+#include "pixelTraits.h"
+#include <algorithm>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+/**
+    Add (sign = 1) or remove (sign = -1) the row i of the image to the column sums.
+*/
+template<typename T, typename Sum>
+static void accumulateRow(const Mat &image, int i, int sign, Sum *colSum) {
+    const T *row = image.ptr<T>(i);
+    for (int j = 0; j < image.cols; j++) {
+        colSum[j] += sign * (Sum) row[j];
+    }
+}
+
+/**
+    Compute a mean filter of size 2k+1 of an image of pixel type T into an
+    image of pixel type Out.
+
+    The vertical window sum of each column is kept in colSum and updated with
+    one addition and one subtraction when moving to the next row, the
+    horizontal window sum is updated the same way along each row.
+    Sums are kept in PixelTraits<T>::Sum: exact integers for integer images,
+    double for float images so that the running additions / subtractions
+    do not drift on large images.
+*/
+template<typename T, typename Out>
+static void boxFilterOf(const Mat &image, int k, Mat &res, BoxNormalization normalization) {
+    typedef typename PixelTraits<T>::Sum Sum;
+    double windowArea = (double) (2*k+1) * (2*k+1);
+
+    // horizontal strips, each one restarting its own column sums: the
+    // strips only depend on k, so the result does not depend on the thread count
+    int stripRows = max(l2TileSize(image.rows, image.cols, 2 * sizeof(float)).height, 4 * (2*k+1));
+
+    parallel_for_2d(image.rows, image.cols, Size(image.cols, stripRows), [&](const Rect &strip) {
+        ScratchScope scratch;
+        Sum *colSum = scratch.allocate<Sum>(image.cols);
+        fill(colSum, colSum + image.cols, (Sum) 0);
+
+        // rows [y-k, y+k-1] are in the window of row y before the loop adds row y+k
+        for (int i = max(strip.y - k, 0); i < min(strip.y + k, image.rows); i++) {
+            accumulateRow<T>(image, i, 1, colSum);
+        }
+
+        for (int i = strip.y; i < strip.y + strip.height; i++) {
+            if (i + k < image.rows)
+                accumulateRow<T>(image, i + k, 1, colSum);
+            if (i - k - 1 >= 0 && i > strip.y)
+                accumulateRow<T>(image, i - k - 1, -1, colSum);
+
+            int validRows = min(i + k, image.rows - 1) - max(i - k, 0) + 1;
+            Out *out = res.ptr<Out>(i);
+
+            Sum sum_px = 0;
+            for (int j = 0; j < min(k, image.cols); j++) {
+                sum_px += colSum[j];
+            }
+
+            for (int j = 0; j < image.cols; j++) {
+                if (j + k < image.cols)
+                    sum_px += colSum[j + k];
+                if (j - k - 1 >= 0)
+                    sum_px -= colSum[j - k - 1];
+
+                if (normalization == BOX_NORM_VALID_PIXELS) {
+                    int validCols = min(j + k, image.cols - 1) - max(j - k, 0) + 1;
+                    out[j] = storePixel<Out>((float) (sum_px / (double) (validRows * validCols)));
+                } else {
+                    out[j] = storePixel<Out>((float) (sum_px / windowArea));
+                }
+            }
+        }
+    });
+}
+
+void boxFilter(const Mat &image, int k, Mat &res, BoxNormalization normalization, int depth)
+{
+    assert(k >= 0);
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1 || image.type() == CV_16UC1);
+    assert(depth == CV_32F || depth == CV_8U || depth == CV_16U);
+    assert(res.data == nullptr || res.data != image.data);
+
+    ensureImage(res, image.rows, image.cols, CV_MAKETYPE(depth, 1));
+    if (image.rows == 0 || image.cols == 0)
+        return;
+
+    dispatchDepth(image.depth(), [&](auto in) {
+        dispatchDepth(depth, [&](auto out) {
+            boxFilterOf<decltype(in), decltype(out)>(image, k, res, normalization);
+        });
+    });
+}
+
+Mat boxFilter(Mat image, int k, BoxNormalization normalization, int depth)
+{
+    Mat res;
+    boxFilter(image, k, res, normalization, depth);
+    return res;
+}
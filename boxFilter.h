@@ -0,0 +1,36 @@
+#ifndef BOX_FILTER_H
+#define BOX_FILTER_H
+
+#include <opencv2/core.hpp>
+
+/**
+    How the window sum of a box filter is normalised near the image border.
+
+    BOX_NORM_ZERO_PADDING : pixels outside the image count as zeros, the sum is
+                            always divided by (2k+1)*(2k+1).
+    BOX_NORM_VALID_PIXELS : only pixels inside the image are averaged, the sum is
+                            divided by the number of pixels of the window that
+                            fall inside the image.
+*/
+enum BoxNormalization {
+    BOX_NORM_ZERO_PADDING,
+    BOX_NORM_VALID_PIXELS
+};
+
+/**
+    Compute a mean filter of size 2k+1 of an 8-bit, 16-bit or float image
+    with running column / row sums: the cost per pixel does not depend on k.
+    Sums of integer images are exact integers (see PixelTraits::Sum). The
+    result has the given depth, rounded and saturated for integer depths.
+*/
+cv::Mat boxFilter(cv::Mat image, int k, BoxNormalization normalization = BOX_NORM_ZERO_PADDING,
+                  int depth = CV_32F);
+
+/**
+    Same as above into dst (which must not be image), reused when it already
+    has the size of image.
+*/
+void boxFilter(const cv::Mat &image, int k, cv::Mat &dst,
+               BoxNormalization normalization = BOX_NORM_ZERO_PADDING, int depth = CV_32F);
+
+#endif
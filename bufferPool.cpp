@@ -0,0 +1,153 @@
+#include "bufferPool.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+static atomic<int64_t> imageCount(0), imageBytes(0), scratchCount(0), scratchBytes(0);
+
+AllocationCounters allocationCounters()
+{
+    AllocationCounters res;
+    res.images = imageCount.load();
+    res.imageBytes = imageBytes.load();
+    res.scratchBlocks = scratchCount.load();
+    res.scratchBytes = scratchBytes.load();
+    return res;
+}
+
+void resetAllocationCounters()
+{
+    imageCount = 0;
+    imageBytes = 0;
+    scratchCount = 0;
+    scratchBytes = 0;
+}
+
+void ensureImage(Mat &image, int rows, int cols, int type)
+{
+    uchar *before = image.data;
+    image.create(rows, cols, type);
+    if (image.data != before) {
+        imageCount++;
+        imageBytes += (int64_t) image.step * image.rows;
+        traceCount(TRACE_ALLOCATIONS, 1);
+    }
+}
+
+/********************************************
+                SCRATCH ARENA
+*********************************************/
+
+static const size_t SCRATCH_ALIGN = 64;
+static const size_t SCRATCH_MIN_BLOCK = 1 << 16;
+
+void *ScratchArena::allocateBytes(size_t bytes)
+{
+    bytes = (bytes + SCRATCH_ALIGN - 1) / SCRATCH_ALIGN * SCRATCH_ALIGN;
+    // next block that can hold the request, a new one (twice the last) if none
+    while (current < blocks.size() && offset + bytes > sizes[current]) {
+        current++;
+        offset = 0;
+    }
+    if (current == blocks.size()) {
+        size_t size = max(max(bytes, SCRATCH_MIN_BLOCK), sizes.empty() ? 0 : 2 * sizes.back());
+        blocks.emplace_back(new unsigned char[size + SCRATCH_ALIGN]);
+        sizes.push_back(size);
+        scratchCount++;
+        scratchBytes += (int64_t) size;
+        traceCount(TRACE_ALLOCATIONS, 1);
+        offset = 0;
+    }
+    uintptr_t base = (uintptr_t) blocks[current].get();
+    uintptr_t aligned = (base + SCRATCH_ALIGN - 1) / SCRATCH_ALIGN * SCRATCH_ALIGN;
+    void *res = (void *) (aligned + offset);
+    offset += bytes;
+    return res;
+}
+
+void ScratchArena::release(const Mark &m)
+{
+    assert(m.block < current || (m.block == current && m.offset <= offset));
+    current = m.block;
+    offset = m.offset;
+
+    // back to empty with several blocks: merge them so that the next
+    // operation of the same size fits in the first one
+    if (current == 0 && offset == 0 && blocks.size() > 1) {
+        size_t total = 0;
+        for (size_t s : sizes)
+            total += s;
+        blocks.clear();
+        sizes.clear();
+        blocks.emplace_back(new unsigned char[total + SCRATCH_ALIGN]);
+        sizes.push_back(total);
+        scratchCount++;
+        scratchBytes += (int64_t) total;
+        traceCount(TRACE_ALLOCATIONS, 1);
+    }
+}
+
+size_t ScratchArena::capacity() const
+{
+    size_t total = 0;
+    for (size_t s : sizes)
+        total += s;
+    return total;
+}
+
+ScratchArena &threadScratch()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+/********************************************
+                 IMAGE POOL
+*********************************************/
+
+Mat ImagePool::acquire(int rows, int cols, int type)
+{
+    {
+        lock_guard<mutex> guard(lock);
+        for (size_t k = 0; k < images.size(); k++) {
+            if (images[k].rows == rows && images[k].cols == cols && images[k].type() == type) {
+                Mat res = images[k];
+                images.erase(images.begin() + k);
+                return res;
+            }
+        }
+    }
+    Mat res;
+    ensureImage(res, rows, cols, type);
+    return res;
+}
+
+void ImagePool::release(Mat &image)
+{
+    if (image.data != nullptr) {
+        lock_guard<mutex> guard(lock);
+        images.push_back(image);
+    }
+    image = Mat();
+}
+
+void ImagePool::clear()
+{
+    lock_guard<mutex> guard(lock);
+    images.clear();
+}
+
+size_t ImagePool::size() const
+{
+    lock_guard<mutex> guard(lock);
+    return images.size();
+}
+
+ImagePool &defaultImagePool()
+{
+    static ImagePool pool;
+    return pool;
+}
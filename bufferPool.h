@@ -0,0 +1,119 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+    Library buffers requested by the engines, counted since the last reset:
+    image buffers (ensureImage, ImagePool) and scratch blocks (ScratchArena).
+    Processing frames of the same size with reused destinations and buffers
+    must leave both counts at zero after the first frame. Heap calls outside
+    these buffers are not counted here: bench/benchAllocations counts them
+    by interposing malloc, and gates them at zero as well.
+*/
+struct AllocationCounters {
+    int64_t images = 0;
+    int64_t imageBytes = 0;
+    int64_t scratchBlocks = 0;
+    int64_t scratchBytes = 0;
+};
+
+AllocationCounters allocationCounters();
+void resetAllocationCounters();
+
+/**
+    image.create(rows, cols, type), counted when it had to allocate (the
+    buffer is kept when image already has that size and type).
+*/
+void ensureImage(cv::Mat &image, int rows, int cols, int type);
+
+/**
+    Stack of scratch memory: allocate() moves a pointer inside large blocks
+    that are kept from call to call, release() goes back to a mark. Once the
+    blocks have grown to the needs of an operation, running it again does no
+    allocation. Memory is not initialised.
+*/
+class ScratchArena {
+public:
+    struct Mark {
+        size_t block = 0, offset = 0;
+    };
+
+    template<typename T>
+    T *allocate(size_t n) {
+        return (T *) allocateBytes(n * sizeof(T));
+    }
+
+    Mark mark() const { return Mark{current, offset}; }
+
+    void release(const Mark &m);
+
+    size_t capacity() const;
+
+private:
+    void *allocateBytes(size_t bytes);
+
+    std::vector<std::unique_ptr<unsigned char[]>> blocks;
+    std::vector<size_t> sizes;
+    size_t current = 0, offset = 0;
+};
+
+/**
+    Arena of the calling thread (each worker of the pool has its own).
+*/
+ScratchArena &threadScratch();
+
+/**
+    Scratch memory of the calling thread, given back when the scope ends:
+
+        ScratchScope scratch;
+        float *row = scratch.allocate<float>(cols);
+*/
+class ScratchScope {
+public:
+    ScratchScope() : arena(threadScratch()), start(arena.mark()) {}
+    ~ScratchScope() { arena.release(start); }
+    ScratchScope(const ScratchScope &) = delete;
+    ScratchScope &operator=(const ScratchScope &) = delete;
+
+    template<typename T>
+    T *allocate(size_t n) {
+        return arena.allocate<T>(n);
+    }
+
+private:
+    ScratchArena &arena;
+    ScratchArena::Mark start;
+};
+
+/**
+    Images kept for reuse: acquire() hands out a released image of the same
+    size and type when there is one, and only allocates otherwise. Thread safe.
+*/
+class ImagePool {
+public:
+    cv::Mat acquire(int rows, int cols, int type);
+
+    /**
+        Gives the buffer of image back to the pool and empties image. The
+        buffer must not be used through other headers afterwards.
+    */
+    void release(cv::Mat &image);
+
+    void clear();
+
+    size_t size() const;
+
+private:
+    mutable std::mutex lock;
+    std::vector<cv::Mat> images;
+};
+
+ImagePool &defaultImagePool();
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef COMMON_H
+#define COMMON_H
+
+#include <opencv2/core.hpp>
+#include <cassert>
+#include <cstdio>
+
+#endif
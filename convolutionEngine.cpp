@@ -0,0 +1,467 @@
+#include "convolutionEngine.h"
+#include "fft.h"
+#include "simdKernels.h"
+#include "parallel.h"
+#include "bufferPool.h"
+#include "pixelTraits.h"
+#include "fixedKernels.h"
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <complex>
+#include <type_traits>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+// A kernel is separable when its best rank 1 approximation leaves a
+// residual below this fraction of its norm.
+static const double SEPARABLE_TOLERANCE = 1e-6;
+
+// Cost model constants, in floating point operations per unit of work.
+static const double COST_TAP = 2.0;            // one multiply-add
+static const double COST_FFT_BUTTERFLY = 5.0;  // per point and per log2(n) of a complex transform
+static const double COST_FFT_PRODUCT = 6.0;    // one complex multiplication
+static const double COST_FIXED_TAP = 1.0;      // one add (or multiply-add by a constant) of an unrolled tap
+
+/**
+    Leading singular triplet of the kernel by power iteration on K^T K.
+    For a rank 1 kernel it converges after one iteration.
+*/
+bool separableKernel(Mat kernel, Mat &column, Mat &row)
+{
+    assert(kernel.type() == CV_32FC1);
+    int h = kernel.rows;
+    int w = kernel.cols;
+
+    double norm2 = 0.0;
+    for (int m = 0; m < h; m++) {
+        for (int n = 0; n < w; n++) {
+            norm2 += (double) kernel.at<float>(m, n) * kernel.at<float>(m, n);
+        }
+    }
+    if (norm2 == 0.0)
+        return false;
+
+    // start from the kernel row of largest norm, which cannot be orthogonal to the leading singular vector
+    ScratchScope scratch;
+    double *v = scratch.allocate<double>(w);
+    double *u = scratch.allocate<double>(h);
+    int bestRow = 0;
+    double bestNorm = -1.0;
+    for (int m = 0; m < h; m++) {
+        double rowNorm = 0.0;
+        for (int n = 0; n < w; n++) {
+            rowNorm += (double) kernel.at<float>(m, n) * kernel.at<float>(m, n);
+        }
+        if (rowNorm > bestNorm) {
+            bestNorm = rowNorm;
+            bestRow = m;
+        }
+    }
+    for (int n = 0; n < w; n++) {
+        v[n] = kernel.at<float>(bestRow, n);
+    }
+
+    double sigma = 0.0;
+    for (int iter = 0; iter < 32; iter++) {
+        // u = K v, v = K^T u, both normalised
+        double uNorm = 0.0;
+        for (int m = 0; m < h; m++) {
+            u[m] = 0.0;
+            for (int n = 0; n < w; n++) {
+                u[m] += kernel.at<float>(m, n) * v[n];
+            }
+            uNorm += u[m] * u[m];
+        }
+        uNorm = sqrt(uNorm);
+        if (uNorm == 0.0)
+            return false;
+        for (int m = 0; m < h; m++) u[m] /= uNorm;
+
+        double vNorm = 0.0;
+        for (int n = 0; n < w; n++) {
+            v[n] = 0.0;
+            for (int m = 0; m < h; m++) {
+                v[n] += kernel.at<float>(m, n) * u[m];
+            }
+            vNorm += v[n] * v[n];
+        }
+        vNorm = sqrt(vNorm);
+        double previous = sigma;
+        sigma = vNorm;
+        for (int n = 0; n < w; n++) v[n] /= vNorm;
+        if (fabs(sigma - previous) <= 1e-12 * sigma)
+            break;
+    }
+
+    // ||K - sigma u v^T||^2 = ||K||^2 - sigma^2 for the leading triplet
+    double residual2 = 0.0;
+    for (int m = 0; m < h; m++) {
+        for (int n = 0; n < w; n++) {
+            double d = kernel.at<float>(m, n) - sigma * u[m] * v[n];
+            residual2 += d * d;
+        }
+    }
+    if (residual2 > SEPARABLE_TOLERANCE * SEPARABLE_TOLERANCE * norm2)
+        return false;
+
+    double s = sqrt(sigma);
+    column.create(h, 1, CV_32FC1);
+    row.create(1, w, CV_32FC1);
+    for (int m = 0; m < h; m++) {
+        column.at<float>(m, 0) = (float) (s * u[m]);
+    }
+    for (int n = 0; n < w; n++) {
+        row.at<float>(0, n) = (float) (s * v[n]);
+    }
+    return true;
+}
+
+/**
+    Direct convolution of an image of pixel type T into an image of pixel
+    type Out: vectorised loop over raw row pointers inside the image, every
+    tap goes through borderIndex only near the border. Sums are accumulated
+    in float (in a scratch row when Out is an integer type) and saturated
+    when stored.
+*/
+template<typename T, typename Out>
+static void directConvolution(const Mat &image, const Mat &kernel, Mat &res, PaddingMode padding) {
+    int ky = (kernel.rows - 1) / 2;
+    int kx = (kernel.cols - 1) / 2;
+    ensureImage(res, image.rows, image.cols, PixelTraits<Out>::depth);
+
+    auto interior = [&](int i, int j0, int j1) {
+        ScratchScope scratch;
+        float *acc = is_same<Out, float>::value ? (float *) res.ptr<Out>(i) : scratch.allocate<float>(image.cols);
+        fill(acc + j0, acc + j1, 0.0f);
+        for (int m = -ky; m <= ky; m++) {
+            rowTaps(image.ptr<T>(i + m), kernel.ptr<float>(m + ky) + kx, kx, acc, j0, j1);
+        }
+        if (!is_same<Out, float>::value)
+            storeRow(acc + j0, res.ptr<Out>(i) + j0, j1 - j0);
+    };
+    auto border = [&](int i, int j) {
+        float sum_px = 0.0;
+        forEachWindowSample<T>(image, i, j, ky, kx, padding, [&](int m, int n, float value) {
+            sum_px += value * kernel.at<float>(m + ky, n + kx);
+        });
+        res.at<Out>(i, j) = storePixel<Out>(sum_px);
+    };
+    parallel_for_2d(image.rows, image.cols, 2 * sizeof(float), [&](const Rect &tile) {
+        forEachPixelSplit(image.rows, image.cols, ky, kx, tile, interior, border);
+    });
+}
+
+/**
+    Two 1D passes: the rows by the row factor, then the columns by the column factor.
+    Padding maps rows and columns independently, so applying it in each pass
+    gives the 2D result. With a decimation d, the row pass only computes the
+    columns kept (every d-th) and the column pass only the rows kept.
+*/
+template<typename T, typename Out>
+static void separableConvolution(const Mat &image, const Mat &column, const Mat &row, Mat &res,
+                                 PaddingMode padding, int decimation, Mat *scratch) {
+    int ky = (column.rows - 1) / 2;
+    int kx = (row.cols - 1) / 2;
+    const float *kRow = row.ptr<float>(0) + kx;
+    int outRows = (image.rows + decimation - 1) / decimation;
+    int outCols = (image.cols + decimation - 1) / decimation;
+
+    Mat tmp;
+    if (scratch && scratch->type() == CV_32FC1 && scratch->rows >= image.rows && scratch->cols >= outCols) {
+        tmp = (*scratch)(Rect(0, 0, outCols, image.rows));
+    }
+    else {
+        ensureImage(tmp, image.rows, outCols, CV_32FC1);
+        if (scratch)
+            *scratch = tmp;
+    }
+
+    auto border = [&](int i, int x) {
+        const T *in = image.ptr<T>(i);
+        float sum_px = 0.0;
+        for (int n = -kx; n <= kx; n++) {
+            int xx = borderIndex(x + n, image.cols, padding);
+            if (xx >= 0)
+                sum_px += (float) in[xx] * kRow[n];
+        }
+        return sum_px;
+    };
+    if (decimation == 1) {
+        auto interior = [&](int i, int j0, int j1) {
+            float *out = tmp.ptr<float>(i);
+            fill(out + j0, out + j1, 0.0f);
+            rowTaps(image.ptr<T>(i), kRow, kx, out, j0, j1);
+        };
+        parallel_for_2d(image.rows, image.cols, 2 * sizeof(float), [&](const Rect &tile) {
+            forEachPixelSplit(image.rows, image.cols, 0, kx, tile, interior,
+                              [&](int i, int j) { tmp.at<float>(i, j) = border(i, j); });
+        });
+    }
+    else {
+        parallel_for_2d(image.rows, outCols, 2 * sizeof(float), [&](const Rect &tile) {
+            for (int i = tile.y; i < tile.y + tile.height; i++) {
+                const T *in = image.ptr<T>(i);
+                float *out = tmp.ptr<float>(i);
+                for (int j = tile.x; j < tile.x + tile.width; j++) {
+                    int x = j * decimation;
+                    if (x < kx || x + kx >= image.cols) {
+                        out[j] = border(i, x);
+                        continue;
+                    }
+                    float sum_px = 0.0;
+                    for (int n = -kx; n <= kx; n++)
+                        sum_px += (float) in[x + n] * kRow[n];
+                    out[j] = sum_px;
+                }
+            }
+        });
+    }
+
+    ensureImage(res, outRows, outCols, PixelTraits<Out>::depth);
+    parallel_for_2d(outRows, outCols, 2 * sizeof(float), [&](const Rect &tile) {
+        ScratchScope scratch;
+        float *row = is_same<Out, float>::value ? nullptr : scratch.allocate<float>(tile.width);
+        for (int i = tile.y; i < tile.y + tile.height; i++) {
+            float *out = row != nullptr ? row : (float *) res.ptr<Out>(i) + tile.x;
+            fill(out, out + tile.width, 0.0f);
+            for (int m = -ky; m <= ky; m++) {
+                int y = borderIndex(i * decimation + m, image.rows, padding);
+                if (y < 0)
+                    continue;
+                rowAxpy(tmp.ptr<float>(y) + tile.x, column.at<float>(m + ky, 0), out, tile.width);
+            }
+            if (row != nullptr)
+                storeRow(row, res.ptr<Out>(i) + tile.x, tile.width);
+        }
+    });
+}
+
+/**
+    Convolution by pointwise product of the transforms.
+
+    The image is zero padded to (P, Q) >= (rows + ky, cols + kx) so that the
+    circular convolution does not wrap around on the output domain.
+    The kernel is flipped and centered on (0, 0) since convolution() correlates
+    the image with the kernel.
+    Other padding modes are handled by explicitly padding the image and
+    cropping the result.
+*/
+static Mat fftConvolution(const Mat &input, const Mat &kernel, PaddingMode padding) {
+    int ky = (kernel.rows - 1) / 2;
+    int kx = (kernel.cols - 1) / 2;
+    Mat image = input;
+    if (image.type() != CV_32FC1)
+        input.convertTo(image, CV_32FC1);
+    if (padding != PAD_ZERO)
+        image = padImage(image, ky, kx, padding);
+    int P = fftGoodSize(image.rows + ky);
+    int Q = fftGoodSize(image.cols + kx);
+
+    vector<complex<double>> f(P * Q), g(P * Q);
+    for (int i = 0; i < image.rows; i++) {
+        for (int j = 0; j < image.cols; j++) {
+            f[i * Q + j] = image.at<float>(i, j);
+        }
+    }
+    for (int a = -ky; a <= ky; a++) {
+        for (int b = -kx; b <= kx; b++) {
+            g[((a + P) % P) * Q + (b + Q) % Q] = kernel.at<float>(ky - a, kx - b);
+        }
+    }
+
+    fft2D(f, P, Q);
+    fft2D(g, P, Q);
+    parallel_for_1d(P * Q, 1 << 16, [&](int begin, int end) {
+        for (int x = begin; x < end; x++) {
+            f[x] *= g[x];
+        }
+    });
+    fft2D(f, P, Q, true);
+
+    // the padded rows / columns are cropped out
+    int offsetY = padding == PAD_ZERO ? 0 : ky;
+    int offsetX = padding == PAD_ZERO ? 0 : kx;
+    Mat res(input.rows, input.cols, CV_32FC1);
+    for (int i = 0; i < input.rows; i++) {
+        for (int j = 0; j < input.cols; j++) {
+            res.at<float>(i, j) = (float) f[(i + offsetY) * Q + j + offsetX].real();
+        }
+    }
+    return res;
+}
+
+static double fftCost(int n) {
+    return COST_FFT_BUTTERFLY * n * log2((double) max(n, 2));
+}
+
+/**
+    Estimated floating point operations of each path, the cheapest one is kept.
+    The FFT path pays for 3 2D transforms (image, kernel, inverse) of the padded size.
+    The factors of a rank 1 kernel are left in column and row, so that the
+    separable path does not factor the kernel again.
+*/
+static ConvolutionStrategy chooseStrategy(Size imageSize, const Mat &kernel, Mat &column, Mat &row) {
+    double pixels = (double) imageSize.width * imageSize.height;
+    double direct = COST_TAP * kernel.rows * kernel.cols * pixels;
+
+    int P = fftGoodSize(imageSize.height + (kernel.rows - 1) / 2);
+    int Q = fftGoodSize(imageSize.width + (kernel.cols - 1) / 2);
+    double transform2D = P * fftCost(Q) + Q * fftCost(P);
+    double fourier = 3 * transform2D + COST_FFT_PRODUCT * P * Q;
+
+    ConvolutionStrategy best = CONV_DIRECT;
+    double bestCost = direct;
+
+    int fixedTaps = fixedKernelTaps(kernel);
+    if (fixedTaps > 0 && COST_FIXED_TAP * fixedTaps * pixels < bestCost) {
+        best = CONV_FIXED;
+        bestCost = COST_FIXED_TAP * fixedTaps * pixels;
+    }
+
+    if (kernel.rows * kernel.cols > 1 && separableKernel(kernel, column, row)) {
+        double separable = COST_TAP * (kernel.rows + kernel.cols) * pixels;
+        if (separable < bestCost) {
+            best = CONV_SEPARABLE;
+            bestCost = separable;
+        }
+    }
+    if (fourier < bestCost) {
+        best = CONV_FFT;
+    }
+    return best;
+}
+
+ConvolutionStrategy chooseConvolutionStrategy(Size imageSize, Mat kernel)
+{
+    Mat column, row;
+    return chooseStrategy(imageSize, kernel, column, row);
+}
+
+void convolve(const Mat &image, const Mat &kernel, Mat &dst, ConvolutionStrategy strategy, PaddingMode padding,
+              int depth)
+{
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1 || image.type() == CV_16UC1);
+    assert(depth == CV_32F || depth == CV_8U || depth == CV_16U);
+    assert(kernel.type() == CV_32FC1);
+    assert(kernel.rows % 2 == 1 && kernel.cols % 2 == 1);
+    assert(dst.data == nullptr || dst.data != image.data);
+
+    // factors of a rank 1 kernel, kept by the thread for the next calls
+    thread_local Mat column, row;
+    bool factored = false;
+    if (strategy == CONV_AUTO) {
+        strategy = chooseStrategy(image.size(), kernel, column, row);
+        factored = strategy == CONV_SEPARABLE;
+    }
+
+    switch (strategy) {
+    case CONV_SEPARABLE: {
+        bool separable = factored || separableKernel(kernel, column, row);
+        assert(separable && "CONV_SEPARABLE requires a rank 1 kernel");
+        if (separable) {
+            // intermediate image of the row pass, kept by the thread for the next calls
+            thread_local Mat pass;
+            dispatchDepth(image.depth(), [&](auto in) {
+                dispatchDepth(depth, [&](auto out) {
+                    separableConvolution<decltype(in), decltype(out)>(image, column, row, dst, padding, 1, &pass);
+                });
+            });
+            return;
+        }
+        break;
+    }
+    case CONV_FIXED: {
+        bool fixed = fixedConvolution(image, kernel, dst, padding, depth);
+        assert(fixed && "CONV_FIXED requires one of the fixed kernels");
+        if (fixed)
+            return;
+        break;
+    }
+    case CONV_FFT:
+        dst = fftConvolution(image, kernel, padding);
+        if (depth != CV_32F)
+            dst.convertTo(dst, depth);
+        return;
+    default:
+        break;
+    }
+    dispatchDepth(image.depth(), [&](auto in) {
+        dispatchDepth(depth, [&](auto out) {
+            directConvolution<decltype(in), decltype(out)>(image, kernel, dst, padding);
+        });
+    });
+}
+
+Mat convolve(Mat image, Mat kernel, ConvolutionStrategy strategy, PaddingMode padding, int depth)
+{
+    Mat res;
+    convolve(image, kernel, res, strategy, padding, depth);
+    return res;
+}
+
+void convolveSeparable(Mat image, Mat column, Mat row, Mat &res, PaddingMode padding, int decimation,
+                       Mat *scratch)
+{
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1 || image.type() == CV_16UC1);
+    assert(column.type() == CV_32FC1 && column.cols == 1 && column.rows % 2 == 1);
+    assert(row.type() == CV_32FC1 && row.rows == 1 && row.cols % 2 == 1);
+    assert(decimation >= 1);
+    assert(res.data == nullptr || res.data != image.data);
+    dispatchDepth(image.depth(), [&](auto in) {
+        separableConvolution<decltype(in), float>(image, column, row, res, padding, decimation, scratch);
+    });
+}
+
+/**
+    Fused Sobel pass of an image of pixel type T into an image of pixel type
+    Out, both derivatives are computed from the same three rows.
+*/
+template<typename T, typename Out>
+static void sobel(const Mat &image, Mat &res, PaddingMode padding) {
+    static const float sobel_x[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
+    static const float sobel_y[3][3] = {{1, 2, 1}, {0, 0, 0}, {-1, -2, -1}};
+    ensureImage(res, image.rows, image.cols, PixelTraits<Out>::depth);
+
+    auto interior = [&](int i, int j0, int j1) {
+        if (is_same<Out, float>::value) {
+            sobelRow(image.ptr<T>(i - 1), image.ptr<T>(i), image.ptr<T>(i + 1), (float *) res.ptr<Out>(i), j0, j1);
+            return;
+        }
+        ScratchScope scratch;
+        float *acc = scratch.allocate<float>(image.cols);
+        sobelRow(image.ptr<T>(i - 1), image.ptr<T>(i), image.ptr<T>(i + 1), acc, j0, j1);
+        storeRow(acc + j0, res.ptr<Out>(i) + j0, j1 - j0);
+    };
+    auto border = [&](int i, int j) {
+        float dfdx = 0.0, dfdy = 0.0;
+        forEachWindowSample<T>(image, i, j, 1, 1, padding, [&](int m, int n, float value) {
+            dfdx += value * sobel_x[m + 1][n + 1];
+            dfdy += value * sobel_y[m + 1][n + 1];
+        });
+        res.at<Out>(i, j) = storePixel<Out>(abs(dfdx) + abs(dfdy));
+    };
+    parallel_for_2d(image.rows, image.cols, 2 * sizeof(float), [&](const Rect &tile) {
+        forEachPixelSplit(image.rows, image.cols, 1, 1, tile, interior, border);
+    });
+}
+
+void sobelEdges(const Mat &image, Mat &dst, PaddingMode padding, int depth)
+{
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1 || image.type() == CV_16UC1);
+    assert(depth == CV_32F || depth == CV_8U || depth == CV_16U);
+    assert(dst.data == nullptr || dst.data != image.data);
+    dispatchDepth(image.depth(), [&](auto in) {
+        dispatchDepth(depth, [&](auto out) {
+            sobel<decltype(in), decltype(out)>(image, dst, padding);
+        });
+    });
+}
+
+Mat sobelEdges(Mat image, PaddingMode padding, int depth)
+{
+    Mat res;
+    sobelEdges(image, res, padding, depth);
+    return res;
+}
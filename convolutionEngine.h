@@ -0,0 +1,81 @@
+#ifndef CONVOLUTION_ENGINE_H
+#define CONVOLUTION_ENGINE_H
+
+#include <opencv2/core.hpp>
+#include "border.h"
+
+/**
+    Algorithm used to compute a convolution.
+
+    CONV_AUTO      : pick the cheapest of the paths below with a cost model.
+    CONV_DIRECT    : direct 2D loop, kernel.rows * kernel.cols taps per pixel.
+    CONV_SEPARABLE : two 1D passes, only valid for rank 1 kernels.
+    CONV_FFT       : pointwise product in the Fourier domain.
+    CONV_FIXED     : compile-time specialisation of the kernel (Sobel, Scharr,
+                     Laplacian, Gaussian 3/5/7, see fixedKernels.h), unrolled
+                     and skipping zero taps; only valid for those kernels.
+*/
+enum ConvolutionStrategy {
+    CONV_AUTO,
+    CONV_DIRECT,
+    CONV_SEPARABLE,
+    CONV_FFT,
+    CONV_FIXED
+};
+
+/**
+    Check whether kernel is of rank 1, ie. kernel = column * row.
+    When it is, the factors are returned in column (kernel.rows x 1) and row (1 x kernel.cols),
+    whose buffers are reused when they already have these sizes.
+*/
+bool separableKernel(cv::Mat kernel, cv::Mat &column, cv::Mat &row);
+
+/**
+    Strategy chosen by CONV_AUTO for a kernel applied on an image of the given size.
+*/
+ConvolutionStrategy chooseConvolutionStrategy(cv::Size imageSize, cv::Mat kernel);
+
+/**
+    Compute the convolution of an 8-bit, 16-bit or float image by a float kernel
+    of odd size. Result has the same size as image and the given depth (CV_32F,
+    CV_8U or CV_16U): sums are accumulated in float and rounded / saturated
+    when written to an integer image, so that 8-bit frames can be filtered
+    without a float copy of either the input or the output.
+
+    Pixel values outside of the image domain are given by the padding mode
+    (zero by default). Forcing CONV_SEPARABLE with a non separable kernel, or
+    CONV_FIXED with a kernel without specialisation, is an error.
+*/
+cv::Mat convolve(cv::Mat image, cv::Mat kernel, ConvolutionStrategy strategy = CONV_AUTO,
+                 PaddingMode padding = PAD_ZERO, int depth = CV_32F);
+
+/**
+    Same as above into dst (which must not be image), reused when it already
+    has the size of image. The direct and separable paths then do not
+    allocate any image, the FFT path always allocates its transforms.
+*/
+void convolve(const cv::Mat &image, const cv::Mat &kernel, cv::Mat &dst,
+              ConvolutionStrategy strategy = CONV_AUTO, PaddingMode padding = PAD_ZERO, int depth = CV_32F);
+
+/**
+    Separable convolution of an 8-bit, 16-bit or float image by column * row (float
+    kernels of odd size), written into the float image res.
+
+    Only every decimation-th row and column of the full result is computed,
+    so res is ceil(rows / decimation) x ceil(cols / decimation) (blur then
+    decimate in a single pass). res is reused when it already has that size,
+    and so is the intermediate image when scratch is given and large enough.
+*/
+void convolveSeparable(cv::Mat image, cv::Mat column, cv::Mat row, cv::Mat &res,
+                       PaddingMode padding = PAD_ZERO, int decimation = 1, cv::Mat *scratch = nullptr);
+
+/**
+    Sum of absolute partial derivatives |dx| + |dy| according to Sobel's method,
+    both derivatives being computed in the same pass.
+    Input is an 8-bit, 16-bit or float image, result an image of the given
+    depth (saturated for integer depths).
+*/
+cv::Mat sobelEdges(cv::Mat image, PaddingMode padding = PAD_ZERO, int depth = CV_32F);
+void sobelEdges(const cv::Mat &image, cv::Mat &dst, PaddingMode padding = PAD_ZERO, int depth = CV_32F);
+
+#endif
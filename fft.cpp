@@ -0,0 +1,137 @@
+#include "fft.h"
+#include "parallel.h"
+#include <cmath>
+#include <cassert>
+using namespace std;
+
+typedef complex<double> Complex;
+
+int fftGoodSize(int n)
+{
+    assert(n > 0);
+    for (int m = n; ; m++) {
+        int r = m;
+        while (r % 2 == 0) r /= 2;
+        while (r % 3 == 0) r /= 3;
+        while (r % 5 == 0) r /= 5;
+        if (r == 1)
+            return m;
+    }
+}
+
+static int smallestFactor(int n) {
+    for (int p : {2, 3, 5}) {
+        if (n % p == 0)
+            return p;
+    }
+    for (int p = 7; p * p <= n; p += 2) {
+        if (n % p == 0)
+            return p;
+    }
+    return n;
+}
+
+/**
+    Decimation in time Cooley-Tukey step : the n elements in[0], in[stride], ...
+    are split into p sub-sequences of size n/p whose transforms are combined
+    with the twiddle factors of the full size transform (w[j] = exp(+-2i.pi.j/N)).
+    Prime sizes other than 2, 3, 5 fall back to a direct DFT of size p.
+*/
+static void fftRecursive(const Complex *in, Complex *out, int n, int stride,
+                         const vector<Complex> &w, vector<Complex> &tmp) {
+    if (n == 1) {
+        out[0] = in[0];
+        return;
+    }
+    int N = (int) w.size();
+    int p = smallestFactor(n);
+    int m = n / p;
+
+    for (int r = 0; r < p; r++) {
+        fftRecursive(in + r * stride, out + r * m, m, stride * p, w, tmp);
+    }
+
+    int wStep = N / n;
+    for (int k = 0; k < m; k++) {
+        for (int r = 0; r < p; r++) {
+            tmp[r] = out[r * m + k];
+        }
+        for (int q = 0; q < p; q++) {
+            int index = k + q * m;
+            Complex sum = tmp[0];
+            for (int r = 1; r < p; r++) {
+                sum += tmp[r] * w[((long long) r * index * wStep) % N];
+            }
+            out[index] = sum;
+        }
+    }
+}
+
+static vector<Complex> twiddles(int n, bool inverse) {
+    double sign = inverse ? 1.0 : -1.0;
+    vector<Complex> w(n);
+    for (int j = 0; j < n; j++) {
+        w[j] = polar(1.0, sign * 2.0 * M_PI * j / n);
+    }
+    return w;
+}
+
+/**
+    Transform data in place with a precomputed twiddle table, out and tmp are
+    scratch buffers reused across the lines of a 2D transform.
+*/
+static void transform(vector<Complex> &data, const vector<Complex> &w,
+                      vector<Complex> &out, vector<Complex> &tmp, bool inverse) {
+    int n = (int) data.size();
+    out.resize(n);
+    tmp.resize(n);
+    fftRecursive(data.data(), out.data(), n, 1, w, tmp);
+
+    if (inverse) {
+        for (Complex &c : out) {
+            c /= (double) n;
+        }
+    }
+    data.swap(out);
+}
+
+void fft(vector<Complex> &data, bool inverse)
+{
+    int n = (int) data.size();
+    if (n <= 1)
+        return;
+
+    vector<Complex> out, tmp;
+    transform(data, twiddles(n, inverse), out, tmp, inverse);
+}
+
+void fft2D(vector<Complex> &data, int rows, int cols, bool inverse)
+{
+    assert((int) data.size() == rows * cols);
+    // lines are independent: each chunk of lines has its own scratch buffers
+    const int linesPerTask = 16;
+
+    vector<Complex> w = twiddles(cols, inverse);
+    parallel_for_1d(rows, linesPerTask, [&](int begin, int end) {
+        vector<Complex> line(cols), out, tmp;
+        for (int i = begin; i < end; i++) {
+            copy(data.begin() + i * cols, data.begin() + (i + 1) * cols, line.begin());
+            transform(line, w, out, tmp, inverse);
+            copy(line.begin(), line.end(), data.begin() + i * cols);
+        }
+    });
+
+    w = twiddles(rows, inverse);
+    parallel_for_1d(cols, linesPerTask, [&](int begin, int end) {
+        vector<Complex> line(rows), out, tmp;
+        for (int j = begin; j < end; j++) {
+            for (int i = 0; i < rows; i++) {
+                line[i] = data[i * cols + j];
+            }
+            transform(line, w, out, tmp, inverse);
+            for (int i = 0; i < rows; i++) {
+                data[i * cols + j] = line[i];
+            }
+        }
+    });
+}
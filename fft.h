@@ -0,0 +1,25 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <vector>
+
+/**
+    Smallest integer >= n whose only prime factors are 2, 3 and 5.
+    Transforms of such sizes only use the fast radix-2/3/5 butterflies.
+*/
+int fftGoodSize(int n);
+
+/**
+    In place discrete Fourier transform of data (any size, mixed radix).
+    The inverse transform is normalised by 1/n.
+*/
+void fft(std::vector<std::complex<double>> &data, bool inverse = false);
+
+/**
+    In place 2D discrete Fourier transform of a rows x cols row-major array.
+    The inverse transform is normalised by 1/(rows*cols).
+*/
+void fft2D(std::vector<std::complex<double>> &data, int rows, int cols, bool inverse = false);
+
+#endif
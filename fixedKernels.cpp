@@ -0,0 +1,172 @@
+#include "fixedKernels.h"
+#include "parallel.h"
+#include "bufferPool.h"
+#include "pixelTraits.h"
+#include "simdKernels.h"
+#include <type_traits>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FIXED_X86 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define FIXED_X86 0
+#endif
+
+/**
+    Fixed kernels and elements tried, in order, by the run time dispatchers.
+*/
+template<typename... K>
+struct FixedList {
+    /**
+        Calls f(K()) for the first K matching m, false if there is none.
+    */
+    template<typename F>
+    static bool dispatch(const Mat &m, F f) {
+        return ((K::matches(m) && (f(K()), true)) || ...);
+    }
+};
+
+typedef FixedList<SobelX, SobelY, ScharrX, ScharrY, Laplacian4, Laplacian8,
+                  Gaussian3, Gaussian5, Gaussian7> FixedKernels;
+typedef FixedList<Cross3, Square3> FixedElements;
+
+/**
+    Unrolled taps of one row segment (see fixedTaps), compiled for the base
+    instruction set and, on x86, once more for AVX2 (the inlined row loops
+    then use 8 lanes). The version follows simdLevel().
+*/
+template<typename K, typename Acc, typename T>
+static void fixedSegment(const T *const *rows, Acc *acc, int n) {
+    fixedTaps<K>(rows, acc, n);
+}
+
+#if FIXED_X86
+template<typename K, typename Acc, typename T>
+TARGET_AVX2 static void fixedSegmentAvx2(const T *const *rows, Acc *acc, int n) {
+    fixedTaps<K>(rows, acc, n);
+}
+#endif
+
+/**
+    Correlation of an image of pixel type T with K into an image of pixel
+    type Out. Inside the image each row segment takes one pass per non zero
+    kernel row with its taps unrolled (fixedTaps); near the border every tap
+    goes through borderIndex.
+*/
+template<typename K, typename T, typename Out>
+static void fixedConvolutionOf(const Mat &image, Mat &res, PaddingMode padding) {
+    typedef typename conditional<is_same<T, float>::value, float, int>::type Acc;
+    const int r = K::radius;
+    bool avx2 = simdLevel() == SIMD_AVX2;
+    ensureImage(res, image.rows, image.cols, PixelTraits<Out>::depth);
+
+    auto interior = [&](int i, int j0, int j1) {
+        const T *rows[K::size];
+        for (int m = 0; m < K::size; m++)
+            rows[m] = image.ptr<T>(i + m - r) + j0 - r;
+        ScratchScope scratch;
+        Acc *acc = scratch.allocate<Acc>(j1 - j0);
+#if FIXED_X86
+        if (avx2)
+            fixedSegmentAvx2<K>(rows, acc, j1 - j0);
+        else
+#endif
+            fixedSegment<K>(rows, acc, j1 - j0);
+        Out *out = res.ptr<Out>(i) + j0;
+        for (int j = 0; j < j1 - j0; j++)
+            out[j] = storePixel<Out>(K::scale * (float) acc[j]);
+    };
+    auto border = [&](int i, int j) {
+        float sum_px = 0.0;
+        forEachWindowSample<T>(image, i, j, r, r, padding, [&](int m, int n, float value) {
+            sum_px += value * (float) K::coefficient((m + r) * K::size + n + r);
+        });
+        res.at<Out>(i, j) = storePixel<Out>(K::scale * sum_px);
+    };
+    parallel_for_2d(image.rows, image.cols, 2 * sizeof(float), [&](const Rect &tile) {
+        forEachPixelSplit(image.rows, image.cols, r, r, tile, interior, border);
+    });
+}
+
+bool fixedConvolution(const Mat &image, const Mat &kernel, Mat &dst, PaddingMode padding, int depth)
+{
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1 || image.type() == CV_16UC1);
+    assert(depth == CV_32F || depth == CV_8U || depth == CV_16U);
+    assert(dst.data == nullptr || dst.data != image.data);
+    return FixedKernels::dispatch(kernel, [&](auto k) {
+        dispatchDepth(image.depth(), [&](auto in) {
+            dispatchDepth(depth, [&](auto out) {
+                fixedConvolutionOf<decltype(k), decltype(in), decltype(out)>(image, dst, padding);
+            });
+        });
+    });
+}
+
+int fixedKernelTaps(const Mat &kernel)
+{
+    int taps = 0;
+    FixedKernels::dispatch(kernel, [&](auto k) { taps = decltype(k)::nonZeroTaps(); });
+    return taps;
+}
+
+template<typename T>
+struct FixedMax {
+    static T neutral() { return PixelTraits<T>::lowest(); }
+    T operator()(T a, T b) const { return a > b ? a : b; }
+};
+
+template<typename T>
+struct FixedMin {
+    static T neutral() { return PixelTraits<T>::highest(); }
+    T operator()(T a, T b) const { return a < b ? a : b; }
+};
+
+/**
+    Dilation / erosion (Op) of an image of pixel type T by E in a single
+    pass: one unrolled extremum of the set pixels of E per output pixel.
+    Samples missing under the padding mode are ignored.
+*/
+template<typename E, typename T, typename Op>
+static void fixedMorphologyOf(const Mat &image, Mat &res, PaddingMode padding) {
+    const int r = E::radius;
+    ensureImage(res, image.rows, image.cols, image.type());
+
+    auto interior = [&](int i, int j0, int j1) {
+        const T *rows[E::size];
+        for (int m = 0; m < E::size; m++)
+            rows[m] = image.ptr<T>(i + m - r) - r;
+        T *out = res.ptr<T>(i);
+        for (int j = j0; j < j1; j++)
+            out[j] = fixedExtremum<E, Op>(rows, j, Op::neutral());
+    };
+    auto border = [&](int i, int j) {
+        T best = Op::neutral();
+        forEachWindowSample<T>(image, i, j, r, r, padding, [&](int m, int n, T value) {
+            if (E::inside((m + r) * E::size + n + r))
+                best = Op()(best, value);
+        });
+        res.at<T>(i, j) = best;
+    };
+    parallel_for_2d(image.rows, image.cols, 2 * sizeof(T), [&](const Rect &tile) {
+        forEachPixelSplit(image.rows, image.cols, r, r, tile, interior, border);
+    });
+}
+
+bool fixedMorphology(const Mat &image, const Mat &structuringElement, Mat &dst, PaddingMode padding,
+                     bool dilation)
+{
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1 || image.type() == CV_16UC1);
+    assert(dst.data == nullptr || dst.data != image.data);
+    return FixedElements::dispatch(structuringElement, [&](auto e) {
+        dispatchDepth(image.depth(), [&](auto pixel) {
+            typedef decltype(pixel) T;
+            if (dilation)
+                fixedMorphologyOf<decltype(e), T, FixedMax<T>>(image, dst, padding);
+            else
+                fixedMorphologyOf<decltype(e), T, FixedMin<T>>(image, dst, padding);
+        });
+    });
+}
@@ -0,0 +1,210 @@
+#ifndef FIXED_KERNELS_H
+#define FIXED_KERNELS_H
+
+#include <opencv2/core.hpp>
+#include "border.h"
+#include <algorithm>
+#include <utility>
+
+/**
+    Kernels whose size and coefficients are template parameters.
+
+    FixedKernel<Size, Divisor, C...> is the Size x Size kernel of integer
+    coefficients C (row major) divided by Divisor. The filters instantiated
+    for it unroll every tap at compile time, skip the zero coefficients and
+    multiply by +-1 for free; sums of integer images are exact integers and
+    only the final scaling is done in float.
+
+    FixedElement<Size, M...> is the Size x Size structuring element whose
+    pixels M (row major, 0 or 1) are set: dilation / erosion compare the
+    samples under the set pixels only.
+
+    The instances below cover the usual 3x3, 5x5 and 7x7 operators. A run
+    time cv::Mat kernel is routed to them by fixedConvolution and
+    fixedMorphology when its values are exactly those of an instance.
+*/
+template<int Size, int Divisor, int... C>
+struct FixedKernel {
+    static_assert(Size % 2 == 1 && (int) sizeof...(C) == Size * Size, "FixedKernel: Size x Size coefficients");
+    static constexpr int size = Size;
+    static constexpr int radius = Size / 2;
+    static constexpr int taps = Size * Size;
+    static constexpr int divisor = Divisor;
+    static constexpr float scale = 1.0f / Divisor;
+
+    static constexpr int coefficient(int t) {
+        constexpr int c[] = {C...};
+        return c[t];
+    }
+
+    static constexpr int nonZeroTaps() {
+        return ((C != 0) + ...);
+    }
+
+    /**
+        True when kernel (CV_32FC1) holds exactly the coefficients C / Divisor.
+    */
+    static bool matches(const cv::Mat &kernel) {
+        if (kernel.type() != CV_32FC1 || kernel.rows != Size || kernel.cols != Size)
+            return false;
+        for (int t = 0; t < taps; t++) {
+            if (kernel.at<float>(t / Size, t % Size) != (float) coefficient(t) / (float) Divisor)
+                return false;
+        }
+        return true;
+    }
+};
+
+template<int Size, int... M>
+struct FixedElement {
+    static_assert(Size % 2 == 1 && (int) sizeof...(M) == Size * Size, "FixedElement: Size x Size pixels");
+    static constexpr int size = Size;
+    static constexpr int radius = Size / 2;
+    static constexpr int taps = Size * Size;
+
+    static constexpr bool inside(int t) {
+        constexpr int m[] = {M...};
+        return m[t] != 0;
+    }
+
+    /**
+        True when the pixels of element (CV_32FC1) equal to 1 are exactly M.
+    */
+    static bool matches(const cv::Mat &element) {
+        if (element.type() != CV_32FC1 || element.rows != Size || element.cols != Size)
+            return false;
+        for (int t = 0; t < taps; t++) {
+            if ((element.at<float>(t / Size, t % Size) == 1) != inside(t))
+                return false;
+        }
+        return true;
+    }
+};
+
+typedef FixedKernel<3, 1, -1, 0, 1, -2, 0, 2, -1, 0, 1> SobelX;
+typedef FixedKernel<3, 1, 1, 2, 1, 0, 0, 0, -1, -2, -1> SobelY;
+typedef FixedKernel<3, 1, -3, 0, 3, -10, 0, 10, -3, 0, 3> ScharrX;
+typedef FixedKernel<3, 1, 3, 10, 3, 0, 0, 0, -3, -10, -3> ScharrY;
+typedef FixedKernel<3, 1, 0, 1, 0, 1, -4, 1, 0, 1, 0> Laplacian4;
+typedef FixedKernel<3, 1, 1, 1, 1, 1, -8, 1, 1, 1, 1> Laplacian8;
+typedef FixedKernel<3, 16, 1, 2, 1, 2, 4, 2, 1, 2, 1> Gaussian3;
+typedef FixedKernel<5, 256,
+                    1,  4,  6,  4, 1,
+                    4, 16, 24, 16, 4,
+                    6, 24, 36, 24, 6,
+                    4, 16, 24, 16, 4,
+                    1,  4,  6,  4, 1> Gaussian5;
+typedef FixedKernel<7, 4096,
+                    1,   6,  15,  20,  15,   6,  1,
+                    6,  36,  90, 120,  90,  36,  6,
+                   15,  90, 225, 300, 225,  90, 15,
+                   20, 120, 300, 400, 300, 120, 20,
+                   15,  90, 225, 300, 225,  90, 15,
+                    6,  36,  90, 120,  90,  36,  6,
+                    1,   6,  15,  20,  15,   6,  1> Gaussian7;
+
+typedef FixedElement<3, 0, 1, 0, 1, 1, 1, 0, 1, 0> Cross3;
+typedef FixedElement<3, 1, 1, 1, 1, 1, 1, 1, 1, 1> Square3;
+
+/**
+    sum += tap T of K times the sample in[n] (n = column of the tap):
+    nothing for a zero coefficient, an addition / subtraction for +-1.
+*/
+template<typename K, int T, typename Acc, typename P>
+inline void fixedTap(const P *in, int j, Acc &sum)
+{
+    constexpr int c = K::coefficient(T);
+    if constexpr (c == 1)
+        sum += (Acc) in[j + T % K::size];
+    else if constexpr (c == -1)
+        sum -= (Acc) in[j + T % K::size];
+    else if constexpr (c != 0)
+        sum += (Acc) c * (Acc) in[j + T % K::size];
+}
+
+template<typename K, int M>
+constexpr bool fixedRowIsZero(int n = 0)
+{
+    return n == K::size || (K::coefficient(M * K::size + n) == 0 && fixedRowIsZero<K, M>(n + 1));
+}
+
+/**
+    acc[j] (+)= taps of the row M of K over in[j, j + K::size), for j in
+    [0, n): one pass per kernel row, the taps of the row unrolled in the
+    loop body so that the compiler vectorises it along j. The first row
+    written (First) overwrites acc, rows of zeros are skipped.
+*/
+template<typename K, int M, bool First, typename Acc, typename P, int... N>
+inline void fixedRowTaps(const P *__restrict in, Acc *__restrict acc, int n, std::integer_sequence<int, N...>)
+{
+    for (int j = 0; j < n; j++) {
+        Acc sum = First ? 0 : acc[j];
+        (fixedTap<K, M * K::size + N>(in, j, sum), ...);
+        acc[j] = sum;
+    }
+}
+
+/**
+    acc[j] = sum of the taps of K over the window whose upper left sample
+    is rows[0][j], for j in [0, n). rows[m] points to the row m of the
+    window of pixel 0. Acc is the accumulator type (int for integer pixels,
+    float otherwise).
+*/
+template<typename K, int M = 0, bool First = true, typename Acc, typename P>
+inline void fixedTaps(const P *const *rows, Acc *acc, int n)
+{
+    if constexpr (M == K::size) {
+        if constexpr (First)
+            std::fill(acc, acc + n, (Acc) 0);
+    }
+    else if constexpr (fixedRowIsZero<K, M>()) {
+        fixedTaps<K, M + 1, First>(rows, acc, n);
+    }
+    else {
+        fixedRowTaps<K, M, First>(rows[M], acc, n, std::make_integer_sequence<int, K::size>());
+        fixedTaps<K, M + 1, false>(rows, acc, n);
+    }
+}
+
+/**
+    best = op(best, samples of E over the window of pixel j), every set
+    pixel of E unrolled.
+*/
+template<typename E, typename Op, typename P, int... T>
+inline P fixedExtremum(const P *const *rows, int j, P best, std::integer_sequence<int, T...>)
+{
+    Op op;
+    ((best = E::inside(T) ? op(best, rows[T / E::size][j + T % E::size]) : best), ...);
+    return best;
+}
+
+template<typename E, typename Op, typename P>
+inline P fixedExtremum(const P *const *rows, int j, P best)
+{
+    return fixedExtremum<E, Op>(rows, j, best, std::make_integer_sequence<int, E::taps>());
+}
+
+/**
+    Correlation of an 8-bit, 16-bit or float image with the first of the
+    fixed kernels above holding exactly the values of kernel, into dst of
+    the given depth (see convolve). Returns false, without touching dst,
+    when no fixed kernel matches.
+*/
+bool fixedConvolution(const cv::Mat &image, const cv::Mat &kernel, cv::Mat &dst,
+                      PaddingMode padding, int depth);
+
+/**
+    Number of non zero taps of the fixed kernel matching kernel, 0 when
+    there is none.
+*/
+int fixedKernelTaps(const cv::Mat &kernel);
+
+/**
+    Dilation (or erosion) of an 8-bit, 16-bit or float image by the first
+    fixed element matching structuringElement, with the conventions of
+    dilateFilter. Returns false, without touching dst, when none matches.
+*/
+bool fixedMorphology(const cv::Mat &image, const cv::Mat &structuringElement, cv::Mat &dst,
+                     PaddingMode padding, bool dilation);
+
+#endif
@@ -0,0 +1,490 @@
+#include "interpolation.h"
+#include "simdKernels.h"
+#include <cmath>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include <cassert>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_X86 0
+#endif
+
+using namespace cv;
+using namespace std;
+
+/**
+    Coordinate clamped to [0, maxV], in the order of min_ps / max_ps so that
+    the vector versions give the same result (a NaN goes to maxV).
+*/
+static inline float clampCoord(float v, float maxV) {
+    v = v < maxV ? v : maxV;
+    return v > 0 ? v : 0;
+}
+
+static inline int clampIndex(int v, int maxV) {
+    return v < 0 ? 0 : (v > maxV ? maxV : v);
+}
+
+// Keys cubic convolution with a = -0.5, in the order of the vector version
+static const float CUBIC_A = -0.5f;
+static const float CUBIC_5A = 5 * CUBIC_A;
+static const float CUBIC_8A = 8 * CUBIC_A;
+static const float CUBIC_4A = 4 * CUBIC_A;
+static const float CUBIC_A2 = CUBIC_A + 2;
+static const float CUBIC_A3 = CUBIC_A + 3;
+
+static inline void cubicWeights(float t, float w[4]) {
+    float t1 = t + 1.0f;
+    float u = 1.0f - t;
+    w[0] = ((CUBIC_A * t1 - CUBIC_5A) * t1 + CUBIC_8A) * t1 - CUBIC_4A;
+    w[1] = ((CUBIC_A2 * t - CUBIC_A3) * t) * t + 1.0f;
+    w[2] = ((CUBIC_A2 * u - CUBIC_A3) * u) * u + 1.0f;
+    w[3] = ((1.0f - w[0]) - w[1]) - w[2];
+}
+
+/**
+    Lanczos-3 weights of the pixels at offsets -2..3 for a sample at fraction t,
+    L(x) = 3 sin(pi x) sin(pi x / 3) / (pi x)^2 with x = t - offset. The sines
+    of all the taps come from sin(pi t), sin(pi t / 3) and cos(pi t / 3):
+        sin(pi (t + m)) = (-1)^m sin(pi t)
+        sin(pi (t + m) / 3) = sin(pi t / 3) cos(pi m / 3) + cos(pi t / 3) sin(pi m / 3)
+*/
+static inline void lanczosWeights(float t, float w[6]) {
+    static const float cosThird[6] = {-1.0f, -0.5f, 0.5f, 1.0f, 0.5f, -0.5f};       // m = -3..2
+    static const float sinThird[6] = {0.0f, -0.8660254f, -0.8660254f, 0.0f, 0.8660254f, 0.8660254f};
+    if (t == 0) {
+        for (int k = 0; k < 6; k++)
+            w[k] = k == 2 ? 1.0f : 0.0f;
+        return;
+    }
+    float s = sin((float) M_PI * t);
+    float s3 = sin((float) M_PI * t / 3.0f);
+    float c3 = cos((float) M_PI * t / 3.0f);
+    float sum = 0;
+    for (int k = 0; k < 6; k++) {
+        int m = 2 - k;
+        float x = t + m;
+        float sinX = (m & 1) ? -s : s;
+        float sinX3 = s3 * cosThird[m + 3] + c3 * sinThird[m + 3];
+        float px = (float) M_PI * x;
+        w[k] = 3.0f * sinX * sinX3 / (px * px);
+        sum += w[k];
+    }
+    for (int k = 0; k < 6; k++)
+        w[k] /= sum;
+}
+
+/********************************************
+            PORTABLE SCALAR KERNELS
+*********************************************/
+
+template<typename T>
+static void nearestScalar(const Mat &image, const float *xs, const float *ys, int k0, int n,
+                          float *out) {
+    float maxX = (float) (image.cols - 1);
+    float maxY = (float) (image.rows - 1);
+    for (int k = k0; k < n; k++) {
+        int j = (int) (clampCoord(xs[k], maxX) + 0.5f);
+        int i = (int) (clampCoord(ys[k], maxY) + 0.5f);
+        out[k] = (float) image.ptr<T>(i)[j];
+    }
+}
+
+template<typename T>
+static void bilinearScalar(const Mat &image, const float *xs, const float *ys, int k0, int n,
+                           float *out) {
+    float maxX = (float) (image.cols - 1);
+    float maxY = (float) (image.rows - 1);
+    for (int k = k0; k < n; k++) {
+        float x = clampCoord(xs[k], maxX);
+        float y = clampCoord(ys[k], maxY);
+        int j1 = (int) x;
+        int i1 = (int) y;
+        int j2 = min(j1 + 1, image.cols - 1);
+        int i2 = min(i1 + 1, image.rows - 1);
+        float dx = x - (float) j1;
+        float dy = y - (float) i1;
+        const T *r1 = image.ptr<T>(i1);
+        const T *r2 = image.ptr<T>(i2);
+        float p11 = (float) r1[j1], p12 = (float) r1[j2];
+        float p21 = (float) r2[j1], p22 = (float) r2[j2];
+        float left = p11 + (p21 - p11) * dy;
+        float right = p12 + (p22 - p12) * dy;
+        out[k] = left + (right - left) * dx;
+    }
+}
+
+/**
+    Separable kernel of Taps x Taps pixels, the first one at offset
+    1 - Taps / 2 from the pixel below the sample.
+*/
+template<typename T, int Taps, void (*Weights)(float, float *)>
+static void separableScalar(const Mat &image, const float *xs, const float *ys, int k0, int n,
+                            float *out) {
+    float maxX = (float) (image.cols - 1);
+    float maxY = (float) (image.rows - 1);
+    const int first = 1 - Taps / 2;
+    for (int k = k0; k < n; k++) {
+        float x = clampCoord(xs[k], maxX);
+        float y = clampCoord(ys[k], maxY);
+        int j0 = (int) x;
+        int i0 = (int) y;
+        float wx[Taps], wy[Taps];
+        Weights(x - (float) j0, wx);
+        Weights(y - (float) i0, wy);
+        int cols[Taps];
+        for (int c = 0; c < Taps; c++)
+            cols[c] = clampIndex(j0 + first + c, image.cols - 1);
+
+        float v = 0;
+        for (int r = 0; r < Taps; r++) {
+            const T *row = image.ptr<T>(clampIndex(i0 + first + r, image.rows - 1));
+            float s = 0;
+            for (int c = 0; c < Taps; c++)
+                s += (float) row[cols[c]] * wx[c];
+            v += s * wy[r];
+        }
+        out[k] = v;
+    }
+}
+
+#if SIMD_X86
+
+/********************************************
+                 AVX2 KERNELS
+*********************************************/
+
+/**
+    Clamped coordinates of 8 points and their integer parts.
+*/
+struct Points8 {
+    __m256 x, y;
+    __m256i j, i;
+};
+
+TARGET_AVX2 static inline Points8 loadPoints8(const float *xs, const float *ys, __m256 maxX,
+                                              __m256 maxY) {
+    Points8 p;
+    p.x = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(xs), maxX), _mm256_setzero_ps());
+    p.y = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(ys), maxY), _mm256_setzero_ps());
+    p.j = _mm256_cvttps_epi32(p.x);
+    p.i = _mm256_cvttps_epi32(p.y);
+    return p;
+}
+
+TARGET_AVX2 static inline __m256 gather8(const float *base, __m256i i, __m256i j, __m256i step) {
+    return _mm256_i32gather_ps(base, _mm256_add_epi32(_mm256_mullo_epi32(i, step), j), 4);
+}
+
+TARGET_AVX2 static void nearestAvx2(const Mat &image, const float *xs, const float *ys, int n,
+                                    float *out) {
+    const __m256 maxX = _mm256_set1_ps((float) (image.cols - 1));
+    const __m256 maxY = _mm256_set1_ps((float) (image.rows - 1));
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256i step = _mm256_set1_epi32((int) (image.step / sizeof(float)));
+    const float *base = image.ptr<float>(0);
+    int k = 0;
+    for (; k + 8 <= n; k += 8) {
+        Points8 p = loadPoints8(xs + k, ys + k, maxX, maxY);
+        __m256i j = _mm256_cvttps_epi32(_mm256_add_ps(p.x, half));
+        __m256i i = _mm256_cvttps_epi32(_mm256_add_ps(p.y, half));
+        _mm256_storeu_ps(out + k, gather8(base, i, j, step));
+    }
+    nearestScalar<float>(image, xs, ys, k, n, out);
+}
+
+TARGET_AVX2 static void bilinearAvx2(const Mat &image, const float *xs, const float *ys, int n,
+                                     float *out) {
+    const __m256 maxX = _mm256_set1_ps((float) (image.cols - 1));
+    const __m256 maxY = _mm256_set1_ps((float) (image.rows - 1));
+    const __m256i lastCol = _mm256_set1_epi32(image.cols - 1);
+    const __m256i lastRow = _mm256_set1_epi32(image.rows - 1);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i step = _mm256_set1_epi32((int) (image.step / sizeof(float)));
+    const float *base = image.ptr<float>(0);
+    int k = 0;
+    for (; k + 8 <= n; k += 8) {
+        Points8 p = loadPoints8(xs + k, ys + k, maxX, maxY);
+        __m256i j2 = _mm256_min_epi32(_mm256_add_epi32(p.j, one), lastCol);
+        __m256i i2 = _mm256_min_epi32(_mm256_add_epi32(p.i, one), lastRow);
+        __m256 dx = _mm256_sub_ps(p.x, _mm256_cvtepi32_ps(p.j));
+        __m256 dy = _mm256_sub_ps(p.y, _mm256_cvtepi32_ps(p.i));
+        __m256 p11 = gather8(base, p.i, p.j, step), p12 = gather8(base, p.i, j2, step);
+        __m256 p21 = gather8(base, i2, p.j, step), p22 = gather8(base, i2, j2, step);
+        __m256 left = _mm256_add_ps(p11, _mm256_mul_ps(_mm256_sub_ps(p21, p11), dy));
+        __m256 right = _mm256_add_ps(p12, _mm256_mul_ps(_mm256_sub_ps(p22, p12), dy));
+        _mm256_storeu_ps(out + k, _mm256_add_ps(left, _mm256_mul_ps(_mm256_sub_ps(right, left), dx)));
+    }
+    bilinearScalar<float>(image, xs, ys, k, n, out);
+}
+
+TARGET_AVX2 static inline void cubicWeights8(__m256 t, __m256 w[4]) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 a = _mm256_set1_ps(CUBIC_A), a5 = _mm256_set1_ps(CUBIC_5A);
+    const __m256 a8 = _mm256_set1_ps(CUBIC_8A), a4 = _mm256_set1_ps(CUBIC_4A);
+    const __m256 a2 = _mm256_set1_ps(CUBIC_A2), a3 = _mm256_set1_ps(CUBIC_A3);
+    __m256 t1 = _mm256_add_ps(t, one);
+    __m256 u = _mm256_sub_ps(one, t);
+    w[0] = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(
+               _mm256_mul_ps(a, t1), a5), t1), a8), t1), a4);
+    w[1] = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(a2, t), a3), t), t), one);
+    w[2] = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(a2, u), a3), u), u), one);
+    w[3] = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(one, w[0]), w[1]), w[2]);
+}
+
+TARGET_AVX2 static void bicubicAvx2(const Mat &image, const float *xs, const float *ys, int n,
+                                    float *out) {
+    const __m256 maxX = _mm256_set1_ps((float) (image.cols - 1));
+    const __m256 maxY = _mm256_set1_ps((float) (image.rows - 1));
+    const __m256i lastCol = _mm256_set1_epi32(image.cols - 1);
+    const __m256i lastRow = _mm256_set1_epi32(image.rows - 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i step = _mm256_set1_epi32((int) (image.step / sizeof(float)));
+    const float *base = image.ptr<float>(0);
+    int k = 0;
+    for (; k + 8 <= n; k += 8) {
+        Points8 p = loadPoints8(xs + k, ys + k, maxX, maxY);
+        __m256 wx[4], wy[4];
+        cubicWeights8(_mm256_sub_ps(p.x, _mm256_cvtepi32_ps(p.j)), wx);
+        cubicWeights8(_mm256_sub_ps(p.y, _mm256_cvtepi32_ps(p.i)), wy);
+        __m256i cols[4];
+        for (int c = 0; c < 4; c++) {
+            __m256i j = _mm256_add_epi32(p.j, _mm256_set1_epi32(c - 1));
+            cols[c] = _mm256_max_epi32(_mm256_min_epi32(j, lastCol), zero);
+        }
+
+        __m256 v = _mm256_setzero_ps();
+        for (int r = 0; r < 4; r++) {
+            __m256i i = _mm256_add_epi32(p.i, _mm256_set1_epi32(r - 1));
+            i = _mm256_max_epi32(_mm256_min_epi32(i, lastRow), zero);
+            __m256 s = _mm256_setzero_ps();
+            for (int c = 0; c < 4; c++)
+                s = _mm256_add_ps(s, _mm256_mul_ps(gather8(base, i, cols[c], step), wx[c]));
+            v = _mm256_add_ps(v, _mm256_mul_ps(s, wy[r]));
+        }
+        _mm256_storeu_ps(out + k, v);
+    }
+    separableScalar<float, 4, cubicWeights>(image, xs, ys, k, n, out);
+}
+
+/**
+    Gathers index pixels with 32-bit offsets from the start of the image.
+*/
+static bool gatherable(const Mat &image) {
+    return image.type() == CV_32FC1 && image.rows * (double) image.step < INT_MAX;
+}
+
+#endif
+
+void interpolate(const Mat &image, const float *xs, const float *ys, int n, float *out,
+                 Interpolation interpolation)
+{
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1);
+    assert(image.rows > 0 && image.cols > 0);
+#if SIMD_X86
+    if (simdLevel() == SIMD_AVX2 && gatherable(image)) {
+        switch (interpolation) {
+        case INTERP_NEAREST:
+            return nearestAvx2(image, xs, ys, n, out);
+        case INTERP_BILINEAR:
+            return bilinearAvx2(image, xs, ys, n, out);
+        case INTERP_BICUBIC:
+            return bicubicAvx2(image, xs, ys, n, out);
+        default:
+            break;
+        }
+    }
+#endif
+    bool isFloat = image.type() == CV_32FC1;
+    switch (interpolation) {
+    case INTERP_NEAREST:
+        return isFloat ? nearestScalar<float>(image, xs, ys, 0, n, out)
+                       : nearestScalar<uchar>(image, xs, ys, 0, n, out);
+    case INTERP_BILINEAR:
+        return isFloat ? bilinearScalar<float>(image, xs, ys, 0, n, out)
+                       : bilinearScalar<uchar>(image, xs, ys, 0, n, out);
+    case INTERP_BICUBIC:
+        return isFloat ? separableScalar<float, 4, cubicWeights>(image, xs, ys, 0, n, out)
+                       : separableScalar<uchar, 4, cubicWeights>(image, xs, ys, 0, n, out);
+    case INTERP_LANCZOS3:
+        return isFloat ? separableScalar<float, 6, lanczosWeights>(image, xs, ys, 0, n, out)
+                       : separableScalar<uchar, 6, lanczosWeights>(image, xs, ys, 0, n, out);
+    default:
+        assert(false && "interpolate: unknown interpolation");
+    }
+}
+
+/********************************************
+             16-BIT FIXED POINT
+*********************************************/
+
+static const int SUBPIXEL_BITS = 5;
+static const int SUBPIXELS = 1 << SUBPIXEL_BITS;
+static const int WEIGHT_BITS = 14;
+static const int WEIGHT_ONE = 1 << WEIGHT_BITS;
+
+/**
+    Q14 weights of the Taps x Taps pixels of every (fy, fx) sub-pixel
+    position, row major, at index ((fy * SUBPIXELS + fx) * Taps + r) * Taps + c.
+*/
+template<int Taps>
+struct FixedTable {
+    vector<int16_t> w;
+
+    explicit FixedTable(void (*weights)(float, float *)) : w(SUBPIXELS * SUBPIXELS * Taps * Taps) {
+        float w1[SUBPIXELS][Taps];
+        for (int f = 0; f < SUBPIXELS; f++)
+            weights(f / (float) SUBPIXELS, w1[f]);
+
+        for (int fy = 0; fy < SUBPIXELS; fy++) {
+            for (int fx = 0; fx < SUBPIXELS; fx++) {
+                int16_t *cell = &w[(fy * SUBPIXELS + fx) * Taps * Taps];
+                int sum = 0, largest = 0;
+                for (int t = 0; t < Taps * Taps; t++) {
+                    cell[t] = (int16_t) lround(w1[fy][t / Taps] * w1[fx][t % Taps] * WEIGHT_ONE);
+                    sum += cell[t];
+                    if (cell[t] > cell[largest]) largest = t;
+                }
+                // rounding errors go to the largest weight, so that flat areas stay flat
+                cell[largest] += WEIGHT_ONE - sum;
+            }
+        }
+    }
+};
+
+static void linearWeights(float t, float w[2]) {
+    w[0] = 1.0f - t;
+    w[1] = t;
+}
+
+static inline uchar fixedToPixel(int acc) {
+    int v = (acc + WEIGHT_ONE / 2) >> WEIGHT_BITS;
+    return (uchar) (v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+/**
+    Quantised coordinate: pixel below it and sub-pixel position.
+*/
+static inline void quantise(float v, float maxV, int &index, int &fraction) {
+    int q = (int) (clampCoord(v, maxV) * SUBPIXELS + 0.5f);
+    index = q >> SUBPIXEL_BITS;
+    fraction = q & (SUBPIXELS - 1);
+}
+
+template<int Taps>
+static void fixedScalar(const Mat &image, const FixedTable<Taps> &table, const float *xs,
+                        const float *ys, int k0, int n, uchar *out) {
+    float maxX = (float) (image.cols - 1);
+    float maxY = (float) (image.rows - 1);
+    const int first = 1 - Taps / 2;
+    for (int k = k0; k < n; k++) {
+        int j0, fx, i0, fy;
+        quantise(xs[k], maxX, j0, fx);
+        quantise(ys[k], maxY, i0, fy);
+        const int16_t *w = &table.w[(fy * SUBPIXELS + fx) * Taps * Taps];
+        int cols[Taps];
+        for (int c = 0; c < Taps; c++)
+            cols[c] = clampIndex(j0 + first + c, image.cols - 1);
+
+        int acc = 0;
+        for (int r = 0; r < Taps; r++) {
+            const uchar *row = image.ptr<uchar>(clampIndex(i0 + first + r, image.rows - 1));
+            for (int c = 0; c < Taps; c++)
+                acc += row[cols[c]] * w[r * Taps + c];
+        }
+        out[k] = fixedToPixel(acc);
+    }
+}
+
+#if SIMD_X86
+
+/**
+    Bilinear case: the pixel pairs (p11, p12) and (p21, p22) of 8 points are
+    packed as int16 pairs and multiplied by their weight pairs with pmaddwd.
+*/
+TARGET_AVX2 static void bilinearFixedAvx2(const Mat &image, const FixedTable<2> &table,
+                                          const float *xs, const float *ys, int n, uchar *out) {
+    const __m256 scaleX = _mm256_set1_ps((float) SUBPIXELS);
+    const __m256 maxX = _mm256_set1_ps((float) (image.cols - 1));
+    const __m256 maxY = _mm256_set1_ps((float) (image.rows - 1));
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256i fractionMask = _mm256_set1_epi32(SUBPIXELS - 1);
+    const __m256i rounding = _mm256_set1_epi32(WEIGHT_ONE / 2);
+    const int *weights = (const int *) table.w.data(); // (w11, w12), (w21, w22) per cell
+    alignas(32) int j1[8], i1[8];
+    alignas(32) int top[8], bottom[8];
+    int k = 0;
+    for (; k + 8 <= n; k += 8) {
+        Points8 p = loadPoints8(xs + k, ys + k, maxX, maxY);
+        __m256i qx = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(p.x, scaleX), half));
+        __m256i qy = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(p.y, scaleX), half));
+        _mm256_store_si256((__m256i *) j1, _mm256_srli_epi32(qx, SUBPIXEL_BITS));
+        _mm256_store_si256((__m256i *) i1, _mm256_srli_epi32(qy, SUBPIXEL_BITS));
+        __m256i cell = _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(qy, fractionMask), SUBPIXEL_BITS),
+                                        _mm256_and_si256(qx, fractionMask));
+        __m256i cell2 = _mm256_add_epi32(cell, cell);
+        __m256i wTop = _mm256_i32gather_epi32(weights, cell2, 4);
+        __m256i wBottom = _mm256_i32gather_epi32(weights + 1, cell2, 4);
+
+        for (int l = 0; l < 8; l++) {
+            int j2 = min(j1[l] + 1, image.cols - 1);
+            const uchar *r1 = image.ptr<uchar>(i1[l]);
+            const uchar *r2 = image.ptr<uchar>(min(i1[l] + 1, image.rows - 1));
+            top[l] = r1[j1[l]] | (r1[j2] << 16);
+            bottom[l] = r2[j1[l]] | (r2[j2] << 16);
+        }
+        __m256i acc = _mm256_add_epi32(_mm256_madd_epi16(_mm256_load_si256((const __m256i *) top), wTop),
+                                       _mm256_madd_epi16(_mm256_load_si256((const __m256i *) bottom), wBottom));
+        __m256i v = _mm256_srai_epi32(_mm256_add_epi32(acc, rounding), WEIGHT_BITS);
+        __m256i v16 = _mm256_packus_epi32(v, v);
+        __m256i v8 = _mm256_packus_epi16(v16, v16);
+        uint32_t lo = (uint32_t) _mm256_extract_epi32(v8, 0);
+        uint32_t hi = (uint32_t) _mm256_extract_epi32(v8, 4);
+        __builtin_memcpy(out + k, &lo, 4);
+        __builtin_memcpy(out + k + 4, &hi, 4);
+    }
+    fixedScalar<2>(image, table, xs, ys, k, n, out);
+}
+
+#endif
+
+void interpolateFixed(const Mat &image, const float *xs, const float *ys, int n, uchar *out,
+                      Interpolation interpolation)
+{
+    assert(image.type() == CV_8UC1);
+    assert(image.rows > 0 && image.cols > 0);
+    static const FixedTable<2> linearTable(linearWeights);
+    static const FixedTable<4> cubicTable(cubicWeights);
+    static const FixedTable<6> lanczosTable(lanczosWeights);
+
+    switch (interpolation) {
+    case INTERP_NEAREST: {
+        float maxX = (float) (image.cols - 1);
+        float maxY = (float) (image.rows - 1);
+        for (int k = 0; k < n; k++) {
+            int j = (int) (clampCoord(xs[k], maxX) + 0.5f);
+            int i = (int) (clampCoord(ys[k], maxY) + 0.5f);
+            out[k] = image.ptr<uchar>(i)[j];
+        }
+        break;
+    }
+    case INTERP_BILINEAR:
+#if SIMD_X86
+        if (simdLevel() == SIMD_AVX2)
+            return bilinearFixedAvx2(image, linearTable, xs, ys, n, out);
+#endif
+        return fixedScalar<2>(image, linearTable, xs, ys, 0, n, out);
+    case INTERP_BICUBIC:
+        return fixedScalar<4>(image, cubicTable, xs, ys, 0, n, out);
+    case INTERP_LANCZOS3:
+        return fixedScalar<6>(image, lanczosTable, xs, ys, 0, n, out);
+    default:
+        assert(false && "interpolateFixed: unknown interpolation");
+    }
+}
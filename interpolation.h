@@ -0,0 +1,48 @@
+#ifndef INTERPOLATION_H
+#define INTERPOLATION_H
+
+#include <opencv2/core.hpp>
+
+/**
+    Interpolation kernel used to read an image at real coordinates.
+
+    INTERP_NEAREST  : value of the closest pixel.
+    INTERP_BILINEAR : linear interpolation between the 2x2 surrounding pixels.
+    INTERP_BICUBIC  : Keys cubic convolution (a = -0.5) over 4x4 pixels.
+    INTERP_LANCZOS3 : windowed sinc of radius 3 over 6x6 pixels, the weights
+                      being normalised to sum to 1.
+*/
+enum Interpolation {
+    INTERP_NEAREST,
+    INTERP_BILINEAR,
+    INTERP_BICUBIC,
+    INTERP_LANCZOS3
+};
+
+/**
+    out[k] = image read at (xs[k], ys[k]) (x = column, y = row) for k in [0, n).
+    image is CV_32FC1 or CV_8UC1.
+
+    Coordinates are clamped to [0, cols-1] x [0, rows-1] and the neighbours of
+    a sample beyond the last row or column replicate it, so no pixel outside
+    of the image is ever read.
+
+    Nearest, bilinear and bicubic have an AVX2 version handling 8 points per
+    instruction (hardware gathers), selected with the level of simdKernels.h;
+    it performs the same operations in the same order as the scalar version,
+    so results are bit identical. Lanczos-3 is scalar.
+*/
+void interpolate(const cv::Mat &image, const float *xs, const float *ys, int n, float *out,
+                 Interpolation interpolation);
+
+/**
+    Same as above for CV_8UC1 images in 16-bit fixed point: coordinates are
+    quantised to 1/32 pixel and the 2D weights of each of the 32x32 sub-pixel
+    positions are tabulated once as int16 in Q14 (summing to exactly 1 << 14).
+    Samples are rounded and saturated to [0, 255]. The bilinear case has an
+    AVX2 version (pmaddwd on pixel and weight pairs).
+*/
+void interpolateFixed(const cv::Mat &image, const float *xs, const float *ys, int n,
+                      uchar *out, Interpolation interpolation);
+
+#endif
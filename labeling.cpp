@@ -0,0 +1,551 @@
+#include "labeling.h"
+#include "unionFind.h"
+#include "statsAccumulator.h"
+#include "parallel.h"
+#include "bufferPool.h"
+#include "trace.h"
+#include <algorithm>
+#include <vector>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+/**
+    Adds pixel (i, j) of a component, with its pairs to the left and upper
+    pixels: in both connectivities, 4 adjacent present pixels share a component.
+*/
+template<typename T>
+static inline void addPixel(StatsAccumulator &acc, const T *in, const T *above, int i, int j) {
+    acc.addSpan(i, j, j);
+    acc.pairs += (j > 0 && in[j - 1] != 0) + (above != nullptr && above[j] != 0);
+}
+
+static void finishStats(const vector<StatsAccumulator> &acc, vector<ComponentStats> &stats) {
+    stats.resize(acc.size());
+    stats[0] = ComponentStats();
+    for (int k = 1; k < (int) acc.size(); k++)
+        stats[k] = acc[k].stats();
+}
+
+/**
+    First pass with 4 connectivity: provisional label of each pixel from its
+    upper and left neighbours, equivalences recorded in the forest.
+*/
+template<typename T>
+static void firstPass4(const Mat &image, Mat &labels, UnionFind &forest) {
+    for (int i = 0; i < image.rows; i++) {
+        const T *in = image.ptr<T>(i);
+        const int *above = i > 0 ? labels.ptr<int>(i - 1) : nullptr;
+        int *out = labels.ptr<int>(i);
+        for (int j = 0; j < image.cols; j++) {
+            if (in[j] == 0) {
+                out[j] = 0;
+                continue;
+            }
+            int up = above ? above[j] : 0;
+            int left = j > 0 ? out[j - 1] : 0;
+            if (up) {
+                out[j] = up;
+                if (left && left != up) forest.unite(up, left);
+            }
+            else if (left) {
+                out[j] = left;
+            }
+            else {
+                out[j] = forest.makeSet();
+            }
+        }
+    }
+}
+
+/**
+    First pass with 8 connectivity on 2x2 blocks. The provisional label of a
+    block is stored on its upper left pixel (0 for an empty block), the other
+    pixels are written by the second pass.
+
+    With X the current block, P, Q, R its upper left, upper and upper right
+    neighbours and S its left one:
+        P Q R
+        S X
+    X touches Q when the top row of X and the bottom row of Q both hold a
+    pixel, S when the left column of X and the right column of S do, P and R
+    only through the corner pixels. The first connected block gives the label,
+    the next ones are merged into it.
+*/
+template<typename T>
+static void firstPass8(const Mat &image, Mat &labels, UnionFind &forest) {
+    int rows = image.rows;
+    int cols = image.cols;
+    auto present = [cols](const T *row, int j) {
+        return row != nullptr && j >= 0 && j < cols && row[j] != 0;
+    };
+
+    for (int r = 0; r < rows; r += 2) {
+        const T *prev = r > 0 ? image.ptr<T>(r - 1) : nullptr;
+        const T *top = image.ptr<T>(r);
+        const T *bottom = r + 1 < rows ? image.ptr<T>(r + 1) : nullptr;
+        const int *blocksAbove = r > 0 ? labels.ptr<int>(r - 2) : nullptr;
+        int *blocks = labels.ptr<int>(r);
+
+        for (int c = 0; c < cols; c += 2) {
+            bool x00 = top[c] != 0;
+            bool x01 = present(top, c + 1);
+            bool x10 = present(bottom, c);
+            bool x11 = present(bottom, c + 1);
+            if (!(x00 || x01 || x10 || x11)) {
+                blocks[c] = 0;
+                continue;
+            }
+
+            int label = 0;
+            auto link = [&](int neighbour) {
+                if (label == 0) label = neighbour;
+                else if (neighbour != label) label = forest.unite(label, neighbour);
+            };
+            if ((x00 || x01) && (present(prev, c) || present(prev, c + 1)))
+                link(blocksAbove[c]);
+            if (x00 && present(prev, c - 1))
+                link(blocksAbove[c - 2]);
+            if (x01 && present(prev, c + 2))
+                link(blocksAbove[c + 2]);
+            if ((x00 || x10) && (present(top, c - 1) || present(bottom, c - 1)))
+                link(blocks[c - 2]);
+
+            blocks[c] = label ? label : forest.makeSet();
+        }
+    }
+}
+
+/**
+    Second pass: final labels are given to the roots of the forest in the order
+    in which the raster scan meets them. Statistics are accumulated in acc
+    (indexed by final label) when it is not null, image row 0 standing for
+    row rowOffset.
+*/
+template<typename T>
+static int secondPass4(const Mat &image, Mat &labels, UnionFind &forest,
+                       vector<StatsAccumulator> *acc, int rowOffset = 0) {
+    forest.flatten();
+    vector<int> finalLabel(forest.size(), 0);
+    int count = 0;
+    for (int i = 0; i < labels.rows; i++) {
+        const T *in = image.ptr<T>(i);
+        const T *above = i > 0 ? image.ptr<T>(i - 1) : nullptr;
+        int *out = labels.ptr<int>(i);
+        for (int j = 0; j < labels.cols; j++) {
+            if (out[j] == 0) continue;
+            int root = forest.find(out[j]);
+            if (finalLabel[root] == 0) {
+                finalLabel[root] = ++count;
+                if (acc) acc->emplace_back();
+            }
+            out[j] = finalLabel[root];
+            if (acc) addPixel((*acc)[out[j]], in, above, i + rowOffset, j);
+        }
+    }
+    return count;
+}
+
+template<typename T>
+static int secondPass8(const Mat &image, Mat &labels, UnionFind &forest,
+                       vector<StatsAccumulator> *acc, int rowOffset = 0) {
+    forest.flatten();
+    vector<int> finalLabel(forest.size(), 0);
+    vector<int> blocks((labels.cols + 1) / 2);
+    int count = 0;
+    for (int r = 0; r < labels.rows; r += 2) {
+        const int *blockRow = labels.ptr<int>(r);
+        for (int b = 0; b < (int) blocks.size(); b++)
+            blocks[b] = blockRow[2 * b];
+
+        for (int i = r; i < min(r + 2, labels.rows); i++) {
+            const T *in = image.ptr<T>(i);
+            const T *above = i > 0 ? image.ptr<T>(i - 1) : nullptr;
+            int *out = labels.ptr<int>(i);
+            for (int j = 0; j < labels.cols; j++) {
+                if (in[j] == 0) {
+                    out[j] = 0;
+                    continue;
+                }
+                int root = forest.find(blocks[j >> 1]);
+                if (finalLabel[root] == 0) {
+                    finalLabel[root] = ++count;
+                    if (acc) acc->emplace_back();
+                }
+                out[j] = finalLabel[root];
+                if (acc) addPixel((*acc)[out[j]], in, above, i + rowOffset, j);
+            }
+        }
+    }
+    return count;
+}
+
+template<typename T>
+static int labelComponentsOf(const Mat &image, Mat &labels, Connectivity connectivity,
+                             vector<ComponentStats> *stats) {
+    UnionFind forest;
+    vector<StatsAccumulator> acc(1);
+    int count;
+    if (connectivity == CONNECTIVITY_4) {
+        firstPass4<T>(image, labels, forest);
+        count = secondPass4<T>(image, labels, forest, stats ? &acc : nullptr);
+    }
+    else {
+        firstPass8<T>(image, labels, forest);
+        count = secondPass8<T>(image, labels, forest, stats ? &acc : nullptr);
+    }
+    if (stats) finishStats(acc, *stats);
+    traceCount(TRACE_MERGES, forest.merges());
+    traceCount(TRACE_COMPONENTS, count);
+    return count;
+}
+
+template<typename T>
+static int floodFillOf(const Mat &image, Mat &labels, int i, int j, int label,
+                       vector<Point2i> &stack, ComponentStats *stats) {
+    const T value = image.at<T>(i, j);
+    StatsAccumulator acc;
+    stack.clear();
+    stack.push_back(Point2i(j, i));
+    while (!stack.empty()) {
+        Point2i seed = stack.back();
+        stack.pop_back();
+        const T *in = image.ptr<T>(seed.y);
+        int *out = labels.ptr<int>(seed.y);
+        if (out[seed.x] != 0) continue;
+
+        int left = seed.x;
+        int right = seed.x;
+        while (left > 0 && in[left - 1] == value && out[left - 1] == 0) left--;
+        while (right + 1 < image.cols && in[right + 1] == value && out[right + 1] == 0) right++;
+        for (int x = left; x <= right; x++)
+            out[x] = label;
+        acc.addSpan(seed.y, left, right);
+        acc.pairs += right - left;
+
+        // One seed per run of unlabeled pixels of the value above and below the
+        // span. Pairs with the row above are counted here, the ones with the row
+        // below when that row is filled.
+        for (int y = seed.y - 1; y <= seed.y + 1; y += 2) {
+            if (y < 0 || y >= image.rows) continue;
+            const T *nextIn = image.ptr<T>(y);
+            const int *nextOut = labels.ptr<int>(y);
+            bool inRun = false;
+            for (int x = left; x <= right; x++) {
+                bool same = nextIn[x] == value;
+                if (y < seed.y) acc.pairs += same;
+                bool open = same && nextOut[x] == 0;
+                if (open && !inRun) stack.push_back(Point2i(x, y));
+                inRun = open;
+            }
+        }
+    }
+    if (stats) *stats = acc.stats();
+    return (int) acc.area;
+}
+
+int floodFillLabel(Mat image, Mat &labels, int i, int j, int label, vector<Point2i> &stack,
+                   ComponentStats *stats)
+{
+    assert(image.channels() == 1 && labels.type() == CV_32SC1);
+    assert(labels.rows == image.rows && labels.cols == image.cols);
+    assert(label != 0);
+    switch (image.depth()) {
+    case CV_8U:
+        return floodFillOf<uchar>(image, labels, i, j, label, stack, stats);
+    case CV_16U:
+        return floodFillOf<ushort>(image, labels, i, j, label, stack, stats);
+    case CV_32S:
+        return floodFillOf<int>(image, labels, i, j, label, stack, stats);
+    case CV_32F:
+        return floodFillOf<float>(image, labels, i, j, label, stack, stats);
+    default:
+        assert(false && "floodFillLabel: unsupported image depth");
+        return 0;
+    }
+}
+
+int labelComponents(Mat image, Mat &labels, Connectivity connectivity,
+                    vector<ComponentStats> *stats)
+{
+    TraceScope scope("labelComponents");
+    assert(image.channels() == 1);
+    assert(connectivity == CONNECTIVITY_4 || connectivity == CONNECTIVITY_8);
+    ensureImage(labels, image.rows, image.cols, CV_32SC1);
+    if (stats) stats->assign(1, ComponentStats());
+    if (image.rows == 0 || image.cols == 0) return 0;
+
+    switch (image.depth()) {
+    case CV_8U:
+        return labelComponentsOf<uchar>(image, labels, connectivity, stats);
+    case CV_16U:
+        return labelComponentsOf<ushort>(image, labels, connectivity, stats);
+    case CV_32S:
+        return labelComponentsOf<int>(image, labels, connectivity, stats);
+    case CV_32F:
+        return labelComponentsOf<float>(image, labels, connectivity, stats);
+    default:
+        assert(false && "labelComponents: unsupported image depth");
+        return 0;
+    }
+}
+
+/**
+    Labels of a horizontal strip of the image, computed on its own: labels
+    1..count in the raster order of the strip, and statistics in acc when
+    gathered (pairs with the row above the strip are not counted).
+*/
+struct StripLabels {
+    int begin = 0, end = 0; // rows
+    int count = 0;
+    int base = 0; // the strip label k is the element base + k of the global forest
+    vector<StatsAccumulator> acc;
+};
+
+template<typename T>
+static void labelStrip(const Mat &image, Mat &labels, Connectivity connectivity,
+                       StripLabels &strip, bool withStats) {
+    Mat in = image.rowRange(strip.begin, strip.end);
+    Mat out = labels.rowRange(strip.begin, strip.end);
+    UnionFind forest;
+    strip.acc.assign(1, StatsAccumulator());
+    vector<StatsAccumulator> *acc = withStats ? &strip.acc : nullptr;
+    if (connectivity == CONNECTIVITY_4) {
+        firstPass4<T>(in, out, forest);
+        strip.count = secondPass4<T>(in, out, forest, acc, strip.begin);
+    }
+    else {
+        firstPass8<T>(in, out, forest);
+        strip.count = secondPass8<T>(in, out, forest, acc, strip.begin);
+    }
+    traceCount(TRACE_MERGES, forest.merges());
+}
+
+/**
+    Joins the labels of strip (rows begin..) with the ones of the strip above
+    it, through the pixel pairs of its first row and the row above. The pairs
+    of 4 adjacent pixels are added to the statistics of the strip.
+*/
+template<typename T>
+static void joinStrips(const Mat &image, const Mat &labels, Connectivity connectivity,
+                       const StripLabels &above, StripLabels &strip, UnionFind &forest,
+                       bool withStats) {
+    int r = strip.begin;
+    const T *in = image.ptr<T>(r);
+    const T *inAbove = image.ptr<T>(r - 1);
+    const int *lab = labels.ptr<int>(r);
+    const int *labAbove = labels.ptr<int>(r - 1);
+    int cols = image.cols;
+    for (int j = 0; j < cols; j++) {
+        if (in[j] == 0) continue;
+        int x = strip.base + lab[j];
+        if (inAbove[j] != 0) {
+            forest.unite(x, above.base + labAbove[j]);
+            if (withStats) strip.acc[lab[j]].pairs++;
+        }
+        if (connectivity == CONNECTIVITY_8) {
+            if (j > 0 && inAbove[j - 1] != 0) forest.unite(x, above.base + labAbove[j - 1]);
+            if (j + 1 < cols && inAbove[j + 1] != 0) forest.unite(x, above.base + labAbove[j + 1]);
+        }
+    }
+}
+
+template<typename T>
+static int labelComponentsParallelOf(const Mat &image, Mat &labels, Connectivity connectivity,
+                                     vector<ComponentStats> *stats) {
+    // Several strips per thread for the work stealing, of an even number of
+    // rows so that the 2x2 blocks of the 8 connectivity scan do not straddle.
+    const int minStripRows = 64;
+    int threads = getNumThreads();
+    int stripRows = max(minStripRows, (image.rows + 4 * threads - 1) / (4 * threads));
+    stripRows += stripRows & 1;
+    int stripCount = (image.rows + stripRows - 1) / stripRows;
+    bool withStats = stats != nullptr;
+
+    vector<StripLabels> strips(stripCount);
+    for (int s = 0; s < stripCount; s++) {
+        strips[s].begin = s * stripRows;
+        strips[s].end = min(image.rows, (s + 1) * stripRows);
+    }
+    parallel_for_1d(stripCount, 1, [&](int begin, int end) {
+        for (int s = begin; s < end; s++)
+            labelStrip<T>(image, labels, connectivity, strips[s], withStats);
+    });
+
+    // Strip labels are numbered in raster order and the strips follow each
+    // other, so the smallest element of each set is its first pixel in the
+    // raster order of the image.
+    UnionFind forest;
+    int elements = 0;
+    for (StripLabels &strip : strips) {
+        strip.base = elements;
+        elements += strip.count;
+    }
+    forest.reserve(elements + 1);
+    for (int x = 1; x <= elements; x++)
+        forest.makeSet();
+    for (int s = 1; s < stripCount; s++)
+        joinStrips<T>(image, labels, connectivity, strips[s - 1], strips[s], forest, withStats);
+    traceCount(TRACE_MERGES, forest.merges());
+
+    vector<int> finalLabel(elements + 1, 0);
+    int count = 0;
+    for (int x = 1; x <= elements; x++) {
+        int root = forest.find(x);
+        if (finalLabel[root] == 0) finalLabel[root] = ++count;
+        finalLabel[x] = finalLabel[root];
+    }
+
+    parallel_for_1d(stripCount, 1, [&](int begin, int end) {
+        for (int s = begin; s < end; s++) {
+            const int *table = finalLabel.data() + strips[s].base;
+            for (int i = strips[s].begin; i < strips[s].end; i++) {
+                int *out = labels.ptr<int>(i);
+                for (int j = 0; j < labels.cols; j++) {
+                    if (out[j] != 0) out[j] = table[out[j]];
+                }
+            }
+        }
+    });
+
+    if (withStats) {
+        vector<StatsAccumulator> acc(count + 1);
+        for (const StripLabels &strip : strips) {
+            for (int k = 1; k <= strip.count; k++)
+                acc[finalLabel[strip.base + k]].merge(strip.acc[k]);
+        }
+        finishStats(acc, *stats);
+    }
+    traceCount(TRACE_COMPONENTS, count);
+    return count;
+}
+
+int labelComponentsParallel(Mat image, Mat &labels, Connectivity connectivity,
+                            vector<ComponentStats> *stats)
+{
+    TraceScope scope("labelComponentsParallel");
+    assert(image.channels() == 1);
+    assert(connectivity == CONNECTIVITY_4 || connectivity == CONNECTIVITY_8);
+    ensureImage(labels, image.rows, image.cols, CV_32SC1);
+    if (stats) stats->assign(1, ComponentStats());
+    if (image.rows == 0 || image.cols == 0) return 0;
+
+    switch (image.depth()) {
+    case CV_8U:
+        return labelComponentsParallelOf<uchar>(image, labels, connectivity, stats);
+    case CV_16U:
+        return labelComponentsParallelOf<ushort>(image, labels, connectivity, stats);
+    case CV_32S:
+        return labelComponentsParallelOf<int>(image, labels, connectivity, stats);
+    case CV_32F:
+        return labelComponentsParallelOf<float>(image, labels, connectivity, stats);
+    default:
+        assert(false && "labelComponentsParallel: unsupported image depth");
+        return 0;
+    }
+}
+
+template<typename T>
+static int labelFlatZonesOf(const Mat &image, Mat &labels, vector<ComponentStats> *stats) {
+    vector<Point2i> stack;
+    ComponentStats component;
+    int count = 0;
+    for (int i = 0; i < image.rows; i++) {
+        const T *in = image.ptr<T>(i);
+        const int *out = labels.ptr<int>(i);
+        for (int j = 0; j < image.cols; j++) {
+            if (in[j] == 0 || out[j] != 0) continue;
+            count++;
+            floodFillOf<T>(image, labels, i, j, count, stack, stats ? &component : nullptr);
+            if (stats) stats->push_back(component);
+        }
+    }
+    traceCount(TRACE_COMPONENTS, count);
+    return count;
+}
+
+int labelFlatZones(Mat image, Mat &labels, vector<ComponentStats> *stats)
+{
+    TraceScope scope("labelFlatZones");
+    assert(image.channels() == 1);
+    ensureImage(labels, image.rows, image.cols, CV_32SC1);
+    labels.setTo(0);
+    if (stats) stats->assign(1, ComponentStats());
+
+    switch (image.depth()) {
+    case CV_8U:
+        return labelFlatZonesOf<uchar>(image, labels, stats);
+    case CV_16U:
+        return labelFlatZonesOf<ushort>(image, labels, stats);
+    case CV_32S:
+        return labelFlatZonesOf<int>(image, labels, stats);
+    case CV_32F:
+        return labelFlatZonesOf<float>(image, labels, stats);
+    default:
+        assert(false && "labelFlatZones: unsupported image depth");
+        return 0;
+    }
+}
+
+template<typename T>
+static void remapComponents(Mat &image, const Mat &labels, const vector<uchar> &keep) {
+    for (int i = 0; i < image.rows; i++) {
+        T *row = image.ptr<T>(i);
+        const int *lab = labels.ptr<int>(i);
+        for (int j = 0; j < image.cols; j++) {
+            if (!keep[lab[j]]) row[j] = 0;
+        }
+    }
+}
+
+Mat filterComponents(Mat image, Mat labels, const vector<uchar> &keep)
+{
+    assert(image.channels() == 1 && labels.type() == CV_32SC1);
+    assert(labels.rows == image.rows && labels.cols == image.cols);
+    assert(!keep.empty());
+    vector<uchar> table(keep);
+    table[0] = 1; // background is left as is
+
+    Mat res = image.clone();
+    switch (image.depth()) {
+    case CV_8U:
+        remapComponents<uchar>(res, labels, table);
+        break;
+    case CV_16U:
+        remapComponents<ushort>(res, labels, table);
+        break;
+    case CV_32S:
+        remapComponents<int>(res, labels, table);
+        break;
+    case CV_32F:
+        remapComponents<float>(res, labels, table);
+        break;
+    default:
+        assert(false && "filterComponents: unsupported image depth");
+    }
+    return res;
+}
+
+Mat filterComponents(Mat image, Mat labels, const vector<ComponentStats> &stats,
+                     ComponentPredicate keep)
+{
+    vector<uchar> table(stats.size(), 1);
+    for (int k = 1; k < (int) stats.size(); k++)
+        table[k] = keep(stats[k]) ? 1 : 0;
+    return filterComponents(image, labels, table);
+}
+
+ComponentPredicate areaBetween(int64_t minArea, int64_t maxArea)
+{
+    return [minArea, maxArea](const ComponentStats &s) {
+        return s.area >= minArea && s.area <= maxArea;
+    };
+}
+
+ComponentPredicate aspectRatioBetween(double minRatio, double maxRatio)
+{
+    return [minRatio, maxRatio](const ComponentStats &s) {
+        double ratio = s.aspectRatio();
+        return ratio >= minRatio && ratio <= maxRatio;
+    };
+}
@@ -0,0 +1,108 @@
+#ifndef LABELING_H
+#define LABELING_H
+
+#include <opencv2/core.hpp>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+enum Connectivity {
+    CONNECTIVITY_4 = 4,
+    CONNECTIVITY_8 = 8
+};
+
+/**
+    Statistics of a connected component, in pixel coordinates (x = column,
+    y = row). The perimeter is the number of pixel sides between the component
+    and the rest of the plane, holes included: 4 * area minus twice the number
+    of 4 adjacent pixel pairs of the component.
+*/
+struct ComponentStats {
+    int64_t area = 0;
+    cv::Rect boundingBox;
+    cv::Point2d centroid;
+    int64_t perimeter = 0;
+
+    double aspectRatio() const {
+        return boundingBox.height > 0 ? boundingBox.width / (double) boundingBox.height : 0;
+    }
+};
+
+/**
+    Labels the connected components of a CV_8UC1, CV_32SC1 or CV_32FC1 image,
+    any non zero pixel being present. labels is a CV_32SC1 image holding 0 on
+    the background and 1..N on the components, numbered in the raster order of
+    their first pixel. Returns N.
+    When stats is given, it is filled during the second pass with N+1 entries,
+    (*stats)[k] describing component k; (*stats)[0] is left empty.
+
+    Two pass algorithm over a union-find forest (union by rank, path
+    compression), in O(rows*cols) time. With 4 connectivity the first pass
+    looks at the upper and left pixels, with 8 connectivity it works on 2x2
+    blocks as in Grana et al. (2010): the pixels of a block are always
+    connected, so it takes one label and is linked to the left, upper left,
+    upper and upper right blocks through the few pixel pairs they share.
+*/
+int labelComponents(cv::Mat image, cv::Mat &labels,
+                    Connectivity connectivity = CONNECTIVITY_4,
+                    std::vector<ComponentStats> *stats = nullptr);
+
+/**
+    Same labels and statistics as labelComponents, computed on the thread pool
+    (see parallel.h). The image is cut in horizontal strips labeled
+    independently, the strips are then joined through a union-find forest over
+    all their labels and relabeled in parallel. The labels of each strip being
+    numbered in raster order, the smallest element of each set of the forest
+    is its first pixel in the raster order of the image, hence the same
+    canonical numbering as the sequential scan whatever the number of threads.
+*/
+int labelComponentsParallel(cv::Mat image, cv::Mat &labels,
+                            Connectivity connectivity = CONNECTIVITY_4,
+                            std::vector<ComponentStats> *stats = nullptr);
+
+/**
+    Scanline flood fill: writes label on the 4 connected component of the
+    pixels having the value of image(i, j) that contains (i, j), and returns its
+    area. labels is a CV_32SC1 image of the size of image, in which 0 marks the
+    pixels not labeled yet; the component must not be labeled. Each filled row
+    span seeds the runs of the rows above and below it, so a component of n
+    pixels costs O(n). stack is only working memory, reused between calls.
+    The statistics of the component are written to stats when given.
+*/
+int floodFillLabel(cv::Mat image, cv::Mat &labels, int i, int j, int label,
+                   std::vector<cv::Point2i> &stack, ComponentStats *stats = nullptr);
+
+/**
+    Labels the flat zones of the image: 4 connected components of pixels
+    sharing the same non zero value, numbered 1..N in raster order. Returns N,
+    stats as in labelComponents.
+*/
+int labelFlatZones(cv::Mat image, cv::Mat &labels,
+                   std::vector<ComponentStats> *stats = nullptr);
+
+/**
+    Sets to 0 the pixels of image whose label k is not kept (keep[k] == 0),
+    in a single pass. labels comes from one of the labeling functions above,
+    keep has one entry per label, background included.
+*/
+cv::Mat filterComponents(cv::Mat image, cv::Mat labels, const std::vector<uchar> &keep);
+
+typedef std::function<bool(const ComponentStats &)> ComponentPredicate;
+
+/**
+    Keeps the components whose statistics satisfy the predicate, eg.
+        filterComponents(image, labels, stats, areaBetween(10));
+        filterComponents(image, labels, stats, [](const ComponentStats &s) {
+            return s.area > 50 && s.perimeter < 4 * s.area / 3; });
+*/
+cv::Mat filterComponents(cv::Mat image, cv::Mat labels,
+                         const std::vector<ComponentStats> &stats, ComponentPredicate keep);
+
+/**
+    Common predicates, bounds included.
+*/
+ComponentPredicate areaBetween(int64_t minArea, int64_t maxArea = INT64_MAX);
+ComponentPredicate aspectRatioBetween(double minRatio, double maxRatio);
+
+#endif
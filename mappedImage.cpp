@@ -0,0 +1,689 @@
+#include "mappedImage.h"
+#include "bufferPool.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace cv;
+using namespace std;
+
+// TIFF field types used here
+static const int TIFF_BYTE = 1, TIFF_SHORT = 3, TIFF_LONG = 4, TIFF_LONG8 = 16;
+
+static bool hostLittleEndian() {
+    uint16_t one = 1;
+    return *(unsigned char *) &one == 1;
+}
+
+// depth and channels of a type (CV_MAKETYPE(depth, channels))
+static int typeDepth(int type) {
+    return type & 7;
+}
+
+static int typeChannels(int type) {
+    return (type >> 3) + 1;
+}
+
+static size_t depthBytes(int depth) {
+    static const size_t bytes[] = {1, 1, 2, 2, 4, 4, 8};
+    return bytes[depth];
+}
+
+static size_t pixelBytes(int type) {
+    return depthBytes(typeDepth(type)) * typeChannels(type);
+}
+
+static size_t pageSize() {
+    static const size_t size = (size_t) sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+/**
+    Reverses the bytes of each of the n samples of size bytes at p.
+*/
+static void swapSamples(unsigned char *p, size_t n, size_t bytes) {
+    if (bytes == 1)
+        return;
+    for (size_t s = 0; s < n; s++, p += bytes)
+        reverse(p, p + bytes);
+}
+
+MappedImage::~MappedImage()
+{
+    close();
+}
+
+MappedImage::MappedImage(MappedImage &&other) noexcept
+{
+    *this = move(other);
+}
+
+MappedImage &MappedImage::operator=(MappedImage &&other) noexcept
+{
+    if (this != &other) {
+        close();
+        base = exchange(other.base, nullptr);
+        length = exchange(other.length, 0);
+        writableMapping = other.writableMapping;
+        fileFormat = other.fileFormat;
+        imageSize = other.imageSize;
+        imageType = other.imageType;
+        swapBytes = other.swapBytes;
+        blockShape = other.blockShape;
+        blockStep = other.blockStep;
+        contiguous = other.contiguous;
+        blocks = move(other.blocks);
+        other.close();
+    }
+    return *this;
+}
+
+/**
+    Maps path shared. With createLength > 0 the file is created (or
+    truncated) with that size, otherwise its size is kept.
+*/
+bool MappedImage::mapFile(const string &path, bool writable, size_t createLength)
+{
+    int flags = writable ? O_RDWR : O_RDONLY;
+    if (createLength > 0)
+        flags |= O_CREAT | O_TRUNC;
+    int fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0)
+        return false;
+
+    size_t size = createLength;
+    if (createLength > 0) {
+        if (ftruncate(fd, (off_t) createLength) != 0) {
+            ::close(fd);
+            return false;
+        }
+    }
+    else {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        size = (size_t) st.st_size;
+    }
+
+    int protection = PROT_READ | (writable ? PROT_WRITE : 0);
+    void *p = mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    if (p == MAP_FAILED)
+        return false;
+    base = (unsigned char *) p;
+    length = size;
+    writableMapping = writable;
+    return true;
+}
+
+void MappedImage::close()
+{
+    if (base != nullptr) {
+        if (writableMapping)
+            msync(base, length, MS_SYNC);
+        munmap(base, length);
+    }
+    base = nullptr;
+    length = 0;
+    writableMapping = false;
+    imageSize = Size();
+    imageType = 0;
+    swapBytes = false;
+    blockShape = Size();
+    blockStep = 0;
+    contiguous = false;
+    blocks.clear();
+}
+
+/**
+    Single block of rows x cols pixels starting at dataOffset (raw and PNM).
+*/
+bool MappedImage::setLayout(int type, size_t dataOffset, size_t rowStep)
+{
+    imageType = type;
+    blockShape = imageSize;
+    blockStep = rowStep;
+    contiguous = true;
+    blocks.assign(1, Block{dataOffset, Rect(0, 0, imageSize.width, imageSize.height)});
+    return validBlocks();
+}
+
+bool MappedImage::validBlocks() const
+{
+    size_t bytes = pixelBytes(imageType);
+    for (const Block &b : blocks) {
+        if (b.rect.width <= 0 || b.rect.height <= 0)
+            return false;
+        // each step is checked against the bytes left, offsets come from the file
+        size_t rowBytes = (size_t) b.rect.width * bytes;
+        if (b.offset > length || rowBytes > length - b.offset)
+            return false;
+        if ((size_t) (b.rect.height - 1) > (length - b.offset - rowBytes) / blockStep)
+            return false;
+    }
+    return !blocks.empty();
+}
+
+bool MappedImage::open(const string &path, bool writable)
+{
+    close();
+    if (!mapFile(path, writable, 0))
+        return false;
+
+    bool ok = false;
+    if (length >= 2 && base[0] == 'P' && (base[1] == '5' || base[1] == '6'))
+        ok = parsePnm();
+    else if (length >= 8 && ((base[0] == 'I' && base[1] == 'I') || (base[0] == 'M' && base[1] == 'M')))
+        ok = parseTiff();
+    if (!ok)
+        close();
+    return ok;
+}
+
+bool MappedImage::openRaw(const string &path, int rows, int cols, int type, size_t headerBytes, bool writable)
+{
+    assert(rows > 0 && cols > 0);
+    close();
+    if (!mapFile(path, writable, 0))
+        return false;
+    fileFormat = FILE_RAW;
+    imageSize = Size(cols, rows);
+    if (!setLayout(type, headerBytes, (size_t) cols * pixelBytes(type))) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+    Header of a binary PGM / PPM: magic, width, height and maximum value
+    separated by white space (and # comments), then one white space.
+*/
+bool MappedImage::parsePnm()
+{
+    size_t p = 2;
+    auto number = [&](long &value) {
+        while (p < length && (isspace(base[p]) || base[p] == '#')) {
+            if (base[p] == '#') {
+                while (p < length && base[p] != '\n') p++;
+            }
+            else {
+                p++;
+            }
+        }
+        if (p >= length || !isdigit(base[p]))
+            return false;
+        value = 0;
+        while (p < length && isdigit(base[p])) {
+            value = value * 10 + (base[p++] - '0');
+            if (value > INT_MAX)
+                return false;
+        }
+        return true;
+    };
+
+    long width, height, maxValue;
+    if (!number(width) || !number(height) || !number(maxValue))
+        return false;
+    if (p >= length || !isspace(base[p]) || width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 65535)
+        return false;
+    p++;
+
+    int channels = base[1] == '5' ? 1 : 3;
+    int depth = maxValue < 256 ? CV_8U : CV_16U;
+    fileFormat = FILE_PNM;
+    imageSize = Size((int) width, (int) height);
+    swapBytes = depth == CV_16U && hostLittleEndian();
+    int type = CV_MAKETYPE(depth, channels);
+    return setLayout(type, p, (size_t) width * pixelBytes(type));
+}
+
+/**
+    First image file directory of a TIFF or BigTIFF file: the tags are read
+    as arrays of integers, the layout is then checked against what can be
+    mapped (uncompressed, interleaved samples of one type).
+*/
+bool MappedImage::parseTiff()
+{
+    bool little = base[0] == 'I';
+    bool inside = true;
+    auto read = [&](size_t offset, int bytes) -> uint64_t {
+        if (offset > length || (size_t) bytes > length - offset) {
+            inside = false;
+            return 0;
+        }
+        uint64_t v = 0;
+        for (int b = 0; b < bytes; b++) {
+            int shift = little ? 8 * b : 8 * (bytes - 1 - b);
+            v |= (uint64_t) base[offset + b] << shift;
+        }
+        return v;
+    };
+
+    uint64_t version = read(2, 2);
+    bool big = version == 43;
+    if (version != 42 && !big)
+        return false;
+    uint64_t ifd = big ? read(8, 8) : read(4, 4);
+    uint64_t entries = big ? read(ifd, 8) : read(ifd, 2);
+    size_t entrySize = big ? 20 : 12;
+    size_t first = ifd + (big ? 8 : 2);
+    if (!inside || entries > length / entrySize)
+        return false;
+
+    map<int, vector<uint64_t>> tags;
+    for (uint64_t e = 0; e < entries; e++) {
+        size_t entry = first + e * entrySize;
+        int tag = (int) read(entry, 2);
+        int fieldType = (int) read(entry + 2, 2);
+        uint64_t count = big ? read(entry + 4, 8) : read(entry + 4, 4);
+        int size = fieldType == TIFF_BYTE ? 1 : fieldType == TIFF_SHORT ? 2 : fieldType == TIFF_LONG ? 4
+                 : fieldType == TIFF_LONG8 ? 8 : 0;
+        if (size == 0 || count > length)
+            continue; // a tag not needed here (ASCII, RATIONAL...)
+        size_t field = entry + (big ? 12 : 8);
+        size_t fieldBytes = big ? 8 : 4;
+        size_t values = count * size <= fieldBytes ? field : (size_t) (big ? read(field, 8) : read(field, 4));
+        if (values > length || count * size > length - values) {
+            inside = false;
+            break;
+        }
+        vector<uint64_t> &v = tags[tag];
+        v.resize(count);
+        for (uint64_t c = 0; c < count; c++)
+            v[c] = read(values + c * size, size);
+    }
+    if (!inside)
+        return false;
+
+    auto tag = [&](int id, uint64_t fallback) {
+        auto it = tags.find(id);
+        return it == tags.end() || it->second.empty() ? fallback : it->second[0];
+    };
+    uint64_t width = tag(256, 0), height = tag(257, 0);
+    uint64_t channels = tag(277, 1), bits = tag(258, 1), format = tag(339, 1);
+    if (width == 0 || height == 0 || width > (1u << 30) || height > (1u << 30))
+        return false;
+    if (tag(259, 1) != 1 || channels < 1 || channels > 4 || (channels > 1 && tag(284, 1) != 1))
+        return false;
+    for (uint64_t b : tags[258]) {
+        if (b != bits)
+            return false; // all the channels must have the same type
+    }
+
+    int depth = -1;
+    if (bits == 8)
+        depth = format == 2 ? CV_8S : CV_8U;
+    else if (bits == 16)
+        depth = format == 2 ? CV_16S : CV_16U;
+    else if (bits == 32 && format == 2)
+        depth = CV_32S;
+    else if (bits == 32 && format == 3)
+        depth = CV_32F;
+    else if (bits == 64 && format == 3)
+        depth = CV_64F;
+    if (depth < 0 || (format != 1 && format != 2 && format != 3))
+        return false;
+
+    fileFormat = FILE_TIFF;
+    imageSize = Size((int) width, (int) height);
+    imageType = CV_MAKETYPE(depth, (int) channels);
+    swapBytes = little != hostLittleEndian() && bits > 8;
+    size_t bytes = pixelBytes(imageType);
+
+    blocks.clear();
+    if (tags.count(322)) {
+        uint64_t tileWidth = tag(322, 0), tileHeight = tag(323, 0);
+        const vector<uint64_t> &offsets = tags[324];
+        // at most 2^30 so that tile corners stay in int
+        if (tileWidth == 0 || tileHeight == 0 || tileWidth > (1u << 30) || tileHeight > (1u << 30))
+            return false;
+        uint64_t tilesAcross = (width + tileWidth - 1) / tileWidth;
+        uint64_t tilesDown = (height + tileHeight - 1) / tileHeight;
+        if (offsets.size() != tilesAcross * tilesDown)
+            return false;
+
+        blockShape = Size((int) tileWidth, (int) tileHeight);
+        blockStep = (size_t) tileWidth * bytes;
+        for (size_t t = 0; t < offsets.size(); t++) {
+            Rect r((int) (t % tilesAcross) * blockShape.width, (int) (t / tilesAcross) * blockShape.height,
+                   blockShape.width, blockShape.height);
+            blocks.push_back(Block{(size_t) offsets[t], r & Rect(0, 0, imageSize.width, imageSize.height)});
+        }
+        contiguous = false;
+    }
+    else {
+        uint64_t rowsPerStrip = min(tag(278, height), height);
+        const vector<uint64_t> &offsets = tags[273];
+        if (rowsPerStrip == 0 || offsets.size() != (height + rowsPerStrip - 1) / rowsPerStrip)
+            return false;
+        blockShape = Size((int) width, (int) rowsPerStrip);
+        blockStep = (size_t) width * bytes;
+        for (size_t s = 0; s < offsets.size(); s++) {
+            Rect r(0, (int) (s * rowsPerStrip), (int) width, blockShape.height);
+            blocks.push_back(Block{(size_t) offsets[s], r & Rect(0, 0, imageSize.width, imageSize.height)});
+        }
+        if (!validBlocks())
+            return false;
+        // the strips before the last one are in the file: rowsPerStrip * blockStep <= length
+        contiguous = true;
+        for (size_t s = 1; s < offsets.size(); s++) {
+            if (offsets[s] != offsets[s - 1] + rowsPerStrip * blockStep)
+                contiguous = false;
+        }
+        return true;
+    }
+    return validBlocks();
+}
+
+bool MappedImage::create(const string &path, ImageFileFormat format, int rows, int cols, int type, Size tileSize)
+{
+    assert(rows > 0 && cols > 0 && typeChannels(type) <= 4);
+    close();
+    size_t bytes = pixelBytes(type);
+    size_t rowBytes = (size_t) cols * bytes;
+
+    if (format == FILE_RAW) {
+        if (!mapFile(path, true, (size_t) rows * rowBytes))
+            return false;
+        fileFormat = FILE_RAW;
+        imageSize = Size(cols, rows);
+        if (!setLayout(type, 0, rowBytes)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    if (format == FILE_PNM) {
+        int depth = typeDepth(type), channels = typeChannels(type);
+        assert((depth == CV_8U || depth == CV_16U) && (channels == 1 || channels == 3));
+        string header = string(channels == 1 ? "P5" : "P6") + "\n" + to_string(cols) + " " + to_string(rows)
+                      + "\n" + (depth == CV_8U ? "255" : "65535") + "\n";
+        if (!mapFile(path, true, header.size() + (size_t) rows * rowBytes))
+            return false;
+        memcpy(base, header.data(), header.size());
+        if (!parsePnm()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // TIFF in the byte order of the machine: header, directory, the arrays
+    // that do not fit in their entry, then the blocks from a page boundary
+    bool tiled = tileSize.width > 0 && tileSize.height > 0;
+    assert(!tiled || (tileSize.width % 16 == 0 && tileSize.height % 16 == 0));
+    int depth = typeDepth(type), channels = typeChannels(type);
+    int sampleFormat = depth == CV_32F || depth == CV_64F ? 3 : depth == CV_8S || depth == CV_16S || depth == CV_32S ? 2 : 1;
+
+    vector<uint64_t> blockBytes;
+    int rowsPerStrip = 0;
+    if (tiled) {
+        int across = (cols + tileSize.width - 1) / tileSize.width;
+        int down = (rows + tileSize.height - 1) / tileSize.height;
+        blockBytes.assign((size_t) across * down, (uint64_t) tileSize.width * tileSize.height * bytes);
+    }
+    else {
+        rowsPerStrip = (int) max<size_t>(1, min<size_t>(rows, (1 << 16) / max<size_t>(rowBytes, 1)));
+        for (int y = 0; y < rows; y += rowsPerStrip)
+            blockBytes.push_back((uint64_t) min(rowsPerStrip, rows - y) * rowBytes);
+    }
+    uint64_t dataBytes = 0;
+    for (uint64_t b : blockBytes)
+        dataBytes += b;
+    bool big = dataBytes + (1 << 20) + blockBytes.size() * 16 > 0xffffffffull;
+    int offsetType = big ? TIFF_LONG8 : TIFF_LONG;
+
+    struct Entry {
+        int tag, type;
+        vector<uint64_t> values;
+    };
+    vector<Entry> entries = {
+        {256, TIFF_LONG, {(uint64_t) cols}},
+        {257, TIFF_LONG, {(uint64_t) rows}},
+        {258, TIFF_SHORT, vector<uint64_t>(channels, depthBytes(depth) * 8)},
+        {259, TIFF_SHORT, {1}},
+        {262, TIFF_SHORT, {channels >= 3 ? 2u : 1u}}};
+    if (!tiled)
+        entries.push_back({273, offsetType, vector<uint64_t>(blockBytes.size())});
+    entries.push_back({277, TIFF_SHORT, {(uint64_t) channels}});
+    if (!tiled) {
+        entries.push_back({278, TIFF_LONG, {(uint64_t) rowsPerStrip}});
+        entries.push_back({279, offsetType, blockBytes});
+    }
+    entries.push_back({284, TIFF_SHORT, {1}});
+    if (tiled) {
+        entries.push_back({322, TIFF_LONG, {(uint64_t) tileSize.width}});
+        entries.push_back({323, TIFF_LONG, {(uint64_t) tileSize.height}});
+        entries.push_back({324, offsetType, vector<uint64_t>(blockBytes.size())});
+        entries.push_back({325, offsetType, blockBytes});
+    }
+    if (channels == 2 || channels == 4)
+        entries.push_back({338, TIFF_SHORT, {0}});
+    entries.push_back({339, TIFF_SHORT, vector<uint64_t>(channels, (uint64_t) sampleFormat)});
+
+    auto typeSize = [](int t) { return t == TIFF_SHORT ? 2 : t == TIFF_LONG ? 4 : 8; };
+    size_t headerBytes = big ? 16 : 8;
+    size_t entrySize = big ? 20 : 12, fieldBytes = big ? 8 : 4;
+    size_t ifdBytes = (big ? 8 : 2) + entries.size() * entrySize + (big ? 8 : 4);
+    size_t external = headerBytes + ifdBytes;
+    vector<size_t> valueOffsets(entries.size(), 0);
+    for (size_t e = 0; e < entries.size(); e++) {
+        size_t size = entries[e].values.size() * typeSize(entries[e].type);
+        if (size > fieldBytes) {
+            valueOffsets[e] = external;
+            external += (size + 7) / 8 * 8;
+        }
+    }
+    size_t dataStart = (external + pageSize() - 1) / pageSize() * pageSize();
+    for (Entry &entry : entries) {
+        if (entry.tag == 273 || entry.tag == 324) {
+            uint64_t offset = dataStart;
+            for (size_t b = 0; b < blockBytes.size(); b++) {
+                entry.values[b] = offset;
+                offset += blockBytes[b];
+            }
+        }
+    }
+
+    if (!mapFile(path, true, dataStart + dataBytes))
+        return false;
+    auto put = [&](size_t offset, uint64_t v, int size) {
+        uint16_t v16 = (uint16_t) v;
+        uint32_t v32 = (uint32_t) v;
+        memcpy(base + offset, size == 2 ? (void *) &v16 : size == 4 ? (void *) &v32 : (void *) &v, size);
+    };
+    base[0] = base[1] = hostLittleEndian() ? 'I' : 'M';
+    put(2, big ? 43 : 42, 2);
+    if (big) {
+        put(4, 8, 2);
+        put(6, 0, 2);
+        put(8, headerBytes, 8);
+    }
+    else {
+        put(4, headerBytes, 4);
+    }
+    size_t p = headerBytes;
+    put(p, entries.size(), big ? 8 : 2);
+    p += big ? 8 : 2;
+    for (size_t e = 0; e < entries.size(); e++, p += entrySize) {
+        const Entry &entry = entries[e];
+        int size = typeSize(entry.type);
+        put(p, entry.tag, 2);
+        put(p + 2, entry.type, 2);
+        put(p + 4, entry.values.size(), big ? 8 : 4);
+        size_t field = p + (big ? 12 : 8);
+        size_t values = valueOffsets[e] != 0 ? valueOffsets[e] : field;
+        if (valueOffsets[e] != 0)
+            put(field, valueOffsets[e], (int) fieldBytes);
+        for (size_t v = 0; v < entry.values.size(); v++)
+            put(values + v * size, entry.values[v], size);
+    }
+    put(p, 0, big ? 8 : 4); // no next directory
+    if (!parseTiff()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+Rect MappedImage::blockRect(int index) const
+{
+    assert(index >= 0 && index < blockCount());
+    return blocks[index].rect;
+}
+
+Mat MappedImage::block(int index) const
+{
+    assert(index >= 0 && index < blockCount());
+    if (swapBytes)
+        return Mat();
+    const Block &b = blocks[index];
+    return Mat(b.rect.height, b.rect.width, imageType, base + b.offset, blockStep);
+}
+
+Mat MappedImage::view(const Rect &region) const
+{
+    assert(isOpen() && (region & Rect(0, 0, imageSize.width, imageSize.height)) == region);
+    if (swapBytes || region.area() == 0)
+        return Mat();
+    size_t bytes = pixelBytes(imageType);
+    if (contiguous) {
+        unsigned char *p = base + blocks[0].offset + (size_t) region.y * blockStep + (size_t) region.x * bytes;
+        return Mat(region.height, region.width, imageType, p, blockStep);
+    }
+    int across = (imageSize.width + blockShape.width - 1) / blockShape.width;
+    const Block &b = blocks[(region.y / blockShape.height) * across + region.x / blockShape.width];
+    if (!((region & b.rect) == region))
+        return Mat();
+    unsigned char *p = base + b.offset + (size_t) (region.y - b.rect.y) * blockStep
+                     + (size_t) (region.x - b.rect.x) * bytes;
+    return Mat(region.height, region.width, imageType, p, blockStep);
+}
+
+/**
+    Calls f(block, rectangle of region inside the block) for each block
+    overlapping region.
+*/
+template<typename F>
+void MappedImage::forEachBlock(const Rect &region, F f) const
+{
+    if (region.area() == 0)
+        return;
+    int across = (imageSize.width + blockShape.width - 1) / blockShape.width;
+    for (int by = region.y / blockShape.height; by <= (region.y + region.height - 1) / blockShape.height; by++) {
+        for (int bx = region.x / blockShape.width; bx <= (region.x + region.width - 1) / blockShape.width; bx++) {
+            const Block &b = blocks[by * across + bx];
+            f(b, region & b.rect);
+        }
+    }
+}
+
+void MappedImage::read(const Rect &region, Mat &dst) const
+{
+    assert(isOpen() && (region & Rect(0, 0, imageSize.width, imageSize.height)) == region);
+    assert(dst.data == nullptr || dst.data < base || dst.data >= base + length);
+    ensureImage(dst, region.height, region.width, imageType);
+    size_t bytes = pixelBytes(imageType);
+    forEachBlock(region, [&](const Block &b, const Rect &r) {
+        for (int y = r.y; y < r.y + r.height; y++) {
+            const unsigned char *in = base + b.offset + (size_t) (y - b.rect.y) * blockStep
+                                    + (size_t) (r.x - b.rect.x) * bytes;
+            unsigned char *out = dst.ptr(y - region.y) + (size_t) (r.x - region.x) * bytes;
+            memcpy(out, in, r.width * bytes);
+            if (swapBytes)
+                swapSamples(out, (size_t) r.width * typeChannels(imageType), depthBytes(typeDepth(imageType)));
+        }
+    });
+}
+
+Mat MappedImage::read(const Rect &region) const
+{
+    Mat res;
+    read(region, res);
+    return res;
+}
+
+void MappedImage::write(const Mat &image, Point origin)
+{
+    assert(isOpen() && writableMapping && image.type() == imageType);
+    Rect region(origin.x, origin.y, image.cols, image.rows);
+    assert((region & Rect(0, 0, imageSize.width, imageSize.height)) == region);
+    size_t bytes = pixelBytes(imageType);
+    forEachBlock(region, [&](const Block &b, const Rect &r) {
+        for (int y = r.y; y < r.y + r.height; y++) {
+            const unsigned char *in = image.ptr(y - region.y) + (size_t) (r.x - region.x) * bytes;
+            unsigned char *out = base + b.offset + (size_t) (y - b.rect.y) * blockStep
+                               + (size_t) (r.x - b.rect.x) * bytes;
+            if (in == out)
+                continue; // image is a view of these pixels
+            memmove(out, in, r.width * bytes);
+            if (swapBytes)
+                swapSamples(out, (size_t) r.width * typeChannels(imageType), depthBytes(typeDepth(imageType)));
+        }
+    });
+}
+
+void MappedImage::advise(MappedAccess access) const
+{
+    if (!isOpen())
+        return;
+    int advice = access == MAPPED_SEQUENTIAL ? MADV_SEQUENTIAL : access == MAPPED_RANDOM ? MADV_RANDOM : MADV_NORMAL;
+    madvise(base, length, advice);
+}
+
+/**
+    madvise(advice) on the pages of each block holding rows of region
+    (whole rows of the block: the columns of a row are a few pages at most).
+*/
+void MappedImage::rangeOf(const Rect &region, int advice) const
+{
+    assert(isOpen());
+    Rect r = region & Rect(0, 0, imageSize.width, imageSize.height);
+    size_t bytes = pixelBytes(imageType);
+    size_t page = pageSize();
+    forEachBlock(r, [&](const Block &b, const Rect &inside) {
+        size_t begin = b.offset + (size_t) (inside.y - b.rect.y) * blockStep;
+        size_t end = b.offset + (size_t) (inside.y + inside.height - 1 - b.rect.y) * blockStep
+                   + (size_t) b.rect.width * bytes;
+        begin = begin / page * page;
+        madvise(base + begin, min(end, length) - begin, advice);
+    });
+}
+
+void MappedImage::prefetch(const Rect &region) const
+{
+    rangeOf(region, MADV_WILLNEED);
+}
+
+void MappedImage::evict(const Rect &region) const
+{
+    rangeOf(region, MADV_DONTNEED);
+}
+
+void MappedImage::flush() const
+{
+    if (isOpen() && writableMapping)
+        msync(base, length, MS_SYNC);
+}
+
+bool writeImageFile(const string &path, const Mat &image, ImageFileFormat format, Size tileSize)
+{
+    MappedImage file;
+    if (!file.create(path, format, image.rows, image.cols, image.type(), tileSize))
+        return false;
+    file.write(image);
+    file.close();
+    return true;
+}
@@ -0,0 +1,212 @@
+#ifndef MAPPED_IMAGE_H
+#define MAPPED_IMAGE_H
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+    Layouts of the image files that can be memory mapped.
+
+    FILE_RAW  : samples only, row major, in the byte order of the machine,
+                after an optional header of a given size.
+    FILE_PNM  : binary PGM (P5, 1 channel) or PPM (P6, 3 channels, RGB
+                order), 8 or 16 bits; 16-bit samples are big endian.
+    FILE_TIFF : uncompressed TIFF or BigTIFF (first image only) stored as
+                strips or tiles, 1 to 4 interleaved channels of 8, 16, 32
+                or 64 bits, integer or float.
+*/
+enum ImageFileFormat {
+    FILE_RAW,
+    FILE_PNM,
+    FILE_TIFF
+};
+
+/**
+    Access pattern of a mapping, passed to the kernel as read ahead policy.
+
+    MAPPED_NORMAL     : default read ahead.
+    MAPPED_SEQUENTIAL : blocks are visited in file order (strips top to
+                        bottom): aggressive read ahead.
+    MAPPED_RANDOM     : blocks are visited out of order (tiles of a region):
+                        no read ahead, prefetch() gives the pages needed.
+*/
+enum MappedAccess {
+    MAPPED_NORMAL,
+    MAPPED_SEQUENTIAL,
+    MAPPED_RANDOM
+};
+
+/**
+    Image file mapped in memory: pixels are read from (or written to) the
+    page cache on demand, so an image larger than the memory can be
+    processed region by region without decoding it first.
+
+    The file is stored as blocks: the tiles or strips of a TIFF file, a
+    single block for raw and PNM files. When the samples are in the byte
+    order of the machine, view() and block() give cv::Mat headers pointing
+    into the mapping (no copy); the filters take them as any other image:
+
+        MappedImage scan;
+        if (scan.open("scan.pgm")) {
+            scan.advise(MAPPED_SEQUENTIAL);
+            Mat blurred = convolution(scan.view(), gauss);
+        }
+
+    A view can only cover pixels stored one row after the other: any region
+    of a raw or PNM file or of a TIFF whose strips follow each other, a
+    region inside one tile of a tiled TIFF. read() copies any region,
+    assembling tiles and swapping bytes when needed (e.g. with the halo of a
+    filter around a tile).
+
+    Views are headers on the mapping: they must not be used after close()
+    or the destruction of the MappedImage. Files are mapped shared, writing
+    through a view of a writable mapping writes the file.
+*/
+class MappedImage {
+public:
+    MappedImage() = default;
+    ~MappedImage();
+    MappedImage(MappedImage &&other) noexcept;
+    MappedImage &operator=(MappedImage &&other) noexcept;
+    MappedImage(const MappedImage &) = delete;
+    MappedImage &operator=(const MappedImage &) = delete;
+
+    /**
+        Maps a PGM / PPM or TIFF file, the format being given by its magic
+        number. Returns false (and stays closed) when the file cannot be
+        mapped or its layout is not supported.
+    */
+    bool open(const std::string &path, bool writable = false);
+
+    /**
+        Maps a raw file holding rows x cols samples of type after
+        headerBytes bytes.
+    */
+    bool openRaw(const std::string &path, int rows, int cols, int type, size_t headerBytes = 0,
+                 bool writable = false);
+
+    /**
+        Creates (or replaces) path with a rows x cols image of type in the
+        given format and maps it writable; the pixels are zero. TIFF files
+        are tiled with tileSize (multiples of 16) or stored as consecutive
+        strips when tileSize is empty, in the byte order of the machine.
+        PNM files take 8 or 16-bit images of 1 or 3 channels. Returns false
+        (and stays closed) when the file cannot be created or mapped.
+    */
+    bool create(const std::string &path, ImageFileFormat format, int rows, int cols, int type,
+                cv::Size tileSize = cv::Size());
+
+    /**
+        Flushes a writable mapping and unmaps the file.
+    */
+    void close();
+
+    bool isOpen() const { return base != nullptr; }
+    bool writable() const { return writableMapping; }
+    ImageFileFormat format() const { return fileFormat; }
+    int rows() const { return imageSize.height; }
+    int cols() const { return imageSize.width; }
+    cv::Size size() const { return imageSize; }
+    int type() const { return imageType; }
+
+    /**
+        True when the samples are stored in the byte order of the machine,
+        false for 16-bit PNM files and TIFF files of the other byte order:
+        views are then not available and read() / write() swap the bytes.
+    */
+    bool nativeByteOrder() const { return !swapBytes; }
+
+    /**
+        Blocks of the file (tiles of a tiled TIFF, strips of a TIFF, a single
+        block otherwise) and the rectangle of the image each one holds.
+    */
+    int blockCount() const { return (int) blocks.size(); }
+    cv::Rect blockRect(int index) const;
+    cv::Size blockSize() const { return blockShape; }
+
+    /**
+        View of the block index, empty when the byte order is not native.
+    */
+    cv::Mat block(int index) const;
+
+    /**
+        View of region (of the whole image by default), empty when the
+        byte order is not native or the pixels of region are not stored
+        one row after the other.
+    */
+    cv::Mat view(const cv::Rect &region) const;
+    cv::Mat view() const { return view(cv::Rect(0, 0, imageSize.width, imageSize.height)); }
+
+    /**
+        Copy of region into dst (reused when it already has the size and
+        type of region), in the byte order of the machine.
+    */
+    void read(const cv::Rect &region, cv::Mat &dst) const;
+    cv::Mat read(const cv::Rect &region) const;
+
+    /**
+        Writes image (of the type of the file) with its upper left corner
+        at origin, into a writable mapping.
+    */
+    void write(const cv::Mat &image, cv::Point origin = cv::Point(0, 0));
+
+    /**
+        Read ahead policy of the whole mapping.
+    */
+    void advise(MappedAccess access) const;
+
+    /**
+        Starts reading the pages holding region in the background, so that
+        the filter that reads them next does not wait for the disk.
+    */
+    void prefetch(const cv::Rect &region) const;
+
+    /**
+        Drops the pages holding region from the memory of the process once
+        it is done with them (written pages stay in the file).
+    */
+    void evict(const cv::Rect &region) const;
+
+    /**
+        Writes the modified pages back to the file.
+    */
+    void flush() const;
+
+private:
+    struct Block {
+        size_t offset; // of the first sample of the block in the file
+        cv::Rect rect; // pixels of the image held by the block
+    };
+
+    bool mapFile(const std::string &path, bool writable, size_t length);
+    bool parsePnm();
+    bool parseTiff();
+    bool setLayout(int type, size_t dataOffset, size_t rowStep);
+    bool validBlocks() const;
+    void rangeOf(const cv::Rect &region, int advice) const;
+    template<typename F>
+    void forEachBlock(const cv::Rect &region, F f) const;
+
+    unsigned char *base = nullptr;
+    size_t length = 0;
+    bool writableMapping = false;
+    ImageFileFormat fileFormat = FILE_RAW;
+    cv::Size imageSize;
+    int imageType = 0;
+    bool swapBytes = false;
+    cv::Size blockShape;   // full size of a block (tiles may overhang the image)
+    size_t blockStep = 0;  // bytes between two rows of a block
+    bool contiguous = false; // blocks are full width and follow each other
+    std::vector<Block> blocks;
+};
+
+/**
+    Writes image to path in the given format through a mapping (see
+    MappedImage::create). Returns false when the file cannot be written.
+*/
+bool writeImageFile(const std::string &path, const cv::Mat &image, ImageFileFormat format,
+                    cv::Size tileSize = cv::Size());
+
+#endif
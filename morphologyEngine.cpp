@@ -0,0 +1,305 @@
+#include "morphologyEngine.h"
+#include "parallel.h"
+#include "bufferPool.h"
+#include "pixelTraits.h"
+#include "fixedKernels.h"
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <type_traits>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+template<typename T>
+struct MaxOp {
+    static T neutral() { return PixelTraits<T>::lowest(); }
+    T operator()(T a, T b) const { return a > b ? a : b; }
+};
+
+template<typename T>
+struct MinOp {
+    static T neutral() { return PixelTraits<T>::highest(); }
+    T operator()(T a, T b) const { return a < b ? a : b; }
+};
+
+/**
+    Offsets (x = column, y = row) from the center of the non zero pixels of
+    the structuring element.
+*/
+static vector<Point2i> structuringOffsets(const Mat &structuringElement) {
+    int window_width = (structuringElement.rows - 1) / 2;
+    int window_height = (structuringElement.cols - 1) / 2;
+    vector<Point2i> offsets;
+    for (int x = -window_width; x <= window_width; x++) {
+        for (int y = -window_height; y <= window_height; y++) {
+            if (structuringElement.at<float>(x + window_width, y + window_height) == 1)
+                offsets.push_back(Point2i(y, x));
+        }
+    }
+    return offsets;
+}
+
+/**
+    True when the offsets fill their bounding box, returned in box
+    (x, y = offset of the upper left corner).
+*/
+static bool rectangularElement(const vector<Point2i> &offsets, Rect &box) {
+    if (offsets.empty())
+        return false;
+    int minX = offsets[0].x, maxX = minX, minY = offsets[0].y, maxY = minY;
+    for (const Point2i &o : offsets) {
+        minX = min(minX, o.x);
+        maxX = max(maxX, o.x);
+        minY = min(minY, o.y);
+        maxY = max(maxY, o.y);
+    }
+    box = Rect(minX, minY, maxX - minX + 1, maxY - minY + 1);
+    return (int) offsets.size() == box.width * box.height;
+}
+
+/**
+    van Herk / Gil-Werman running extremum of width w over the line e of
+    length n + w - 1: out[t] = op(e[t], ..., e[t + w - 1]) for t in [0, n).
+    g holds the running extremum from the start of each block of w samples,
+    h the running extremum from the end of each block.
+*/
+template<typename T, typename Op>
+static void vanHerkLine(const T *e, int n, int w, T *g, T *h, T *out) {
+    Op op;
+    int length = n + w - 1;
+    for (int t = 0; t < length; t++) {
+        g[t] = t % w == 0 ? e[t] : op(g[t - 1], e[t]);
+    }
+    for (int t = length - 1; t >= 0; t--) {
+        h[t] = (t % w == w - 1 || t == length - 1) ? e[t] : op(h[t + 1], e[t]);
+    }
+    for (int t = 0; t < n; t++) {
+        out[t] = op(h[t], g[t + w - 1]);
+    }
+}
+
+/**
+    Morphology by a rectangle of offsets box: a horizontal van Herk pass of
+    width box.width into pass, then a vertical one of height box.height.
+    Missing samples are replaced by the neutral element of the operation,
+    which is the same as ignoring them.
+*/
+template<typename T, typename Op>
+static void rectangleMorphology(const Mat &image, const Rect &box, Mat &dst, Mat &pass, PaddingMode padding) {
+    Op op;
+    int rows = image.rows;
+    int cols = image.cols;
+    ensureImage(pass, rows, cols, image.type());
+    ensureImage(dst, rows, cols, image.type());
+
+    parallel_for_2d(rows, cols, Size(cols, 16), [&](const Rect &strip) {
+        int length = cols + box.width - 1;
+        ScratchScope scratch;
+        T *e = scratch.allocate<T>(length);
+        T *g = scratch.allocate<T>(length);
+        T *h = scratch.allocate<T>(length);
+        for (int i = strip.y; i < strip.y + strip.height; i++) {
+            const T *in = image.ptr<T>(i);
+            for (int t = 0; t < length; t++) {
+                int x = borderIndex(t + box.x, cols, padding);
+                e[t] = x >= 0 ? in[x] : Op::neutral();
+            }
+            vanHerkLine<T, Op>(e, cols, box.width, g, h, pass.ptr<T>(i));
+        }
+    });
+
+    // the vertical pass works on whole rows of a column band, so every
+    // running extremum is an elementwise operation on contiguous memory
+    int w = box.height;
+    int length = rows + w - 1;
+    parallel_for_2d(rows, cols, Size(64, rows), [&](const Rect &band) {
+        int bw = band.width;
+        ScratchScope scratch;
+        T *neutralRow = scratch.allocate<T>(bw);
+        fill(neutralRow, neutralRow + bw, Op::neutral());
+        const T **e = scratch.allocate<const T *>(length);
+        for (int t = 0; t < length; t++) {
+            int y = borderIndex(t + box.y, rows, padding);
+            e[t] = y >= 0 ? pass.ptr<T>(y) + band.x : neutralRow;
+        }
+
+        T *g = scratch.allocate<T>((size_t) length * bw);
+        T *h = scratch.allocate<T>((size_t) length * bw);
+        for (int t = 0; t < length; t++) {
+            T *gt = &g[(size_t) t * bw];
+            if (t % w == 0) {
+                copy(e[t], e[t] + bw, gt);
+            } else {
+                const T *gp = gt - bw;
+                for (int x = 0; x < bw; x++) gt[x] = op(gp[x], e[t][x]);
+            }
+        }
+        for (int t = length - 1; t >= 0; t--) {
+            T *ht = &h[(size_t) t * bw];
+            if (t % w == w - 1 || t == length - 1) {
+                copy(e[t], e[t] + bw, ht);
+            } else {
+                const T *hn = ht + bw;
+                for (int x = 0; x < bw; x++) ht[x] = op(hn[x], e[t][x]);
+            }
+        }
+        for (int i = 0; i < rows; i++) {
+            const T *hi = &h[(size_t) i * bw];
+            const T *gi = &g[(size_t) (i + w - 1) * bw];
+            T *out = dst.ptr<T>(i) + band.x;
+            for (int x = 0; x < bw; x++) out[x] = op(hi[x], gi[x]);
+        }
+    });
+}
+
+/**
+    Morphology by an arbitrary list of offsets. Inside the image each offset
+    is applied to a whole row segment at once (elementwise extremum of two
+    contiguous arrays), near the border every sample goes through borderIndex.
+*/
+template<typename T, typename Op>
+static void offsetMorphology(const Mat &image, const vector<Point2i> &offsets, Mat &dst, PaddingMode padding) {
+    Op op;
+    int ky = 0, kx = 0;
+    for (const Point2i &o : offsets) {
+        ky = max(ky, abs(o.y));
+        kx = max(kx, abs(o.x));
+    }
+    ensureImage(dst, image.rows, image.cols, image.type());
+
+    auto interior = [&](int i, int j0, int j1) {
+        T *out = dst.ptr<T>(i);
+        fill(out + j0, out + j1, Op::neutral());
+        for (const Point2i &o : offsets) {
+            const T *in = image.ptr<T>(i + o.y) + o.x;
+            for (int j = j0; j < j1; j++) {
+                out[j] = op(out[j], in[j]);
+            }
+        }
+    };
+    auto border = [&](int i, int j) {
+        T best = Op::neutral();
+        for (const Point2i &o : offsets) {
+            int y = borderIndex(i + o.y, image.rows, padding);
+            int x = borderIndex(j + o.x, image.cols, padding);
+            if (y >= 0 && x >= 0)
+                best = op(best, image.at<T>(y, x));
+        }
+        dst.at<T>(i, j) = best;
+    };
+    parallel_for_2d(image.rows, image.cols, 2 * sizeof(T), [&](const Rect &tile) {
+        forEachPixelSplit(image.rows, image.cols, ky, kx, tile, interior, border);
+    });
+}
+
+template<template<typename> class Op>
+static void morphology(const Mat &image, const Mat &structuringElement, Mat &dst,
+                       MorphologyBuffers &buffers, PaddingMode padding) {
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1 || image.type() == CV_16UC1);
+    assert(structuringElement.type() == CV_32FC1);
+    assert(dst.data == nullptr || dst.data != image.data);
+
+    // 3x3 cross and square: one unrolled pass
+    if (fixedMorphology(image, structuringElement, dst, padding, is_same<Op<float>, MaxOp<float>>::value))
+        return;
+
+    vector<Point2i> offsets = structuringOffsets(structuringElement);
+    Rect box;
+    bool rectangle = rectangularElement(offsets, box);
+    dispatchDepth(image.depth(), [&](auto pixel) {
+        typedef decltype(pixel) T;
+        if (rectangle)
+            rectangleMorphology<T, Op<T>>(image, box, dst, buffers.pass, padding);
+        else
+            offsetMorphology<T, Op<T>>(image, offsets, dst, padding);
+    });
+}
+
+void dilateFilter(const Mat &image, const Mat &structuringElement, Mat &dst,
+                  MorphologyBuffers &buffers, PaddingMode padding)
+{
+    morphology<MaxOp>(image, structuringElement, dst, buffers, padding);
+}
+
+void erodeFilter(const Mat &image, const Mat &structuringElement, Mat &dst,
+                 MorphologyBuffers &buffers, PaddingMode padding)
+{
+    morphology<MinOp>(image, structuringElement, dst, buffers, padding);
+}
+
+Mat dilateFilter(Mat image, Mat structuringElement, PaddingMode padding)
+{
+    MorphologyBuffers buffers;
+    Mat res;
+    dilateFilter(image, structuringElement, res, buffers, padding);
+    return res;
+}
+
+Mat erodeFilter(Mat image, Mat structuringElement, PaddingMode padding)
+{
+    MorphologyBuffers buffers;
+    Mat res;
+    erodeFilter(image, structuringElement, res, buffers, padding);
+    return res;
+}
+
+void openFilter(const Mat &image, const Mat &structuringElement, Mat &dst,
+                MorphologyBuffers &buffers, PaddingMode padding)
+{
+    erodeFilter(image, structuringElement, buffers.intermediate, buffers, padding);
+    dilateFilter(buffers.intermediate, structuringElement, dst, buffers, padding);
+}
+
+void closeFilter(const Mat &image, const Mat &structuringElement, Mat &dst,
+                 MorphologyBuffers &buffers, PaddingMode padding)
+{
+    dilateFilter(image, structuringElement, buffers.intermediate, buffers, padding);
+    erodeFilter(buffers.intermediate, structuringElement, dst, buffers, padding);
+}
+
+void gradientFilter(const Mat &image, const Mat &structuringElement, Mat &dst,
+                    MorphologyBuffers &buffers, PaddingMode padding)
+{
+    erodeFilter(image, structuringElement, buffers.intermediate, buffers, padding);
+    dilateFilter(image, structuringElement, dst, buffers, padding);
+
+    // dilation minus erosion, in place (saturated at 0 for integer images,
+    // where only windows without any sample have a dilation below the erosion)
+    dispatchDepth(dst.depth(), [&](auto pixel) {
+        typedef decltype(pixel) T;
+        parallel_for_2d(dst.rows, dst.cols, 2 * sizeof(T), [&](const Rect &tile) {
+            for (int i = tile.y; i < tile.y + tile.height; i++) {
+                T *out = dst.ptr<T>(i);
+                const T *eroded = buffers.intermediate.ptr<T>(i);
+                for (int j = tile.x; j < tile.x + tile.width; j++) {
+                    out[j] = storePixel<T>((float) out[j] - (float) eroded[j]);
+                }
+            }
+        });
+    });
+}
+
+Mat openFilter(Mat image, Mat structuringElement, PaddingMode padding)
+{
+    MorphologyBuffers buffers;
+    Mat res;
+    openFilter(image, structuringElement, res, buffers, padding);
+    return res;
+}
+
+Mat closeFilter(Mat image, Mat structuringElement, PaddingMode padding)
+{
+    MorphologyBuffers buffers;
+    Mat res;
+    closeFilter(image, structuringElement, res, buffers, padding);
+    return res;
+}
+
+Mat gradientFilter(Mat image, Mat structuringElement, PaddingMode padding)
+{
+    MorphologyBuffers buffers;
+    Mat res;
+    gradientFilter(image, structuringElement, res, buffers, padding);
+    return res;
+}
@@ -0,0 +1,62 @@
+#ifndef MORPHOLOGY_ENGINE_H
+#define MORPHOLOGY_ENGINE_H
+
+#include <opencv2/core.hpp>
+#include "border.h"
+
+/**
+    Scratch images of the morphology operators. Reusing the same buffers
+    across calls on images of the same size avoids any allocation.
+*/
+struct MorphologyBuffers {
+    cv::Mat pass;         // result of the first 1D pass of a rectangular element
+    cv::Mat intermediate; // result of the first operator of open / close / gradient
+};
+
+/**
+    Dilation (maximum over the non zero pixels of the structuring element)
+    of an 8-bit, 16-bit or float image into dst, which must not be image and
+    gets the type of image.
+    Samples missing under the padding mode are ignored, a pixel whose window
+    has no sample is set to the lowest value of the type (-inf for float).
+
+    When the non zero pixels of the structuring element fill a rectangle (in
+    particular horizontal and vertical lines) the dilation is split in two 1D
+    passes computed with the van Herk / Gil-Werman algorithm: 3 comparisons
+    per pixel whatever the size of the element. Other elements go through
+    the list of their non zero offsets.
+*/
+void dilateFilter(const cv::Mat &image, const cv::Mat &structuringElement, cv::Mat &dst,
+                  MorphologyBuffers &buffers, PaddingMode padding = PAD_ZERO);
+
+/**
+    Erosion (minimum over the non zero pixels of the structuring element),
+    same as dilateFilter with the highest value of the type (+inf for
+    float) for pixels whose window has no sample.
+*/
+void erodeFilter(const cv::Mat &image, const cv::Mat &structuringElement, cv::Mat &dst,
+                 MorphologyBuffers &buffers, PaddingMode padding = PAD_ZERO);
+
+cv::Mat dilateFilter(cv::Mat image, cv::Mat structuringElement, PaddingMode padding = PAD_ZERO);
+cv::Mat erodeFilter(cv::Mat image, cv::Mat structuringElement, PaddingMode padding = PAD_ZERO);
+
+/**
+    Opening (dilation of the erosion), closing (erosion of the dilation) and
+    morphological gradient (dilation minus erosion) into dst, which must be
+    neither image nor buffers.intermediate. The intermediate image and the 1D
+    pass buffer are taken from buffers and shared by both operators, so
+    frames of the same size allocate nothing. The gradient of an integer
+    image is saturated at 0.
+*/
+void openFilter(const cv::Mat &image, const cv::Mat &structuringElement, cv::Mat &dst,
+                MorphologyBuffers &buffers, PaddingMode padding = PAD_ZERO);
+void closeFilter(const cv::Mat &image, const cv::Mat &structuringElement, cv::Mat &dst,
+                 MorphologyBuffers &buffers, PaddingMode padding = PAD_ZERO);
+void gradientFilter(const cv::Mat &image, const cv::Mat &structuringElement, cv::Mat &dst,
+                    MorphologyBuffers &buffers, PaddingMode padding = PAD_ZERO);
+
+cv::Mat openFilter(cv::Mat image, cv::Mat structuringElement, PaddingMode padding = PAD_ZERO);
+cv::Mat closeFilter(cv::Mat image, cv::Mat structuringElement, PaddingMode padding = PAD_ZERO);
+cv::Mat gradientFilter(cv::Mat image, cv::Mat structuringElement, PaddingMode padding = PAD_ZERO);
+
+#endif
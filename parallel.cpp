@@ -0,0 +1,250 @@
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <unistd.h>
+using namespace cv;
+using namespace std;
+
+/**
+    Work stealing thread pool running one batch of indexed tasks at a time.
+
+    Each worker owns a queue: it pops tasks from the back of its own queue
+    and, once empty, steals from the front of the other queues. The thread
+    calling run() takes part in the work with the last queue. Queues are
+    vectors read from both ends that keep their capacity from batch to batch,
+    so that running a batch does not allocate once they have grown.
+*/
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads) : queues(threads) {
+        for (auto &q : queues) {
+            q.reset(new Queue());
+        }
+        for (int t = 0; t < threads - 1; t++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this, t);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lock(stateMutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (thread &w : workers) {
+            w.join();
+        }
+    }
+
+    int size() const {
+        return (int) queues.size();
+    }
+
+    void run(int taskCount, FunctionRef<void(int)> task) {
+        lock_guard<mutex> runLock(runMutex);
+        {
+            lock_guard<mutex> lock(stateMutex);
+            job = &task;
+            remaining = taskCount;
+            int n = (int) queues.size();
+            for (auto &q : queues) {
+                lock_guard<mutex> qLock(q->m);
+                q->tasks.clear();
+                q->front = 0;
+            }
+            for (int t = 0; t < taskCount; t++) {
+                Queue &q = *queues[t % n];
+                lock_guard<mutex> qLock(q.m);
+                q.tasks.push_back(t);
+            }
+            generation++;
+        }
+        wake.notify_all();
+
+        work((int) queues.size() - 1);
+
+        unique_lock<mutex> lock(stateMutex);
+        done.wait(lock, [&]() { return remaining == 0; });
+        job = nullptr;
+    }
+
+private:
+    struct Queue {
+        mutex m;
+        vector<int> tasks; // tasks [front, size) are left
+        size_t front = 0;
+    };
+
+    bool popOrSteal(int self, int &task) {
+        int n = (int) queues.size();
+        {
+            Queue &own = *queues[self];
+            lock_guard<mutex> lock(own.m);
+            if (own.front < own.tasks.size()) {
+                task = own.tasks.back();
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (int d = 1; d < n; d++) {
+            Queue &victim = *queues[(self + d) % n];
+            lock_guard<mutex> lock(victim.m);
+            if (victim.front < victim.tasks.size()) {
+                task = victim.tasks[victim.front++];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(int self) {
+        int task;
+        while (popOrSteal(self, task)) {
+            (*job)(task);
+            lock_guard<mutex> lock(stateMutex);
+            if (--remaining == 0)
+                done.notify_all();
+        }
+    }
+
+    void workerLoop(int self) {
+        insideWorker = true;
+        long seen = 0;
+        while (true) {
+            {
+                unique_lock<mutex> lock(stateMutex);
+                wake.wait(lock, [&]() { return stop || generation != seen; });
+                if (stop)
+                    return;
+                seen = generation;
+            }
+            work(self);
+        }
+    }
+
+    vector<unique_ptr<Queue>> queues;
+    vector<thread> workers;
+    mutex runMutex;
+    mutex stateMutex;
+    condition_variable wake, done;
+    const FunctionRef<void(int)> *job = nullptr;
+    int remaining = 0;
+    long generation = 0;
+    bool stop = false;
+
+public:
+    static thread_local bool insideWorker;
+};
+
+thread_local bool ThreadPool::insideWorker = false;
+
+static mutex poolMutex;
+static shared_ptr<ThreadPool> pool;
+static int numThreads = 0;
+
+static int hardwareThreads() {
+    return max(1, (int) thread::hardware_concurrency());
+}
+
+void setNumThreads(int n)
+{
+    lock_guard<mutex> lock(poolMutex);
+    numThreads = n <= 0 ? hardwareThreads() : n;
+    if (pool && pool->size() != numThreads)
+        pool.reset();
+}
+
+int getNumThreads()
+{
+    lock_guard<mutex> lock(poolMutex);
+    return numThreads <= 0 ? hardwareThreads() : numThreads;
+}
+
+/**
+    Pool of the current thread count, null when it is 1. The caller holds a
+    reference for the whole batch, so that setNumThreads() replacing the
+    pool meanwhile only destroys it once the batch is done.
+*/
+static shared_ptr<ThreadPool> getPool() {
+    lock_guard<mutex> lock(poolMutex);
+    int n = numThreads <= 0 ? hardwareThreads() : numThreads;
+    if (n <= 1)
+        return nullptr;
+    if (!pool)
+        pool = make_shared<ThreadPool>(n);
+    return pool;
+}
+
+static int l2CacheSize() {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (size > 0)
+        return (int) size;
+#endif
+    return 256 * 1024;
+}
+
+Size l2TileSize(int rows, int cols, int bytesPerPixel)
+{
+    assert(bytesPerPixel > 0);
+    static const int budget = l2CacheSize() / 2;
+    int tileCols = max(1, min(cols, 512));
+    int tileRows = max(8, budget / (tileCols * bytesPerPixel));
+    return Size(tileCols, max(1, min(rows, tileRows)));
+}
+
+/**
+    Run task(0), ..., task(count-1) on the pool, or serially on the calling
+    thread when there is no pool or when called from inside a task.
+*/
+static void runTasks(int count, FunctionRef<void(int)> task) {
+    shared_ptr<ThreadPool> p = ThreadPool::insideWorker ? nullptr : getPool();
+    if (p == nullptr || count <= 1) {
+        for (int t = 0; t < count; t++) {
+            task(t);
+        }
+        return;
+    }
+    // the calling thread counts as a worker while it takes part in the batch
+    bool previous = ThreadPool::insideWorker;
+    ThreadPool::insideWorker = true;
+    p->run(count, task);
+    ThreadPool::insideWorker = previous;
+}
+
+void parallel_for_2d(int rows, int cols, Size tileSize, FunctionRef<void(const Rect &)> body)
+{
+    if (rows <= 0 || cols <= 0)
+        return;
+    int tileRows = max(1, tileSize.height);
+    int tileCols = max(1, tileSize.width);
+    int tilesY = (rows + tileRows - 1) / tileRows;
+    int tilesX = (cols + tileCols - 1) / tileCols;
+
+    runTasks(tilesY * tilesX, [&](int t) {
+        int y = (t / tilesX) * tileRows;
+        int x = (t % tilesX) * tileCols;
+        body(Rect(x, y, min(tileCols, cols - x), min(tileRows, rows - y)));
+    });
+}
+
+void parallel_for_2d(int rows, int cols, int bytesPerPixel, FunctionRef<void(const Rect &)> body)
+{
+    parallel_for_2d(rows, cols, l2TileSize(rows, cols, bytesPerPixel), body);
+}
+
+void parallel_for_1d(int n, int grain, FunctionRef<void(int, int)> body)
+{
+    if (n <= 0)
+        return;
+    grain = max(1, grain);
+    runTasks((n + grain - 1) / grain, [&](int t) {
+        body(t * grain, min(n, (t + 1) * grain));
+    });
+}
@@ -0,0 +1,70 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <opencv2/core.hpp>
+#include <utility>
+
+/**
+    Non owning reference to a callable, for the bodies of the parallel loops:
+    unlike std::function it never copies the callable (nor allocates for a
+    lambda with many captures), so it is only valid during the call it is
+    passed to.
+*/
+template<typename Signature>
+class FunctionRef;
+
+template<typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+public:
+    template<typename F>
+    FunctionRef(const F &f)
+        : object(&f), call([](const void *o, Args... args) -> R {
+              return (*(const F *) o)(std::forward<Args>(args)...);
+          }) {}
+
+    R operator()(Args... args) const { return call(object, std::forward<Args>(args)...); }
+
+private:
+    const void *object;
+    R (*call)(const void *, Args...);
+};
+
+/**
+    Number of threads used by the parallel loops (the calling thread included).
+    n <= 0 selects the number of hardware threads, n == 1 runs everything
+    on the calling thread. May be called while loops run on other threads:
+    they finish on the pool they started with.
+*/
+void setNumThreads(int n);
+int getNumThreads();
+
+/**
+    Tile size such that the tiles of an operation reading and writing
+    bytesPerPixel bytes per pixel fit in half of the L2 cache.
+*/
+cv::Size l2TileSize(int rows, int cols, int bytesPerPixel);
+
+/**
+    Run body on every tile of a rows x cols domain cut in tiles of tileSize,
+    spread over the thread pool. Tiles are given as rectangles (x, y = column,
+    row of the upper left corner).
+
+    The tiling only depends on the domain and tile sizes, never on the number
+    of threads, so an operation whose tiles are independent gives the same
+    bits whatever the thread count. Nested calls run on the calling thread.
+*/
+void parallel_for_2d(int rows, int cols, cv::Size tileSize,
+                     FunctionRef<void(const cv::Rect &)> body);
+
+/**
+    Same as above with tiles sized for the L2 cache (see l2TileSize).
+*/
+void parallel_for_2d(int rows, int cols, int bytesPerPixel,
+                     FunctionRef<void(const cv::Rect &)> body);
+
+/**
+    Run body(begin, end) on the chunks of [0, n) of at most grain elements.
+*/
+void parallel_for_1d(int n, int grain, FunctionRef<void(int, int)> body);
+
+#endif
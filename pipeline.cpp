@@ -0,0 +1,359 @@
+#include "pipeline.h"
+#include "simdKernels.h"
+#include "parallel.h"
+#include "bufferPool.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+Pipeline::Pipeline(PaddingMode padding) : padding(padding), stages(1)
+{
+    assert(padding != PAD_WRAP && "pipeline: PAD_WRAP is not supported");
+}
+
+Pipeline::Node Pipeline::add(const PipelineStage &stage)
+{
+    assert(stage.a >= 0 && stage.a < size());
+    assert(stage.b < size());
+    stages.push_back(stage);
+    return size() - 1;
+}
+
+Pipeline::Node Pipeline::convolve(Node in, Mat kernel)
+{
+    assert(kernel.type() == CV_32FC1);
+    assert(kernel.rows % 2 == 1 && kernel.cols % 2 == 1);
+    PipelineStage stage;
+    stage.kind = STAGE_CONVOLVE;
+    stage.a = in;
+    stage.ky = (kernel.rows - 1) / 2;
+    stage.kx = (kernel.cols - 1) / 2;
+    stage.kernel = kernel.clone();
+    return add(stage);
+}
+
+Pipeline::Node Pipeline::mean(Node in, int k)
+{
+    assert(k >= 0);
+    int size = 2 * k + 1;
+    return convolve(in, Mat(size, size, CV_32FC1, Scalar(1.0 / (size * size))));
+}
+
+Pipeline::Node Pipeline::sobel(Node in)
+{
+    PipelineStage stage;
+    stage.kind = STAGE_SOBEL;
+    stage.a = in;
+    stage.ky = stage.kx = 1;
+    return add(stage);
+}
+
+/**
+    Offsets of the pixels of the structuring element equal to 1, as read by
+    the morphology engine.
+*/
+static PipelineStage morphologyStage(PipelineStageKind kind, int in, const Mat &structuringElement) {
+    assert(structuringElement.type() == CV_32FC1);
+    int ry = (structuringElement.rows - 1) / 2;
+    int rx = (structuringElement.cols - 1) / 2;
+    PipelineStage stage;
+    stage.kind = kind;
+    stage.a = in;
+    for (int m = -ry; m <= ry; m++) {
+        for (int n = -rx; n <= rx; n++) {
+            if (structuringElement.at<float>(m + ry, n + rx) == 1) {
+                stage.offsets.push_back(Point2i(n, m));
+                stage.ky = max(stage.ky, abs(m));
+                stage.kx = max(stage.kx, abs(n));
+            }
+        }
+    }
+    return stage;
+}
+
+Pipeline::Node Pipeline::dilate(Node in, Mat structuringElement)
+{
+    return add(morphologyStage(STAGE_DILATE, in, structuringElement));
+}
+
+Pipeline::Node Pipeline::erode(Node in, Mat structuringElement)
+{
+    return add(morphologyStage(STAGE_ERODE, in, structuringElement));
+}
+
+Pipeline::Node Pipeline::open(Node in, Mat structuringElement)
+{
+    return dilate(erode(in, structuringElement), structuringElement);
+}
+
+Pipeline::Node Pipeline::close(Node in, Mat structuringElement)
+{
+    return erode(dilate(in, structuringElement), structuringElement);
+}
+
+Pipeline::Node Pipeline::gradient(Node in, Mat structuringElement)
+{
+    return subtract(dilate(in, structuringElement), erode(in, structuringElement));
+}
+
+Pipeline::Node Pipeline::threshold(Node in, float threshold, float low, float high)
+{
+    PipelineStage stage;
+    stage.kind = STAGE_THRESHOLD;
+    stage.a = in;
+    stage.threshold = threshold;
+    stage.low = low;
+    stage.high = high;
+    return add(stage);
+}
+
+Pipeline::Node Pipeline::subtract(Node a, Node b)
+{
+    assert(b >= 0);
+    PipelineStage stage;
+    stage.kind = STAGE_SUBTRACT;
+    stage.a = a;
+    stage.b = b;
+    return add(stage);
+}
+
+/********************************************
+                  EXECUTION
+*********************************************/
+
+/**
+    Pixels of region (image coordinates) of a stage, stored in mat.
+*/
+struct StageView {
+    Mat mat;
+    Rect region;
+
+    float *ptr(int y, int x) const {
+        return (float *) mat.ptr<float>(y - region.y) + (x - region.x);
+    }
+
+    float &at(int y, int x) const {
+        return *ptr(y, x);
+    }
+};
+
+template<bool Dilate>
+static float extremum(float a, float b) {
+    return Dilate ? max(a, b) : min(a, b);
+}
+
+template<bool Dilate>
+static void morphologyStage(const PipelineStage &stage, const StageView &in, const StageView &out,
+                            Size image, PaddingMode padding) {
+    const float neutral = Dilate ? -numeric_limits<float>::infinity() : numeric_limits<float>::infinity();
+    auto interior = [&](int i, int j0, int j1) {
+        float *o = out.ptr(i, j0);
+        fill(o, o + (j1 - j0), neutral);
+        for (const Point2i &d : stage.offsets) {
+            const float *p = in.ptr(i + d.y, j0 + d.x);
+            for (int j = 0; j < j1 - j0; j++)
+                o[j] = extremum<Dilate>(o[j], p[j]);
+        }
+    };
+    auto border = [&](int i, int j) {
+        float best = neutral;
+        for (const Point2i &d : stage.offsets) {
+            int y = borderIndex(i + d.y, image.height, padding);
+            int x = borderIndex(j + d.x, image.width, padding);
+            if (y >= 0 && x >= 0)
+                best = extremum<Dilate>(best, in.at(y, x));
+        }
+        out.at(i, j) = best;
+    };
+    forEachPixelSplit(image.height, image.width, stage.ky, stage.kx, out.region, interior, border);
+}
+
+/**
+    Computes out.region of a stage from the views of its inputs, samples
+    outside of the image going through borderIndex as in the engines.
+*/
+static void runStage(const PipelineStage &stage, const StageView *a, const StageView *b, const StageView &out,
+                     Size image, PaddingMode padding) {
+    const Rect &r = out.region;
+    switch (stage.kind) {
+    case STAGE_CONVOLVE: {
+        const Mat &k = stage.kernel;
+        int ky = stage.ky, kx = stage.kx;
+        auto interior = [&](int i, int j0, int j1) {
+            float *o = out.ptr(i, j0);
+            fill(o, o + (j1 - j0), 0.0f);
+            for (int m = -ky; m <= ky; m++)
+                rowTaps(a->ptr(i + m, j0), k.ptr<float>(m + ky) + kx, kx, o, 0, j1 - j0);
+        };
+        auto border = [&](int i, int j) {
+            float sum_px = 0.0;
+            for (int m = -ky; m <= ky; m++) {
+                int y = borderIndex(i + m, image.height, padding);
+                if (y < 0)
+                    continue;
+                for (int n = -kx; n <= kx; n++) {
+                    int x = borderIndex(j + n, image.width, padding);
+                    if (x >= 0)
+                        sum_px += a->at(y, x) * k.at<float>(m + ky, n + kx);
+                }
+            }
+            out.at(i, j) = sum_px;
+        };
+        forEachPixelSplit(image.height, image.width, ky, kx, r, interior, border);
+        break;
+    }
+    case STAGE_SOBEL: {
+        static const float dx[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
+        static const float dy[3][3] = {{1, 2, 1}, {0, 0, 0}, {-1, -2, -1}};
+        auto interior = [&](int i, int j0, int j1) {
+            sobelRow(a->ptr(i - 1, j0), a->ptr(i, j0), a->ptr(i + 1, j0), out.ptr(i, j0), 0, j1 - j0);
+        };
+        auto border = [&](int i, int j) {
+            float dfdx = 0.0, dfdy = 0.0;
+            for (int m = -1; m <= 1; m++) {
+                int y = borderIndex(i + m, image.height, padding);
+                if (y < 0)
+                    continue;
+                for (int n = -1; n <= 1; n++) {
+                    int x = borderIndex(j + n, image.width, padding);
+                    if (x < 0)
+                        continue;
+                    dfdx += a->at(y, x) * dx[m + 1][n + 1];
+                    dfdy += a->at(y, x) * dy[m + 1][n + 1];
+                }
+            }
+            out.at(i, j) = fabs(dfdx) + fabs(dfdy);
+        };
+        forEachPixelSplit(image.height, image.width, 1, 1, r, interior, border);
+        break;
+    }
+    case STAGE_DILATE:
+        morphologyStage<true>(stage, *a, out, image, padding);
+        break;
+    case STAGE_ERODE:
+        morphologyStage<false>(stage, *a, out, image, padding);
+        break;
+    case STAGE_THRESHOLD:
+        for (int i = r.y; i < r.y + r.height; i++) {
+            const float *p = a->ptr(i, r.x);
+            float *o = out.ptr(i, r.x);
+            for (int j = 0; j < r.width; j++)
+                o[j] = p[j] > stage.threshold ? stage.high : stage.low;
+        }
+        break;
+    case STAGE_SUBTRACT:
+        for (int i = r.y; i < r.y + r.height; i++) {
+            const float *p = a->ptr(i, r.x);
+            const float *q = b->ptr(i, r.x);
+            float *o = out.ptr(i, r.x);
+            for (int j = 0; j < r.width; j++)
+                o[j] = p[j] - q[j];
+        }
+        break;
+    default:
+        assert(false && "pipeline: unknown stage");
+    }
+}
+
+Mat Pipeline::run(Mat image, Node output) const
+{
+    Mat res;
+    run(image, output, res);
+    return res;
+}
+
+void Pipeline::run(const Mat &image, Node output, Mat &res) const
+{
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1);
+    assert(output >= 0 && output < size());
+    assert(res.data == nullptr || res.data != image.data);
+    int n = output + 1;
+    Rect domain(0, 0, image.cols, image.rows);
+    ensureImage(res, image.rows, image.cols, CV_32FC1);
+    if (output == 0) {
+        image.convertTo(res, CV_32FC1);
+        return;
+    }
+
+    ScratchScope scratch;
+    int *consumers = scratch.allocate<int>(n);
+    fill(consumers, consumers + n, 0);
+    for (int s = 1; s < n; s++) {
+        consumers[stages[s].a]++;
+        if (stages[s].b >= 0)
+            consumers[stages[s].b]++;
+    }
+
+    parallel_for_2d(image.rows, image.cols, l2TileSize(image.rows, image.cols, (int) sizeof(float) * n),
+                    [&](const Rect &tile) {
+        // buffers of the stages, kept by the thread from tile to tile and run to run
+        thread_local vector<Mat> workspace;
+        if ((int) workspace.size() < n)
+            workspace.resize(n);
+
+        ScratchScope scratch;
+        Rect *needed = scratch.allocate<Rect>(n);
+        fill(needed, needed + n, Rect());
+        needed[output] = tile;
+        for (int s = output; s > 0; s--) {
+            const PipelineStage &stage = stages[s];
+            if (needed[s].empty())
+                continue;
+            Rect grown(needed[s].x - stage.kx, needed[s].y - stage.ky,
+                       needed[s].width + 2 * stage.kx, needed[s].height + 2 * stage.ky);
+            grown &= domain;
+            needed[stage.a] |= grown;
+            if (stage.b >= 0)
+                needed[stage.b] |= grown;
+        }
+
+        // views hold Mat headers: a vector kept by the thread rather than raw scratch
+        thread_local vector<StageView> views;
+        views.resize(max((int) views.size(), n));
+        for (int s = 0; s < n; s++) {
+            const PipelineStage &stage = stages[s];
+            StageView &view = views[s];
+            view.region = needed[s];
+            if (view.region.empty())
+                continue;
+            bool inPlace = stage.kind == STAGE_THRESHOLD && stage.a > 0 && consumers[stage.a] == 1
+                           && needed[stage.a] == view.region;
+            if (s == output) {
+                view.mat = res(view.region);
+            }
+            else if (s == 0 && image.type() == CV_32FC1) {
+                view.mat = image(view.region);
+                continue;
+            }
+            else if (inPlace) {
+                view.mat = views[stage.a].mat;
+            }
+            else {
+                Mat &buffer = workspace[s];
+                if (buffer.rows < view.region.height || buffer.cols < view.region.width)
+                    ensureImage(buffer, max(buffer.rows, view.region.height), max(buffer.cols, view.region.width),
+                                CV_32FC1);
+                view.mat = buffer(Rect(0, 0, view.region.width, view.region.height));
+            }
+
+            if (s == 0) {
+                for (int i = 0; i < view.region.height; i++) {
+                    const uchar *p = image.ptr<uchar>(view.region.y + i) + view.region.x;
+                    float *o = view.mat.ptr<float>(i);
+                    for (int j = 0; j < view.region.width; j++)
+                        o[j] = p[j];
+                }
+            }
+            else {
+                runStage(stage, &views[stage.a], stage.b >= 0 ? &views[stage.b] : nullptr, view,
+                         image.size(), padding);
+            }
+        }
+        // the views must not keep the image and the result alive after the run
+        for (int s = 0; s < n; s++)
+            views[s].mat.release();
+    });
+}
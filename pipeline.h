@@ -0,0 +1,107 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+#include "border.h"
+
+/**
+    Kinds of the stages of a pipeline.
+
+    STAGE_INPUT     : the image given to run().
+    STAGE_CONVOLVE  : correlation by a float kernel of odd size (convolve).
+    STAGE_SOBEL     : |dx| + |dy| of Sobel's derivatives (sobelEdges).
+    STAGE_DILATE    : maximum over a structuring element (dilateFilter).
+    STAGE_ERODE     : minimum over a structuring element (erodeFilter).
+    STAGE_THRESHOLD : high where the pixel is > threshold, low elsewhere.
+    STAGE_SUBTRACT  : difference of two stages.
+*/
+enum PipelineStageKind {
+    STAGE_INPUT,
+    STAGE_CONVOLVE,
+    STAGE_SOBEL,
+    STAGE_DILATE,
+    STAGE_ERODE,
+    STAGE_THRESHOLD,
+    STAGE_SUBTRACT
+};
+
+struct PipelineStage {
+    PipelineStageKind kind = STAGE_INPUT;
+    int a = -1, b = -1;           // input stages
+    int ky = 0, kx = 0;           // half size of the window read on a
+    cv::Mat kernel;               // STAGE_CONVOLVE
+    std::vector<cv::Point2i> offsets; // STAGE_DILATE, STAGE_ERODE (x = column)
+    float threshold = 0, low = 0, high = 1;
+};
+
+/**
+    Lazy chain (more generally a DAG) of filters, recorded by the methods
+    below and only computed by run().
+
+    run() cuts the output in tiles sized for the L2 cache. For each tile the
+    region needed from every stage is the region of its consumers grown by
+    their window (the halo), and the stages are computed one after the other
+    on these regions only, in per-thread buffers reused from tile to tile:
+    every intermediate image stays in cache instead of going through memory.
+    A threshold whose input has no other consumer overwrites that input.
+
+    Each stage gives, on the pixels it computes, the same values as the
+    matching whole-image operator with the padding of the pipeline (up to the
+    rounding of the convolution, whose taps may be summed in another order).
+    PAD_WRAP is not supported since it reads pixels far from the tile.
+    Global operators (labeling) run on the result of run(), e.g. for
+    blur -> Sobel -> threshold -> close -> label:
+
+        Pipeline p;
+        Pipeline::Node edges = p.threshold(p.sobel(p.convolve(p.input(), gauss)), 50);
+        labelComponents(p.run(image, p.close(edges, element)), labels);
+*/
+class Pipeline {
+public:
+    typedef int Node;
+
+    explicit Pipeline(PaddingMode padding = PAD_ZERO);
+
+    Node input() const { return 0; }
+
+    Node convolve(Node in, cv::Mat kernel);
+
+    /**
+        Mean over a (2k+1) x (2k+1) window, pixels outside the image counting
+        as zeros with PAD_ZERO (as meanFilter).
+    */
+    Node mean(Node in, int k);
+
+    Node sobel(Node in);
+    Node dilate(Node in, cv::Mat structuringElement);
+    Node erode(Node in, cv::Mat structuringElement);
+    Node open(Node in, cv::Mat structuringElement);
+    Node close(Node in, cv::Mat structuringElement);
+    Node gradient(Node in, cv::Mat structuringElement);
+    Node threshold(Node in, float threshold, float low = 0, float high = 1);
+    Node subtract(Node a, Node b);
+
+    int size() const { return (int) stages.size(); }
+
+    /**
+        Value of output for a float or 8-bit image, as a float image of the
+        same size. Only the stages output depends on are computed.
+    */
+    cv::Mat run(cv::Mat image, Node output) const;
+
+    /**
+        Same as above into dst (which must not be image), reused when it
+        already has the size of image: with the buffers kept by the threads
+        from run to run, processing frames of the same size does not allocate.
+    */
+    void run(const cv::Mat &image, Node output, cv::Mat &dst) const;
+
+private:
+    Node add(const PipelineStage &stage);
+
+    PaddingMode padding;
+    std::vector<PipelineStage> stages;
+};
+
+#endif
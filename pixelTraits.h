@@ -0,0 +1,102 @@
+#ifndef PIXEL_TRAITS_H
+#define PIXEL_TRAITS_H
+
+#include <opencv2/core.hpp>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+/**
+    Compile-time description of the pixel types the engines are instantiated
+    for (8-bit, 16-bit and float single channel images):
+
+    Sum      : type of exact window sums (box filter running sums), integer
+               for integer pixels so that adding and removing rows is exact.
+    depth    : OpenCV depth of the type.
+    lowest() / highest() : value of a morphology window without any sample
+               (the neutral element of the maximum / minimum).
+
+    Weighted sums (convolution, resampling) are always accumulated in float
+    and written back with storePixel, which rounds and saturates to the
+    range of integer types.
+*/
+template<typename T>
+struct PixelTraits;
+
+template<>
+struct PixelTraits<uchar> {
+    typedef int32_t Sum; // 2^23 pixels of 255
+    static const int depth = CV_8U;
+    static uchar lowest() { return 0; }
+    static uchar highest() { return 255; }
+};
+
+template<>
+struct PixelTraits<ushort> {
+    typedef int64_t Sum;
+    static const int depth = CV_16U;
+    static ushort lowest() { return 0; }
+    static ushort highest() { return 65535; }
+};
+
+template<>
+struct PixelTraits<float> {
+    typedef double Sum; // running additions / subtractions do not drift
+    static const int depth = CV_32F;
+    static float lowest() { return -std::numeric_limits<float>::infinity(); }
+    static float highest() { return std::numeric_limits<float>::infinity(); }
+};
+
+/**
+    v written into a pixel of type T: rounded to nearest and saturated for
+    integer types, unchanged for float.
+*/
+template<typename T>
+inline T storePixel(float v)
+{
+    return cv::saturate_cast<T>(v);
+}
+
+template<>
+inline float storePixel<float>(float v)
+{
+    return v;
+}
+
+/**
+    Stores n accumulated values into a row of type T.
+*/
+template<typename T>
+inline void storeRow(const float *acc, T *out, int n)
+{
+    for (int j = 0; j < n; j++)
+        out[j] = storePixel<T>(acc[j]);
+}
+
+/**
+    Calls f(T()) with T the pixel type of depth (CV_8U, CV_16U or CV_32F), so
+    that a generic lambda instantiates the engine for that type:
+
+        dispatchDepth(image.depth(), [&](auto pixel) {
+            filterOf<decltype(pixel)>(image, dst);
+        });
+*/
+template<typename F>
+inline void dispatchDepth(int depth, F f)
+{
+    switch (depth) {
+    case CV_8U:
+        f(uchar());
+        break;
+    case CV_16U:
+        f(ushort());
+        break;
+    case CV_32F:
+        f(float());
+        break;
+    default:
+        assert(false && "unsupported pixel depth");
+    }
+}
+
+#endif
@@ -0,0 +1,241 @@
+#include "pyramid.h"
+#include "convolutionEngine.h"
+#include "simdKernels.h"
+#include "parallel.h"
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+// binomial approximation of a gaussian of variance 1 used by both pyramids
+static const float BINOMIAL[5] = {1 / 16.0f, 4 / 16.0f, 6 / 16.0f, 4 / 16.0f, 1 / 16.0f};
+
+static void binomialFactors(Mat &column, Mat &row) {
+    column = Mat(5, 1, CV_32FC1);
+    row = Mat(1, 5, CV_32FC1);
+    for (int k = 0; k < 5; k++) {
+        column.at<float>(k, 0) = BINOMIAL[k];
+        row.at<float>(0, k) = BINOMIAL[k];
+    }
+}
+
+/**
+    Factors of a normalised gaussian of scale sigma, cut at 3 sigma.
+*/
+static void gaussianFactors(double sigma, Mat &column, Mat &row) {
+    int radius = max(1, (int) ceil(3 * sigma));
+    column = Mat(2 * radius + 1, 1, CV_32FC1);
+    row = Mat(1, 2 * radius + 1, CV_32FC1);
+    double sum = 0;
+    for (int k = -radius; k <= radius; k++)
+        sum += exp(-k * k / (2 * sigma * sigma));
+    for (int k = -radius; k <= radius; k++) {
+        float w = (float) (exp(-k * k / (2 * sigma * sigma)) / sum);
+        column.at<float>(k + radius, 0) = w;
+        row.at<float>(0, k + radius) = w;
+    }
+}
+
+static Mat toFloat(const Mat &image) {
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1);
+    if (image.type() == CV_32FC1)
+        return image;
+    Mat res;
+    image.convertTo(res, CV_32FC1);
+    return res;
+}
+
+static Size halfSize(Size size) {
+    return Size((size.width + 1) / 2, (size.height + 1) / 2);
+}
+
+Mat pyramidDown(Mat image, PaddingMode padding, Mat *scratch)
+{
+    Mat column, row, res;
+    binomialFactors(column, row);
+    convolveSeparable(image, column, row, res, padding, 2, scratch);
+    return res;
+}
+
+/**
+    Output pixel p of the upsampled line reads the source pixels (p - n) / 2
+    for the taps n of the same parity as p.
+*/
+Mat pyramidUp(Mat image, Size size, PaddingMode padding)
+{
+    assert(image.type() == CV_32FC1);
+    assert(halfSize(size) == image.size());
+    Mat tmp(image.rows, size.width, CV_32FC1);
+    parallel_for_1d(image.rows, max(1, (1 << 16) / max(1, size.width)), [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            const float *in = image.ptr<float>(i);
+            float *out = tmp.ptr<float>(i);
+            for (int j = 0; j < size.width; j++) {
+                float sum = 0;
+                for (int n = -2 + (j & 1); n <= 2; n += 2) {
+                    int x = borderIndex((j - n) / 2, image.cols, padding);
+                    if (x >= 0)
+                        sum += 2 * BINOMIAL[n + 2] * in[x];
+                }
+                out[j] = sum;
+            }
+        }
+    });
+
+    Mat res(size, CV_32FC1);
+    parallel_for_1d(size.height, max(1, (1 << 16) / max(1, size.width)), [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            float *out = res.ptr<float>(i);
+            fill(out, out + size.width, 0.0f);
+            for (int m = -2 + (i & 1); m <= 2; m += 2) {
+                int y = borderIndex((i - m) / 2, image.rows, padding);
+                if (y >= 0)
+                    rowAxpy(tmp.ptr<float>(y), 2 * BINOMIAL[m + 2], out, size.width);
+            }
+        }
+    });
+    return res;
+}
+
+/********************************************
+               GAUSSIAN PYRAMID
+*********************************************/
+
+GaussianPyramid::GaussianPyramid(Mat image, int maxLevels, bool lazy, PaddingMode padding)
+    : padding(padding)
+{
+    assert(maxLevels >= 0 && !image.empty());
+    Size size = image.size();
+    while (true) {
+        sizes.push_back(size);
+        if (maxLevels > 0 ? (int) sizes.size() == maxLevels : min(size.width, size.height) < 16)
+            break;
+        size = halfSize(size);
+    }
+    images.resize(sizes.size());
+    built.assign(sizes.size(), false);
+    images[0] = toFloat(image);
+    built[0] = true;
+    if (!lazy)
+        level(levels() - 1);
+}
+
+const Mat &GaussianPyramid::level(int k)
+{
+    assert(k >= 0 && k < levels());
+    if (!built[k]) {
+        images[k] = pyramidDown(level(k - 1), padding, &scratch);
+        built[k] = true;
+    }
+    return images[k];
+}
+
+/********************************************
+               LAPLACIAN PYRAMID
+*********************************************/
+
+vector<Mat> laplacianPyramid(Mat image, int maxLevels, PaddingMode padding)
+{
+    GaussianPyramid gaussian(image, maxLevels, false, padding);
+    int n = gaussian.levels();
+    vector<Mat> res(n);
+    res[n - 1] = gaussian.level(n - 1).clone();
+    for (int k = 0; k < n - 1; k++) {
+        const Mat &fine = gaussian.level(k);
+        Mat up = pyramidUp(gaussian.level(k + 1), fine.size(), padding);
+        for (int i = 0; i < fine.rows; i++) {
+            const float *f = fine.ptr<float>(i);
+            float *u = up.ptr<float>(i);
+            for (int j = 0; j < fine.cols; j++)
+                u[j] = f[j] - u[j];
+        }
+        res[k] = up;
+    }
+    return res;
+}
+
+Mat collapseLaplacian(const vector<Mat> &pyramid, PaddingMode padding)
+{
+    assert(!pyramid.empty());
+    Mat res = pyramid.back().clone();
+    for (int k = (int) pyramid.size() - 2; k >= 0; k--) {
+        const Mat &detail = pyramid[k];
+        res = pyramidUp(res, detail.size(), padding);
+        for (int i = 0; i < detail.rows; i++)
+            rowAxpy(detail.ptr<float>(i), 1.0f, res.ptr<float>(i), detail.cols);
+    }
+    return res;
+}
+
+/********************************************
+                 SCALE SPACE
+*********************************************/
+
+ScaleSpace::ScaleSpace(Mat image, int octaves, int intervals, double sigma0, double inputSigma, bool lazy,
+                       PaddingMode padding)
+    : nOctaves(octaves), intervals(intervals), sigma0(sigma0), inputSigma(inputSigma), padding(padding),
+      input(toFloat(image))
+{
+    assert(octaves >= 1 && intervals >= 1 && sigma0 > 0 && inputSigma >= 0);
+    images.resize((size_t) octaves * levelsPerOctave());
+    built.assign(images.size(), false);
+    if (!lazy) {
+        for (int o = 0; o < nOctaves; o++) {
+            for (int s = 0; s < levelsPerOctave(); s++)
+                build(o, s);
+        }
+    }
+}
+
+double ScaleSpace::sigma(int octave, int s) const
+{
+    return sigma0 * pow(2.0, octave + s / (double) intervals);
+}
+
+const Mat &ScaleSpace::level(int octave, int s)
+{
+    assert(octave >= 0 && octave < nOctaves && s >= 0 && s < levelsPerOctave());
+    build(octave, s);
+    return images[octave * levelsPerOctave() + s];
+}
+
+/**
+    Level (octave, s) from its predecessor, scales being taken in pixels of
+    the octave: sigma0 * 2^(s / intervals).
+*/
+void ScaleSpace::build(int octave, int s)
+{
+    int index = octave * levelsPerOctave() + s;
+    if (built[index])
+        return;
+
+    Mat column, row;
+    Mat &res = images[index];
+    if (octave == 0 && s == 0) {
+        double blur = sqrt(max(0.0, sigma0 * sigma0 - inputSigma * inputSigma));
+        if (blur > 0) {
+            gaussianFactors(blur, column, row);
+            convolveSeparable(input, column, row, res, padding, 1, &scratch);
+        }
+        else {
+            res = input.clone();
+        }
+    }
+    else if (s == 0) {
+        // twice sigma0 at the end of the previous octave: dropping every other
+        // pixel needs no further blur
+        const Mat &previous = level(octave - 1, intervals);
+        column = Mat(1, 1, CV_32FC1, Scalar(1));
+        row = column;
+        convolveSeparable(previous, column, row, res, padding, 2, &scratch);
+    }
+    else {
+        const Mat &previous = level(octave, s - 1);
+        double current = sigma0 * pow(2.0, s / (double) intervals);
+        double before = sigma0 * pow(2.0, (s - 1) / (double) intervals);
+        gaussianFactors(sqrt(current * current - before * before), column, row);
+        convolveSeparable(previous, column, row, res, padding, 1, &scratch);
+    }
+    built[index] = true;
+}
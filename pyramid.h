@@ -0,0 +1,106 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+#include "border.h"
+
+/**
+    Multi-scale representations built on the separable pass of the
+    convolution engine (convolveSeparable): every level is blurred and
+    decimated in a single pass from the level below, so an octave costs about
+    a quarter of the previous one instead of a convolution of the full
+    resolution image by an ever larger kernel.
+
+    Levels are CV_32FC1 images. Inputs are CV_32FC1 or CV_8UC1.
+*/
+
+/**
+    Next level of a Gaussian pyramid: blur by the 5-tap binomial kernel
+    (1 4 6 4 1) / 16 and keep the even rows and columns, the result being
+    ceil(rows / 2) x ceil(cols / 2). scratch holds the intermediate image and
+    can be passed again for the next levels.
+*/
+cv::Mat pyramidDown(cv::Mat image, PaddingMode padding = PAD_REFLECT, cv::Mat *scratch = nullptr);
+
+/**
+    Inverse of pyramidDown on a size x image: zeros are inserted between the
+    pixels of image, which is then blurred by 2 * (1 4 6 4 1) / 16 in each
+    direction. size must be (2 * cols - 1 or 2 * cols, 2 * rows - 1 or 2 * rows).
+*/
+cv::Mat pyramidUp(cv::Mat image, cv::Size size, PaddingMode padding = PAD_REFLECT);
+
+/**
+    Gaussian pyramid whose level 0 is the image and level k + 1 is
+    pyramidDown of level k. The levels are built when constructed, or on the
+    first call to level() when lazy (calls are then not thread safe).
+    maxLevels = 0 stops at the first level whose smaller side is below 16
+    pixels.
+*/
+class GaussianPyramid {
+public:
+    GaussianPyramid(cv::Mat image, int maxLevels = 0, bool lazy = false, PaddingMode padding = PAD_REFLECT);
+
+    int levels() const { return (int) images.size(); }
+
+    cv::Size levelSize(int k) const { return sizes[k]; }
+
+    const cv::Mat &level(int k);
+
+private:
+    std::vector<cv::Mat> images;
+    std::vector<cv::Size> sizes;
+    std::vector<bool> built;
+    cv::Mat scratch;
+    PaddingMode padding;
+};
+
+/**
+    Laplacian pyramid of image: level k is level k of the Gaussian pyramid
+    minus pyramidUp of level k + 1, the last level being the top of the
+    Gaussian pyramid itself (maxLevels as in GaussianPyramid).
+*/
+std::vector<cv::Mat> laplacianPyramid(cv::Mat image, int maxLevels = 0, PaddingMode padding = PAD_REFLECT);
+
+/**
+    Image rebuilt from its Laplacian pyramid (exact up to rounding).
+*/
+cv::Mat collapseLaplacian(const std::vector<cv::Mat> &pyramid, PaddingMode padding = PAD_REFLECT);
+
+/**
+    Continuous scale space in octaves (Lowe's layout): octave o holds
+    intervals + 3 images of scales sigma0 * 2^(o + s / intervals), s in
+    [0, intervals + 2], expressed in pixels of the input image.
+
+    Images of an octave are blurred incrementally from the previous one, the
+    base of the next octave is image s = intervals of this one (twice sigma0)
+    with every other row and column dropped. The input is assumed to be
+    already blurred by inputSigma. Levels are built on demand when lazy
+    (not thread safe).
+*/
+class ScaleSpace {
+public:
+    ScaleSpace(cv::Mat image, int octaves, int intervals = 3, double sigma0 = 1.6, double inputSigma = 0.5,
+               bool lazy = false, PaddingMode padding = PAD_REFLECT);
+
+    int octaves() const { return nOctaves; }
+
+    int levelsPerOctave() const { return intervals + 3; }
+
+    double sigma(int octave, int s) const;
+
+    const cv::Mat &level(int octave, int s);
+
+private:
+    void build(int octave, int s);
+
+    int nOctaves, intervals;
+    double sigma0, inputSigma;
+    PaddingMode padding;
+    cv::Mat input;
+    std::vector<cv::Mat> images; // octave * levelsPerOctave() + s
+    std::vector<bool> built;
+    cv::Mat scratch;
+};
+
+#endif
@@ -0,0 +1,362 @@
+#include "rankFilters.h"
+#include "parallel.h"
+#include "bufferPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+/**
+    Key of a float whose unsigned order is the order of the floats (NaN above
+    +inf or below -inf by its sign), so that the sorted window below only
+    compares and matches integers.
+*/
+static inline uint32_t sortKey(float value) {
+    uint32_t u;
+    memcpy(&u, &value, sizeof(u));
+    return (u & 0x80000000u) ? ~u : u | 0x80000000u;
+}
+
+static inline float keyValue(uint32_t key) {
+    uint32_t u = (key & 0x80000000u) ? key & 0x7fffffffu : ~key;
+    float value;
+    memcpy(&value, &u, sizeof(value));
+    return value;
+}
+
+/**
+    Exact median of the rows [rowBegin, rowEnd) of any float image over a
+    sorted sliding window. Moving one pixel right sorts the leaving and the
+    entering columns (2*size+1 values each) and updates the sorted window in
+    one merge pass, which removes the first and inserts the second: linear
+    work per pixel in the window size, where a selection in each window
+    shuffles the whole window again.
+*/
+static void medianStripSorted(const Mat &image, Mat &res, int size, PaddingMode padding, int rowBegin, int rowEnd) {
+    int rows = image.rows;
+    int cols = image.cols;
+    int width = 2*size+1;
+    ScratchScope scratch;
+    uint32_t *window = scratch.allocate<uint32_t>((size_t) width * width);
+    uint32_t *merged = scratch.allocate<uint32_t>((size_t) width * width);
+    uint32_t *leaving = scratch.allocate<uint32_t>(width);
+    uint32_t *entering = scratch.allocate<uint32_t>(width);
+    const float **windowRows = scratch.allocate<const float *>(width);
+
+    for (int i = rowBegin; i < rowEnd; i++) {
+        int validRows = 0;
+        for (int m = -size; m <= size; m++) {
+            int y = borderIndex(i + m, rows, padding);
+            if (y >= 0)
+                windowRows[validRows++] = image.ptr<float>(y);
+        }
+        // sorted keys of the column x of the window, none when x is missing
+        auto column = [&](int x, uint32_t *keys) {
+            if (x < 0)
+                return 0;
+            for (int t = 0; t < validRows; t++)
+                keys[t] = sortKey(windowRows[t][x]);
+            sort(keys, keys + validRows);
+            return validRows;
+        };
+
+        int n = 0;
+        for (int d = -size; d <= size; d++)
+            n += column(borderIndex(d, cols, padding), window + n);
+        sort(window, window + n);
+
+        float *out = res.ptr<float>(i);
+        for (int j = 0; j < cols; j++) {
+            if (j > 0) {
+                int leavingCount = column(borderIndex(j - size - 1, cols, padding), leaving);
+                int enteringCount = column(borderIndex(j + size, cols, padding), entering);
+                int p = 0, q = 0, r = 0, m = 0;
+                while (p < n) {
+                    if (q < leavingCount && window[p] == leaving[q]) {
+                        p++;
+                        q++;
+                    } else if (r < enteringCount && entering[r] < window[p]) {
+                        merged[m++] = entering[r++];
+                    } else {
+                        merged[m++] = window[p++];
+                    }
+                }
+                while (r < enteringCount)
+                    merged[m++] = entering[r++];
+                swap(window, merged);
+                n = m;
+            }
+            float upper = keyValue(window[n/2]);
+            out[j] = n % 2 == 1 ? upper : (keyValue(window[n/2 - 1]) + upper) / 2;
+        }
+    }
+}
+
+/**
+    Number of samples of the window [p-size, p+size] existing on a line of len pixels.
+*/
+static int validCount(int p, int size, int len, PaddingMode padding) {
+    if (padding != PAD_ZERO)
+        return 2*size+1;
+    return min(p + size, len - 1) - max(p - size, 0) + 1;
+}
+
+/**
+    Median of the n values counted in a histogram of bins bins.
+*/
+template<typename Count>
+static float histogramMedian(const Count *hist, int bins, int n) {
+    int lowRank = (n - 1) / 2;
+    int highRank = n / 2;
+    int cumulated = 0;
+    int low = -1;
+    for (int b = 0; b < bins; b++) {
+        cumulated += hist[b];
+        if (low < 0 && cumulated > lowRank)
+            low = b;
+        if (cumulated > highRank)
+            return ((float) low + (float) b) / 2;
+    }
+    return (float) low;
+}
+
+/**
+    Perreault & Hebert median of the rows [rowBegin, rowEnd) of an 8-bit image.
+
+    colHist holds one 256 bins histogram per column covering the rows of the
+    window, updated by removing one row and adding one row when moving down.
+    The window histogram is updated by removing one column histogram and
+    adding one when moving right: the cost per pixel does not depend on size.
+*/
+static void medianStrip8(const Mat &image, Mat &res, int size, PaddingMode padding, int rowBegin, int rowEnd) {
+    int cols = image.cols;
+    ScratchScope scratch;
+    uint16_t *colHist = scratch.allocate<uint16_t>((size_t) cols * 256);
+    fill(colHist, colHist + (size_t) cols * 256, 0);
+    uint32_t hist[256];
+
+    auto addRow = [&](int y, int delta) {
+        if (y < 0)
+            return;
+        const uchar *in = image.ptr<uchar>(y);
+        for (int x = 0; x < cols; x++) {
+            colHist[(size_t) x * 256 + in[x]] += delta;
+        }
+    };
+    auto addColumn = [&](int x, int delta) {
+        if (x < 0)
+            return;
+        const uint16_t *h = &colHist[(size_t) x * 256];
+        for (int b = 0; b < 256; b++) {
+            hist[b] += delta * h[b];
+        }
+    };
+
+    for (int m = -size; m <= size; m++) {
+        addRow(borderIndex(rowBegin + m, image.rows, padding), 1);
+    }
+
+    for (int i = rowBegin; i < rowEnd; i++) {
+        if (i > rowBegin) {
+            addRow(borderIndex(i - size - 1, image.rows, padding), -1);
+            addRow(borderIndex(i + size, image.rows, padding), 1);
+        }
+        int validRows = validCount(i, size, image.rows, padding);
+        float *out = res.ptr<float>(i);
+
+        fill(hist, hist + 256, 0);
+        for (int n = -size; n <= size; n++) {
+            addColumn(borderIndex(n, cols, padding), 1);
+        }
+        for (int j = 0; j < cols; j++) {
+            if (j > 0) {
+                addColumn(borderIndex(j - size - 1, cols, padding), -1);
+                addColumn(borderIndex(j + size, cols, padding), 1);
+            }
+            out[j] = histogramMedian(hist, 256, validRows * validCount(j, size, cols, padding));
+        }
+    }
+}
+
+/**
+    Huang median of the rows [rowBegin, rowEnd) of a 16-bit image of codes,
+    decode giving the value of a code.
+
+    The window histogram has 65536 fine bins and 256 coarse bins (one per
+    high byte) so that the search only scans 2 * 256 bins. The window moves
+    one pixel at a time along a snake path (left to right, one row down,
+    right to left, ...) removing and adding one column or row of 2*size+1
+    values at each step.
+*/
+template<typename Decode>
+static void medianStripHuang(const Mat &codes, Mat &res, int size, PaddingMode padding,
+                             int rowBegin, int rowEnd, Decode decode) {
+    int rows = codes.rows;
+    int cols = codes.cols;
+    ScratchScope scratch;
+    uint32_t *fine = scratch.allocate<uint32_t>(65536);
+    fill(fine, fine + 65536, 0);
+    uint32_t coarse[256] = {0};
+
+    auto addValue = [&](uint16_t v, int delta) {
+        fine[v] += delta;
+        coarse[v >> 8] += delta;
+    };
+    auto addColumn = [&](int x, int i, int delta) {
+        if (x < 0)
+            return;
+        for (int m = -size; m <= size; m++) {
+            int y = borderIndex(i + m, rows, padding);
+            if (y >= 0)
+                addValue(codes.at<uint16_t>(y, x), delta);
+        }
+    };
+    auto addRow = [&](int y, int j, int delta) {
+        if (y < 0)
+            return;
+        for (int n = -size; n <= size; n++) {
+            int x = borderIndex(j + n, cols, padding);
+            if (x >= 0)
+                addValue(codes.at<uint16_t>(y, x), delta);
+        }
+    };
+    auto valueOfRank = [&](int rank) {
+        int cumulated = 0;
+        for (int c = 0; c < 256; c++) {
+            if (cumulated + (int) coarse[c] <= rank) {
+                cumulated += coarse[c];
+                continue;
+            }
+            for (int f = c * 256; ; f++) {
+                cumulated += fine[f];
+                if (cumulated > rank)
+                    return decode(f);
+            }
+        }
+        return decode(65535);
+    };
+
+    for (int n = -size; n <= size; n++) {
+        addColumn(borderIndex(n, cols, padding), rowBegin, 1);
+    }
+
+    int j = 0;
+    int direction = 1;
+    for (int i = rowBegin; i < rowEnd; i++) {
+        if (i > rowBegin) {
+            addRow(borderIndex(i - size - 1, rows, padding), j, -1);
+            addRow(borderIndex(i + size, rows, padding), j, 1);
+        }
+        int validRows = validCount(i, size, rows, padding);
+        float *out = res.ptr<float>(i);
+
+        for (int step = 0; step < cols; step++) {
+            if (step > 0) {
+                addColumn(borderIndex(j - direction * size, cols, padding), i, -1);
+                j += direction;
+                addColumn(borderIndex(j + direction * size, cols, padding), i, 1);
+            }
+            int n = validRows * validCount(j, size, cols, padding);
+            float low = valueOfRank((n - 1) / 2);
+            out[j] = n % 2 == 1 ? low : (low + valueOfRank(n / 2)) / 2;
+        }
+        direction = -direction;
+    }
+}
+
+/**
+    Run strip(rowBegin, rowEnd) on horizontal strips of the image, in parallel.
+    Each strip rebuilds its histograms from scratch.
+*/
+static void forEachStrip(const Mat &image, int size, FunctionRef<void(int, int)> strip) {
+    int stripRows = max(64, 4 * (2*size+1));
+    parallel_for_2d(image.rows, image.cols, Size(image.cols, stripRows), [&](const Rect &tile) {
+        strip(tile.y, tile.y + tile.height);
+    });
+}
+
+/**
+    True when every value of the float image is an integer of [0, maxValue].
+*/
+static bool integerValued(const Mat &image, float maxValue) {
+    for (int i = 0; i < image.rows; i++) {
+        const float *in = image.ptr<float>(i);
+        for (int j = 0; j < image.cols; j++) {
+            if (!(in[j] >= 0 && in[j] <= maxValue && in[j] == (float) (int) in[j]))
+                return false;
+        }
+    }
+    return true;
+}
+
+void medianFilter(const Mat &input, int size, Mat &res, PaddingMode padding, MedianMode mode)
+{
+    assert(size >= 0 && size < 32767);
+    assert(input.type() == CV_32FC1 || input.type() == CV_8UC1 || input.type() == CV_16UC1);
+    assert(res.data == nullptr || res.data != input.data);
+    ensureImage(res, input.rows, input.cols, CV_32FC1);
+    if (input.rows == 0 || input.cols == 0)
+        return;
+
+    // integer images converted from float are kept by the thread for the next calls
+    thread_local Mat converted8, converted16;
+    Mat image = input;
+
+    if (image.type() == CV_32FC1) {
+        if (mode == MEDIAN_QUANTIZED) {
+            float minVal = image.at<float>(0, 0), maxVal = minVal;
+            for (int i = 0; i < image.rows; i++) {
+                for (int j = 0; j < image.cols; j++) {
+                    minVal = min(minVal, image.at<float>(i, j));
+                    maxVal = max(maxVal, image.at<float>(i, j));
+                }
+            }
+            double scale = maxVal > minVal ? (maxVal - minVal) / 65535.0 : 1.0;
+            ensureImage(converted16, image.rows, image.cols, CV_16UC1);
+            image.convertTo(converted16, CV_16UC1, 1.0 / scale, -minVal / scale);
+            const Mat &codes = converted16;
+            forEachStrip(image, size, [&](int rowBegin, int rowEnd) {
+                medianStripHuang(codes, res, size, padding, rowBegin, rowEnd, [&](int code) {
+                    return (float) (minVal + code * scale);
+                });
+            });
+            return;
+        }
+        // exact on integer valued images: the histogram algorithms give the same values
+        if (integerValued(image, 255)) {
+            ensureImage(converted8, image.rows, image.cols, CV_8UC1);
+            image.convertTo(converted8, CV_8UC1);
+            image = converted8;
+        } else if (integerValued(image, 65535)) {
+            ensureImage(converted16, image.rows, image.cols, CV_16UC1);
+            image.convertTo(converted16, CV_16UC1);
+            image = converted16;
+        } else {
+            forEachStrip(image, size, [&](int rowBegin, int rowEnd) {
+                medianStripSorted(image, res, size, padding, rowBegin, rowEnd);
+            });
+            return;
+        }
+    }
+
+    if (image.type() == CV_8UC1) {
+        forEachStrip(image, size, [&](int rowBegin, int rowEnd) {
+            medianStrip8(image, res, size, padding, rowBegin, rowEnd);
+        });
+    } else {
+        forEachStrip(image, size, [&](int rowBegin, int rowEnd) {
+            medianStripHuang(image, res, size, padding, rowBegin, rowEnd, [](int code) {
+                return (float) code;
+            });
+        });
+    }
+}
+
+Mat medianFilter(Mat image, int size, PaddingMode padding, MedianMode mode)
+{
+    Mat res;
+    medianFilter(image, size, res, padding, mode);
+    return res;
+}
@@ -0,0 +1,46 @@
+#ifndef RANK_FILTERS_H
+#define RANK_FILTERS_H
+
+#include <opencv2/core.hpp>
+#include "border.h"
+
+/**
+    Algorithm used by the median filter on float images.
+
+    MEDIAN_EXACT     : exact median. Float images holding only integer values
+                       of [0, 65535] (eg. converted 8 or 16-bit frames) go
+                       through the histogram algorithms below, other ones
+                       through a sorted sliding window (O(size^2) per pixel,
+                       sequential merges instead of a selection per window).
+    MEDIAN_QUANTIZED : values are quantised on 65536 levels between the
+                       minimum and the maximum of the image and filtered with
+                       a sliding histogram. Error is below half a level,
+                       (max - min) / 131070.
+*/
+enum MedianMode {
+    MEDIAN_EXACT,
+    MEDIAN_QUANTIZED
+};
+
+/**
+    Median filter of a float, 8-bit or 16-bit image over a square window of
+    (2*size+1)*(2*size+1) pixels. Result is a float image.
+    Samples missing under the padding mode (outside of the image with PAD_ZERO) are
+    ignored, the median of an even number of values is the mean of the two middle ones.
+
+    8-bit images use the constant time algorithm of Perreault & Hebert (one
+    histogram per column, updated by one row at each step), 16-bit images
+    the sliding histogram of Huang with two levels of bins (O(size) per pixel).
+*/
+cv::Mat medianFilter(cv::Mat image, int size, PaddingMode padding = PAD_ZERO,
+                     MedianMode mode = MEDIAN_EXACT);
+
+/**
+    Same as above into dst (which must not be image), reused when it already
+    has the size of image: with the per-thread scratch memory, repeated calls
+    on images of the same size do not allocate.
+*/
+void medianFilter(const cv::Mat &image, int size, cv::Mat &dst, PaddingMode padding = PAD_ZERO,
+                  MedianMode mode = MEDIAN_EXACT);
+
+#endif
@@ -0,0 +1,234 @@
+#include "resize.h"
+#include "simdKernels.h"
+#include "parallel.h"
+#include "pixelTraits.h"
+#include <cmath>
+#include <algorithm>
+#include <mutex>
+#include <type_traits>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+/**
+    Kernels of the interpolating filters, with their radius.
+*/
+static double triangleKernel(double x) {
+    x = fabs(x);
+    return x < 1 ? 1 - x : 0;
+}
+
+static double cubicKernel(double x) {
+    const double a = -0.5;
+    x = fabs(x);
+    if (x < 1) return ((a + 2) * x - (a + 3)) * x * x + 1;
+    if (x < 2) return ((a * x - 5 * a) * x + 8 * a) * x - 4 * a;
+    return 0;
+}
+
+static double lanczos3Kernel(double x) {
+    if (x == 0) return 1;
+    if (x <= -3 || x >= 3) return 0;
+    double px = M_PI * x;
+    return 3 * sin(px) * sin(px / 3) / (px * px);
+}
+
+/**
+    Coefficients of output pixels 0..dstLen-1, output pixel k being centred on
+    the source coordinate k * scale + offset.
+*/
+static ResizeAxis buildAxis(int srcLen, int dstLen, ResizeFilter filter, double scale,
+                            double offset) {
+    ResizeAxis axis;
+    vector<vector<double>> windows(dstLen);
+    axis.first.resize(dstLen);
+    axis.count.resize(dstLen);
+
+    // kernels are stretched when downscaling so that every source pixel counts
+    double stretch = max(1.0, scale);
+    double (*kernel)(double) = nullptr;
+    double radius = 0;
+    switch (filter) {
+    case RESIZE_NEAREST:
+    case RESIZE_AREA:
+        break;
+    case RESIZE_BILINEAR:
+        kernel = triangleKernel;
+        radius = 1;
+        break;
+    case RESIZE_BICUBIC:
+        kernel = cubicKernel;
+        radius = 2;
+        break;
+    case RESIZE_LANCZOS3:
+        kernel = lanczos3Kernel;
+        radius = 3;
+        break;
+    default:
+        assert(false && "resize: unknown filter");
+    }
+
+    for (int k = 0; k < dstLen; k++) {
+        double centre = k * scale + offset;
+        int first, last;
+        vector<double> &w = windows[k];
+        if (filter == RESIZE_NEAREST) {
+            first = last = min(max((int) floor(centre + 0.5), 0), srcLen - 1);
+            w.assign(1, 1.0);
+        }
+        else if (filter == RESIZE_AREA) {
+            // overlap of [j - 0.5, j + 0.5] with the footprint of the output pixel
+            double lo = centre - stretch / 2;
+            double hi = centre + stretch / 2;
+            first = max((int) floor(lo + 0.5), 0);
+            last = min((int) ceil(hi - 0.5), srcLen - 1);
+            for (int j = first; j <= last; j++)
+                w.push_back(max(0.0, min(hi, j + 0.5) - max(lo, j - 0.5)));
+        }
+        else {
+            double support = radius * stretch;
+            first = max((int) ceil(centre - support), 0);
+            last = min((int) floor(centre + support), srcLen - 1);
+            for (int j = first; j <= last; j++)
+                w.push_back(kernel((j - centre) / stretch));
+        }
+
+        // zero weights at both ends are dropped, the others normalised
+        int begin = 0, end = (int) w.size();
+        while (begin < end && w[begin] == 0) begin++;
+        while (end > begin && w[end - 1] == 0) end--;
+        double sum = 0;
+        for (int t = begin; t < end; t++)
+            sum += w[t];
+        if (sum == 0) {
+            // window entirely outside of the source: nearest pixel
+            first = min(max((int) floor(centre + 0.5), 0), srcLen - 1);
+            w.assign(1, 1.0);
+            begin = 0;
+            end = 1;
+            sum = 1;
+        }
+        w = vector<double>(w.begin() + begin, w.begin() + end);
+        for (double &v : w)
+            v /= sum;
+        axis.first[k] = first + begin;
+        axis.count[k] = (int) w.size();
+        axis.taps = max(axis.taps, axis.count[k]);
+    }
+
+    axis.weights.assign((size_t) dstLen * axis.taps, 0.0f);
+    for (int k = 0; k < dstLen; k++) {
+        for (int t = 0; t < axis.count[k]; t++)
+            axis.weights[(size_t) k * axis.taps + t] = (float) windows[k][t];
+    }
+    return axis;
+}
+
+static ResizePlan buildPlan(Size src, Size dst, ResizeFilter filter, double scaleX, double offsetX,
+                            double scaleY, double offsetY) {
+    assert(src.width > 0 && src.height > 0 && dst.width >= 0 && dst.height >= 0);
+    ResizePlan plan;
+    plan.src = src;
+    plan.dst = dst;
+    plan.filter = filter;
+    plan.horizontal = buildAxis(src.width, dst.width, filter, scaleX, offsetX);
+    plan.vertical = buildAxis(src.height, dst.height, filter, scaleY, offsetY);
+    return plan;
+}
+
+shared_ptr<const ResizePlan> resizePlan(Size src, Size dst, ResizeFilter filter)
+{
+    static mutex cacheMutex;
+    static vector<shared_ptr<const ResizePlan>> cache; // most recently used first
+    const size_t cacheSize = 16;
+
+    assert(dst.width > 0 && dst.height > 0);
+    lock_guard<mutex> lock(cacheMutex);
+    for (size_t p = 0; p < cache.size(); p++) {
+        const ResizePlan &plan = *cache[p];
+        if (plan.src == src && plan.dst == dst && plan.filter == filter) {
+            std::rotate(cache.begin(), cache.begin() + p, cache.begin() + p + 1);
+            return cache[0];
+        }
+    }
+    double scaleX = src.width / (double) dst.width;
+    double scaleY = src.height / (double) dst.height;
+    auto plan = make_shared<const ResizePlan>(buildPlan(src, dst, filter, scaleX, 0.5 * scaleX - 0.5,
+                                                        scaleY, 0.5 * scaleY - 0.5));
+    cache.insert(cache.begin(), plan);
+    if (cache.size() > cacheSize)
+        cache.pop_back();
+    return plan;
+}
+
+ResizePlan expandPlan(Size src, int factor, ResizeFilter filter)
+{
+    assert(factor > 0);
+    Size dst((src.width - 1) * factor, (src.height - 1) * factor);
+    return buildPlan(src, dst, filter, 1.0 / factor, 0, 1.0 / factor, 0);
+}
+
+/**
+    Rows of the horizontal pass handled by one task: about 64K output pixels.
+*/
+static int rowGrain(int cols) {
+    return max(1, (1 << 16) / max(1, cols));
+}
+
+template<typename T>
+static void horizontalPass(const Mat &image, Mat &tmp, const ResizeAxis &axis) {
+    parallel_for_1d(image.rows, rowGrain(tmp.cols), [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            const T *in = image.ptr<T>(i);
+            float *out = tmp.ptr<float>(i);
+            for (int k = 0; k < tmp.cols; k++) {
+                const float *w = &axis.weights[(size_t) k * axis.taps];
+                const T *p = in + axis.first[k];
+                float sum = 0;
+                for (int t = 0; t < axis.count[k]; t++)
+                    sum += w[t] * (float) p[t];
+                out[k] = sum;
+            }
+        }
+    });
+}
+
+/**
+    Each output row is a weighted sum of rows of tmp, accumulated with rowAxpy
+    and stored into the pixel type T of res.
+*/
+template<typename T>
+static void verticalPass(const Mat &tmp, Mat &res, const ResizeAxis &axis) {
+    parallel_for_1d(res.rows, rowGrain(res.cols), [&](int begin, int end) {
+        bool direct = is_same<T, float>::value;
+        vector<float> row(direct ? 0 : res.cols);
+        for (int i = begin; i < end; i++) {
+            float *acc = direct ? res.ptr<float>(i) : row.data();
+            fill(acc, acc + res.cols, 0.0f);
+            const float *w = &axis.weights[(size_t) i * axis.taps];
+            for (int t = 0; t < axis.count[i]; t++)
+                rowAxpy(tmp.ptr<float>(axis.first[i] + t), w[t], acc, res.cols);
+            if (!direct)
+                storeRow(acc, res.ptr<T>(i), res.cols);
+        }
+    });
+}
+
+Mat resize(Mat image, const ResizePlan &plan)
+{
+    assert(image.type() == CV_8UC1 || image.type() == CV_16UC1 || image.type() == CV_32FC1);
+    assert(image.cols == plan.src.width && image.rows == plan.src.height);
+    Mat tmp(image.rows, plan.dst.width, CV_32FC1);
+    Mat res(plan.dst, image.type());
+    dispatchDepth(image.depth(), [&](auto pixel) {
+        typedef decltype(pixel) T;
+        horizontalPass<T>(image, tmp, plan.horizontal);
+        verticalPass<T>(tmp, res, plan.vertical);
+    });
+    return res;
+}
+
+Mat resize(Mat image, Size size, ResizeFilter filter)
+{
+    return resize(image, *resizePlan(image.size(), size, filter));
+}
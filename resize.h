@@ -0,0 +1,78 @@
+#ifndef RESIZE_H
+#define RESIZE_H
+
+#include <opencv2/core.hpp>
+#include <memory>
+#include <vector>
+
+/**
+    Resampling filter of resize.
+
+    RESIZE_NEAREST  : closest source pixel.
+    RESIZE_AREA     : mean of the source pixels weighted by their overlap with
+                      the footprint of the output pixel (exact area averaging
+                      when downscaling, linear when upscaling).
+    RESIZE_BILINEAR : triangle kernel of radius 1.
+    RESIZE_BICUBIC  : Keys cubic kernel (a = -0.5) of radius 2.
+    RESIZE_LANCZOS3 : windowed sinc of radius 3.
+
+    When downscaling by a factor s, the bilinear, bicubic and Lanczos kernels
+    are stretched by s so that every source pixel contributes (antialiasing).
+*/
+enum ResizeFilter {
+    RESIZE_NEAREST,
+    RESIZE_AREA,
+    RESIZE_BILINEAR,
+    RESIZE_BICUBIC,
+    RESIZE_LANCZOS3
+};
+
+/**
+    Coefficients of a 1D resampling: output pixel k is the sum for t in
+    [0, count[k]) of weights[k * taps + t] * source[first[k] + t]. Windows are
+    cut to the source and their weights normalised to sum to 1.
+*/
+struct ResizeAxis {
+    int taps = 0;
+    std::vector<int> first;
+    std::vector<int> count;
+    std::vector<float> weights;
+};
+
+/**
+    Horizontal and vertical coefficients of a resize from src to dst.
+*/
+struct ResizePlan {
+    cv::Size src, dst;
+    ResizeFilter filter;
+    ResizeAxis horizontal, vertical;
+};
+
+/**
+    Plan of a resize from src to dst, the pixel centres of both images being
+    aligned (source x = (x + 0.5) * src.width / dst.width - 0.5).
+    Plans are kept in a small cache keyed by (src, dst, filter), so repeated
+    resizes between the same sizes build their tables once.
+*/
+std::shared_ptr<const ResizePlan> resizePlan(cv::Size src, cv::Size dst, ResizeFilter filter);
+
+/**
+    Plan of expand (tpGeometry): output pixel x reads source x / factor and
+    the output size is ((rows-1) * factor, (cols-1) * factor).
+*/
+ResizePlan expandPlan(cv::Size src, int factor, ResizeFilter filter);
+
+/**
+    Applies plan to image (CV_8UC1, CV_16UC1 or CV_32FC1 of size plan.src)
+    with a horizontal then a vertical pass, both spread over the thread pool.
+    The result has the type of image, integer results being rounded and
+    saturated.
+*/
+cv::Mat resize(cv::Mat image, const ResizePlan &plan);
+
+/**
+    Resize of image to size through the cached plan.
+*/
+cv::Mat resize(cv::Mat image, cv::Size size, ResizeFilter filter = RESIZE_BILINEAR);
+
+#endif
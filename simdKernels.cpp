@@ -0,0 +1,259 @@
+#include "simdKernels.h"
+#include <atomic>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_X86 0
+#endif
+
+typedef unsigned char uchar;
+typedef unsigned short ushort;
+
+/********************************************
+            PORTABLE SCALAR KERNELS
+*********************************************/
+
+template<typename T>
+static void rowTapsScalar(const T *in, const float *k, int kx, float *out, int j0, int j1) {
+    for (int j = j0; j < j1; j++) {
+        float sum_px = 0.0;
+        for (int n = -kx; n <= kx; n++) {
+            sum_px += (float) in[j + n] * k[n];
+        }
+        out[j] += sum_px;
+    }
+}
+
+static void rowAxpyScalar(const float *in, float c, float *out, int j0, int j1) {
+    for (int j = j0; j < j1; j++) {
+        out[j] += c * in[j];
+    }
+}
+
+template<typename T>
+static void sobelRowScalar(const T *r0, const T *r1, const T *r2, float *out, int j0, int j1) {
+    for (int j = j0; j < j1; j++) {
+        float dfdx = ((float) r0[j+1] - (float) r0[j-1]) + 2.0f * ((float) r1[j+1] - (float) r1[j-1])
+                   + ((float) r2[j+1] - (float) r2[j-1]);
+        float dfdy = ((float) r0[j-1] + 2.0f * (float) r0[j] + (float) r0[j+1])
+                   - ((float) r2[j-1] + 2.0f * (float) r2[j] + (float) r2[j+1]);
+        out[j] = std::fabs(dfdx) + std::fabs(dfdy);
+    }
+}
+
+#if SIMD_X86
+
+/********************************************
+                SSE4.1 KERNELS
+*********************************************/
+
+TARGET_SSE41 static inline __m128 load4(const float *p) {
+    return _mm_loadu_ps(p);
+}
+
+TARGET_SSE41 static inline __m128 load4(const uchar *p) {
+    int word;
+    __builtin_memcpy(&word, p, 4);
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(word)));
+}
+
+TARGET_SSE41 static inline __m128 load4(const ushort *p) {
+    return _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) p)));
+}
+
+template<typename T>
+TARGET_SSE41 static void rowTapsSse41(const T *in, const float *k, int kx, float *out, int j0, int j1) {
+    int j = j0;
+    for (; j + 4 <= j1; j += 4) {
+        __m128 acc = _mm_setzero_ps();
+        for (int n = -kx; n <= kx; n++) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(load4(in + j + n), _mm_set1_ps(k[n])));
+        }
+        _mm_storeu_ps(out + j, _mm_add_ps(_mm_loadu_ps(out + j), acc));
+    }
+    rowTapsScalar(in, k, kx, out, j, j1);
+}
+
+TARGET_SSE41 static void rowAxpySse41(const float *in, float c, float *out, int n) {
+    __m128 vc = _mm_set1_ps(c);
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        _mm_storeu_ps(out + j, _mm_add_ps(_mm_loadu_ps(out + j), _mm_mul_ps(vc, _mm_loadu_ps(in + j))));
+    }
+    rowAxpyScalar(in, c, out, j, n);
+}
+
+template<typename T>
+TARGET_SSE41 static void sobelRowSse41(const T *r0, const T *r1, const T *r2, float *out, int j0, int j1) {
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    int j = j0;
+    for (; j + 4 <= j1; j += 4) {
+        __m128 a0 = load4(r0 + j - 1), b0 = load4(r0 + j), c0 = load4(r0 + j + 1);
+        __m128 a1 = load4(r1 + j - 1), c1 = load4(r1 + j + 1);
+        __m128 a2 = load4(r2 + j - 1), b2 = load4(r2 + j), c2 = load4(r2 + j + 1);
+        __m128 dfdx = _mm_add_ps(_mm_add_ps(_mm_sub_ps(c0, a0), _mm_mul_ps(two, _mm_sub_ps(c1, a1))), _mm_sub_ps(c2, a2));
+        __m128 dfdy = _mm_sub_ps(_mm_add_ps(_mm_add_ps(a0, _mm_mul_ps(two, b0)), c0),
+                                 _mm_add_ps(_mm_add_ps(a2, _mm_mul_ps(two, b2)), c2));
+        _mm_storeu_ps(out + j, _mm_add_ps(_mm_andnot_ps(signMask, dfdx), _mm_andnot_ps(signMask, dfdy)));
+    }
+    sobelRowScalar(r0, r1, r2, out, j, j1);
+}
+
+/********************************************
+                 AVX2 KERNELS
+*********************************************/
+
+TARGET_AVX2 static inline __m256 load8(const float *p) {
+    return _mm256_loadu_ps(p);
+}
+
+TARGET_AVX2 static inline __m256 load8(const uchar *p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) p)));
+}
+
+TARGET_AVX2 static inline __m256 load8(const ushort *p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) p)));
+}
+
+template<typename T>
+TARGET_AVX2 static void rowTapsAvx2(const T *in, const float *k, int kx, float *out, int j0, int j1) {
+    int j = j0;
+    for (; j + 8 <= j1; j += 8) {
+        __m256 acc = _mm256_setzero_ps();
+        for (int n = -kx; n <= kx; n++) {
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(load8(in + j + n), _mm256_set1_ps(k[n])));
+        }
+        _mm256_storeu_ps(out + j, _mm256_add_ps(_mm256_loadu_ps(out + j), acc));
+    }
+    rowTapsScalar(in, k, kx, out, j, j1);
+}
+
+TARGET_AVX2 static void rowAxpyAvx2(const float *in, float c, float *out, int n) {
+    __m256 vc = _mm256_set1_ps(c);
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        _mm256_storeu_ps(out + j, _mm256_add_ps(_mm256_loadu_ps(out + j), _mm256_mul_ps(vc, _mm256_loadu_ps(in + j))));
+    }
+    rowAxpyScalar(in, c, out, j, n);
+}
+
+template<typename T>
+TARGET_AVX2 static void sobelRowAvx2(const T *r0, const T *r1, const T *r2, float *out, int j0, int j1) {
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    int j = j0;
+    for (; j + 8 <= j1; j += 8) {
+        __m256 a0 = load8(r0 + j - 1), b0 = load8(r0 + j), c0 = load8(r0 + j + 1);
+        __m256 a1 = load8(r1 + j - 1), c1 = load8(r1 + j + 1);
+        __m256 a2 = load8(r2 + j - 1), b2 = load8(r2 + j), c2 = load8(r2 + j + 1);
+        __m256 dfdx = _mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(c0, a0), _mm256_mul_ps(two, _mm256_sub_ps(c1, a1))), _mm256_sub_ps(c2, a2));
+        __m256 dfdy = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(a0, _mm256_mul_ps(two, b0)), c0),
+                                    _mm256_add_ps(_mm256_add_ps(a2, _mm256_mul_ps(two, b2)), c2));
+        _mm256_storeu_ps(out + j, _mm256_add_ps(_mm256_andnot_ps(signMask, dfdx), _mm256_andnot_ps(signMask, dfdy)));
+    }
+    sobelRowScalar(r0, r1, r2, out, j, j1);
+}
+
+#endif
+
+/********************************************
+                  DISPATCH
+*********************************************/
+
+SimdLevel detectSimdLevel()
+{
+#if SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return SIMD_SSE41;
+#endif
+    return SIMD_SCALAR;
+}
+
+// read by the pool workers while another thread may call setSimdLevel
+static std::atomic<SimdLevel> currentLevel{detectSimdLevel()};
+
+SimdLevel simdLevel()
+{
+    return currentLevel.load(std::memory_order_relaxed);
+}
+
+void setSimdLevel(SimdLevel level)
+{
+    SimdLevel detected = detectSimdLevel();
+    currentLevel.store(level < detected ? level : detected, std::memory_order_relaxed);
+}
+
+template<typename T>
+static void rowTapsDispatch(const T *in, const float *k, int kx, float *out, int j0, int j1) {
+#if SIMD_X86
+    SimdLevel level = simdLevel();
+    if (level == SIMD_AVX2)
+        return rowTapsAvx2(in, k, kx, out, j0, j1);
+    if (level == SIMD_SSE41)
+        return rowTapsSse41(in, k, kx, out, j0, j1);
+#endif
+    rowTapsScalar(in, k, kx, out, j0, j1);
+}
+
+template<typename T>
+static void sobelRowDispatch(const T *r0, const T *r1, const T *r2, float *out, int j0, int j1) {
+#if SIMD_X86
+    SimdLevel level = simdLevel();
+    if (level == SIMD_AVX2)
+        return sobelRowAvx2(r0, r1, r2, out, j0, j1);
+    if (level == SIMD_SSE41)
+        return sobelRowSse41(r0, r1, r2, out, j0, j1);
+#endif
+    sobelRowScalar(r0, r1, r2, out, j0, j1);
+}
+
+void rowTaps(const float *in, const float *k, int kx, float *out, int j0, int j1)
+{
+    rowTapsDispatch(in, k, kx, out, j0, j1);
+}
+
+void rowTaps(const uchar *in, const float *k, int kx, float *out, int j0, int j1)
+{
+    rowTapsDispatch(in, k, kx, out, j0, j1);
+}
+
+void rowTaps(const ushort *in, const float *k, int kx, float *out, int j0, int j1)
+{
+    rowTapsDispatch(in, k, kx, out, j0, j1);
+}
+
+void rowAxpy(const float *in, float c, float *out, int n)
+{
+#if SIMD_X86
+    SimdLevel level = simdLevel();
+    if (level == SIMD_AVX2)
+        return rowAxpyAvx2(in, c, out, n);
+    if (level == SIMD_SSE41)
+        return rowAxpySse41(in, c, out, n);
+#endif
+    rowAxpyScalar(in, c, out, 0, n);
+}
+
+void sobelRow(const float *r0, const float *r1, const float *r2, float *out, int j0, int j1)
+{
+    sobelRowDispatch(r0, r1, r2, out, j0, j1);
+}
+
+void sobelRow(const uchar *r0, const uchar *r1, const uchar *r2, float *out, int j0, int j1)
+{
+    sobelRowDispatch(r0, r1, r2, out, j0, j1);
+}
+
+void sobelRow(const ushort *r0, const ushort *r1, const ushort *r2, float *out, int j0, int j1)
+{
+    sobelRowDispatch(r0, r1, r2, out, j0, j1);
+}
@@ -0,0 +1,60 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+/**
+    Vectorised row kernels used by the interior loops of the filters.
+
+    Every kernel has an AVX2 (8 pixels per instruction), an SSE4.1 (4 pixels)
+    and a portable scalar version. The version is selected once at run time
+    from CPUID. All versions perform the same operations in the same order, so
+    their results are bit identical.
+*/
+
+enum SimdLevel {
+    SIMD_SCALAR,
+    SIMD_SSE41,
+    SIMD_AVX2
+};
+
+/**
+    Best instruction set supported by the processor.
+*/
+SimdLevel detectSimdLevel();
+
+/**
+    Instruction set currently used by the kernels.
+*/
+SimdLevel simdLevel();
+
+/**
+    Restrict the kernels to the given instruction set (mainly for tests and
+    benchmarks). Levels above detectSimdLevel() are ignored. Safe to call
+    while other threads run kernels, which pick up the new level on their
+    next dispatch.
+*/
+void setSimdLevel(SimdLevel level);
+
+/**
+    out[j] += sum of in[j+n] * k[n] for n in [-kx, kx], for j in [j0, j1).
+    in must be readable on [j0-kx, j1+kx) and k on [-kx, kx].
+*/
+void rowTaps(const float *in, const float *k, int kx, float *out, int j0, int j1);
+void rowTaps(const unsigned char *in, const float *k, int kx, float *out, int j0, int j1);
+void rowTaps(const unsigned short *in, const float *k, int kx, float *out, int j0, int j1);
+
+/**
+    out[j] += c * in[j] for j in [0, n).
+*/
+void rowAxpy(const float *in, float c, float *out, int n);
+
+/**
+    Sobel |dx| + |dy| of the pixels [j0, j1) of the row r1, r0 and r2 being
+    the rows above and below. Columns j0-1 and j1 must be readable.
+*/
+void sobelRow(const float *r0, const float *r1, const float *r2, float *out, int j0, int j1);
+void sobelRow(const unsigned char *r0, const unsigned char *r1, const unsigned char *r2,
+              float *out, int j0, int j1);
+void sobelRow(const unsigned short *r0, const unsigned short *r1, const unsigned short *r2,
+              float *out, int j0, int j1);
+
+#endif
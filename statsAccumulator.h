@@ -0,0 +1,51 @@
+#ifndef STATS_ACCUMULATOR_H
+#define STATS_ACCUMULATOR_H
+
+#include "labeling.h"
+#include <algorithm>
+#include <climits>
+
+/**
+    Running sums of a component while it is labeled: area, 4 adjacent pixel
+    pairs, bounding box and coordinate sums.
+*/
+struct StatsAccumulator {
+    int64_t area = 0;
+    int64_t pairs = 0;
+    int left = INT_MAX, top = INT_MAX, right = INT_MIN, bottom = INT_MIN;
+    double sumX = 0, sumY = 0;
+
+    void addSpan(int y, int x0, int x1) {
+        int n = x1 - x0 + 1;
+        area += n;
+        left = std::min(left, x0);
+        right = std::max(right, x1);
+        top = std::min(top, y);
+        bottom = std::max(bottom, y);
+        sumX += 0.5 * (x0 + x1) * n;
+        sumY += (double) y * n;
+    }
+
+    void merge(const StatsAccumulator &other) {
+        area += other.area;
+        pairs += other.pairs;
+        left = std::min(left, other.left);
+        right = std::max(right, other.right);
+        top = std::min(top, other.top);
+        bottom = std::max(bottom, other.bottom);
+        sumX += other.sumX;
+        sumY += other.sumY;
+    }
+
+    ComponentStats stats() const {
+        ComponentStats res;
+        if (area == 0) return res;
+        res.area = area;
+        res.boundingBox = cv::Rect(left, top, right - left + 1, bottom - top + 1);
+        res.centroid = cv::Point2d(sumX / area, sumY / area);
+        res.perimeter = 4 * area - 2 * pairs;
+        return res;
+    }
+};
+
+#endif
@@ -0,0 +1,285 @@
+#include "streamLabeling.h"
+#include "unionFind.h"
+#include "statsAccumulator.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <cassert>
+#include <sys/types.h>
+using namespace cv;
+using namespace std;
+
+StripSource matStripSource(Mat image, int stripRows)
+{
+    assert(stripRows > 0);
+    int row = 0;
+    return [image, stripRows, row](Mat &strip) mutable {
+        if (row >= image.rows) return false;
+        int n = min(stripRows, image.rows - row);
+        strip = image.rowRange(row, row + n);
+        row += n;
+        return true;
+    };
+}
+
+StripSource rawStripSource(const string &path, int cols, int stripRows)
+{
+    assert(cols > 0 && stripRows > 0);
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == nullptr)
+        return StripSource();
+    shared_ptr<FILE> file(f, fclose);
+    // a partial last row would otherwise be dropped without notice
+    if (fseeko(f, 0, SEEK_END) != 0)
+        return StripSource();
+    off_t length = ftello(f);
+    if (length < 0 || length % cols != 0 || fseeko(f, 0, SEEK_SET) != 0)
+        return StripSource();
+    return [file, cols, stripRows](Mat &strip) {
+        strip.create(stripRows, cols, CV_8UC1);
+        size_t n = fread(strip.data, cols, stripRows, file.get());
+        if (n == 0) return false;
+        strip = strip.rowRange(0, (int) n);
+        return true;
+    };
+}
+
+/**
+    Presence of the pixels of row i of the strip.
+*/
+template<typename T>
+static void maskRowOf(const Mat &strip, int i, vector<uchar> &mask) {
+    const T *in = strip.ptr<T>(i);
+    for (int j = 0; j < (int) mask.size(); j++)
+        mask[j] = in[j] != 0;
+}
+
+static void maskRow(const Mat &strip, int i, vector<uchar> &mask) {
+    switch (strip.depth()) {
+    case CV_8U:
+        maskRowOf<uchar>(strip, i, mask);
+        break;
+    case CV_32S:
+        maskRowOf<int>(strip, i, mask);
+        break;
+    case CV_32F:
+        maskRowOf<float>(strip, i, mask);
+        break;
+    default:
+        assert(false && "labelComponentsStreaming: unsupported strip depth");
+    }
+}
+
+/**
+    Union-find forest of the streaming labeler. Each root carries the
+    statistics of its component and the last row in which it has pixels;
+    the elements which are not roots of the current row are recycled.
+*/
+struct StreamForest {
+    UnionFind forest;
+    vector<StatsAccumulator> acc = vector<StatsAccumulator>(1); // 0 is the background
+    vector<int> lastRow = vector<int>(1, -1);
+    vector<int> used;
+    vector<int> unused;
+
+    int newLabel() {
+        int x;
+        if (!unused.empty()) {
+            x = unused.back();
+            unused.pop_back();
+        }
+        else {
+            x = forest.makeSet();
+            acc.emplace_back();
+            lastRow.push_back(-1);
+        }
+        used.push_back(x);
+        return x;
+    }
+
+    int find(int x) { return forest.find(x); }
+
+    int unite(int a, int b) {
+        a = forest.find(a);
+        b = forest.find(b);
+        if (a == b) return a;
+        int root = forest.unite(a, b);
+        acc[root].merge(acc[root == a ? b : a]);
+        return root;
+    }
+
+    /**
+        Frees the elements which are not roots with pixels in row r. The kept
+        roots point to themselves, so nothing refers to a freed element.
+    */
+    void recycle(int r) {
+        size_t kept = 0;
+        for (int x : used) {
+            if (lastRow[x] == r) {
+                used[kept++] = x;
+            }
+            else {
+                forest.reset(x);
+                acc[x] = StatsAccumulator();
+                lastRow[x] = -1;
+                unused.push_back(x);
+            }
+        }
+        used.resize(kept);
+    }
+};
+
+/**
+    End of a component met by the first pass: the row labels written to the
+    temporary file at row give it the element root.
+*/
+struct ComponentEnd {
+    int row;
+    int root;
+    int label;
+};
+
+/**
+    Ends the components whose roots appear in labels (row r - 1) but have no
+    pixel in row r.
+*/
+static void endComponents(const vector<int> &labels, int r, StreamForest &forest,
+                          vector<ComponentStats> &stats, vector<ComponentEnd> *ends) {
+    for (int root : labels) {
+        if (root == 0) continue;
+        root = forest.find(root);
+        if (forest.lastRow[root] != r - 1) continue; // continues in row r, or already ended
+        forest.lastRow[root] = -1;
+        int label = (int) stats.size();
+        stats.push_back(forest.acc[root].stats());
+        if (ends) ends->push_back({r - 1, root, label});
+    }
+}
+
+static bool writeRow(FILE *file, const vector<int> &row, int r) {
+    off_t offset = (off_t) r * row.size() * sizeof(int);
+    return fseeko(file, offset, SEEK_SET) == 0
+        && fwrite(row.data(), sizeof(int), row.size(), file) == row.size();
+}
+
+static bool readRow(FILE *file, vector<int> &row, int r) {
+    off_t offset = (off_t) r * row.size() * sizeof(int);
+    return fseeko(file, offset, SEEK_SET) == 0
+        && fread(row.data(), sizeof(int), row.size(), file) == row.size();
+}
+
+/**
+    Second pass, from the last row to the first. A root of row r either ends
+    in that row (its label is in ends) or has a pixel touching row r + 1, whose
+    final labels are known: all the pixels of the root get that label.
+*/
+static bool relabel(FILE *provisional, FILE *output, int rows, int cols,
+                    Connectivity connectivity, const vector<ComponentEnd> &ends,
+                    int forestSize) {
+    vector<int> row(cols), below(cols, 0), out(cols);
+    vector<int> finalLabel(forestSize, 0);
+    int end = (int) ends.size() - 1;
+
+    for (int r = rows - 1; r >= 0; r--) {
+        if (!readRow(provisional, row, r)) return false;
+        for (; end >= 0 && ends[end].row == r; end--)
+            finalLabel[ends[end].root] = ends[end].label;
+
+        for (int j = 0; j < cols; j++) {
+            int root = row[j];
+            if (root == 0 || finalLabel[root] != 0) continue;
+            if (below[j] != 0) {
+                finalLabel[root] = below[j];
+            }
+            else if (connectivity == CONNECTIVITY_8) {
+                if (j > 0 && below[j - 1] != 0) finalLabel[root] = below[j - 1];
+                else if (j + 1 < cols && below[j + 1] != 0) finalLabel[root] = below[j + 1];
+            }
+        }
+        for (int j = 0; j < cols; j++) {
+            out[j] = row[j] ? finalLabel[row[j]] : 0;
+            assert(row[j] == 0 || out[j] != 0);
+        }
+        if (!writeRow(output, out, r)) return false;
+
+        for (int j = 0; j < cols; j++)
+            finalLabel[row[j]] = 0;
+        swap(below, out);
+    }
+    return true;
+}
+
+int labelComponentsStreaming(StripSource source, int cols, vector<ComponentStats> &stats,
+                             Connectivity connectivity, const string &labelsPath)
+{
+    assert(cols > 0);
+    assert(connectivity == CONNECTIVITY_4 || connectivity == CONNECTIVITY_8);
+    bool eight = connectivity == CONNECTIVITY_8;
+    stats.assign(1, ComponentStats());
+    if (!source)
+        return -1;
+
+    unique_ptr<FILE, int (*)(FILE *)> provisional(nullptr, fclose);
+    vector<ComponentEnd> ends;
+    if (!labelsPath.empty()) {
+        provisional.reset(tmpfile());
+        if (!provisional) return -1;
+    }
+
+    StreamForest forest;
+    vector<uchar> mask(cols), prevMask(cols, 0);
+    vector<int> labels(cols), prev(cols, 0);
+    int r = 0;
+    Mat strip;
+
+    while (source(strip)) {
+        assert(strip.cols == cols && strip.channels() == 1);
+        for (int i = 0; i < strip.rows; i++, r++) {
+            maskRow(strip, i, mask);
+
+            for (int j = 0; j < cols; j++) {
+                if (!mask[j]) {
+                    labels[j] = 0;
+                    continue;
+                }
+                int label = 0;
+                auto link = [&](int neighbour) {
+                    if (neighbour == 0) return;
+                    label = label ? forest.unite(label, neighbour) : neighbour;
+                };
+                if (j > 0) link(labels[j - 1]);
+                link(prev[j]);
+                if (eight && j > 0) link(prev[j - 1]);
+                if (eight && j + 1 < cols) link(prev[j + 1]);
+                if (label == 0) label = forest.newLabel();
+                labels[j] = label;
+
+                StatsAccumulator &acc = forest.acc[forest.find(label)];
+                acc.addSpan(r, j, j);
+                acc.pairs += (j > 0 && mask[j - 1]) + prevMask[j];
+            }
+
+            for (int j = 0; j < cols; j++) {
+                if (labels[j] == 0) continue;
+                labels[j] = forest.find(labels[j]);
+                forest.lastRow[labels[j]] = r;
+            }
+            endComponents(prev, r, forest, stats, provisional ? &ends : nullptr);
+            if (provisional && !writeRow(provisional.get(), labels, r)) return -1;
+
+            forest.recycle(r);
+            swap(labels, prev);
+            swap(mask, prevMask);
+        }
+    }
+    endComponents(prev, r, forest, stats, provisional ? &ends : nullptr);
+
+    if (provisional) {
+        unique_ptr<FILE, int (*)(FILE *)> output(fopen(labelsPath.c_str(), "wb"), fclose);
+        if (!output) return -1;
+        if (!relabel(provisional.get(), output.get(), r, cols, connectivity, ends,
+                     forest.forest.size()))
+            return -1;
+    }
+    return (int) stats.size() - 1;
+}
@@ -0,0 +1,53 @@
+#ifndef STREAM_LABELING_H
+#define STREAM_LABELING_H
+
+#include <opencv2/core.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+#include "labeling.h"
+
+/**
+    Supplies an image strip by strip: fills strip with the next rows (any
+    number of them, always the same number of columns, CV_8UC1, CV_32SC1 or
+    CV_32FC1) and returns false once the image is exhausted.
+*/
+typedef std::function<bool(cv::Mat &strip)> StripSource;
+
+/**
+    Strips of stripRows rows of an image held in memory (no copy).
+*/
+StripSource matStripSource(cv::Mat image, int stripRows = 256);
+
+/**
+    Strips of stripRows rows read from a raw 8-bit file of cols columns
+    (row after row, no header). Empty (no function) when the file cannot be
+    opened or its size is not a whole number of rows.
+*/
+StripSource rawStripSource(const std::string &path, int cols, int stripRows = 256);
+
+/**
+    Connected components of a mask too large to be held in memory, any non zero
+    pixel being present. Rows are read once, in order, from source; only the
+    current and previous rows of the mask and of the labels are kept, with a
+    union-find forest whose elements are recycled as soon as no pixel of the
+    current row refers to them, so that memory is O(cols) besides the
+    statistics.
+
+    Components are numbered 1..N in the order in which they end (at their last
+    row, then from left to right), and stats[k] describes component k
+    (stats[0] is left empty). Returns N, or -1 when a file cannot be used:
+    source is empty (rawStripSource of a file that cannot be opened or does
+    not hold whole rows) or the labels cannot be written.
+
+    When labelsPath is not empty, the labels are also written to that file as
+    raw CV_32SC1 rows. The first pass then keeps its row labels in a temporary
+    file and a second pass, from the last row to the first, gives the final
+    labels of each row from the ones of the row below, with O(cols) memory
+    and 12 bytes per component.
+*/
+int labelComponentsStreaming(StripSource source, int cols, std::vector<ComponentStats> &stats,
+                             Connectivity connectivity = CONNECTIVITY_4,
+                             const std::string &labelsPath = "");
+
+#endif
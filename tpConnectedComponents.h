@@ -0,0 +1,10 @@
+#ifndef TPCONNECTEDCOMPONENTS_H
+#define TPCONNECTEDCOMPONENTS_H
+
+#include "common.h"
+
+cv::Mat ccLabel(cv::Mat image);
+cv::Mat ccAreaFilter(cv::Mat image, int size);
+cv::Mat ccTwoPassLabel(cv::Mat image);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef TPCONVOLUTION_H
+#define TPCONVOLUTION_H
+
+#include "common.h"
+
+cv::Mat meanFilter(cv::Mat image, int k);
+cv::Mat convolution(cv::Mat image, cv::Mat kernel);
+cv::Mat edgeSobel(cv::Mat image);
+float gaussian(float x, float sigma2);
+cv::Mat bilateralFilter(cv::Mat image, cv::Mat kernel, double sigma_r);
+
+#endif
@@ -1,4 +1,8 @@
 #include "tpGeometry.h"
+#include "warpEngine.h"
+#include "resize.h"
+#include "transposeEngine.h"
+#include "trace.h"
 #include <cmath>
 #include <algorithm>
 #include <tuple>
@@ -12,57 +16,35 @@ using namespace std;
 */
 Mat transpose(Mat image)
 {
-    Mat res = Mat::zeros(image.cols, image.rows, CV_32FC1);
-
-     for (int i = 0 ; i < image.rows; i++) {
-        for(int j = 0; j < image.cols; j++) {
-            res.at<int>(j,i) = image.at<int>(i,j); 
-        }
-     }
-
-    // printf("%f\n",interpolate_nearest(image, 0.75, 1.245));
-    // printf("%f\n", image.at<int>(1,2));
+    TraceScope scope("transpose");
+    traceCount(TRACE_PIXELS, (int64_t) image.total());
+    Mat res;
+    transposeImage(image, res);
     return res;
 }
 
 /**
     Compute the value of a nearest neighbour interpolation
-    in image Mat at position (x,y)
+    in image Mat at position (x,y), x being the row.
+    Positions outside of the image are clamped to its border.
 */
 float interpolate_nearest(Mat image, float x, float y)
 {
     float v = 0;
-    int a = (int) round(x);
-    int b = (int) round(y);
-    v = image.at<float>(a,b);
+    interpolate(image, &y, &x, 1, &v, INTERP_NEAREST);
     return v;
-
 }
 
 
 /**
-    Compute the value of a bilinear interpolation in image Mat at position (x,y)
+    Compute the value of a bilinear interpolation in image Mat at position (x,y),
+    x being the row. The last row and column are replicated, positions outside
+    of the image are clamped to its border.
 */
 float interpolate_bilinear(Mat image, float x, float y)
 {
-    int x1 = int(x);
-    int y1 = int(y);
-
-    int x2 = x1 + 1;
-    int y2 = y1 + 1;
-
-    float alpha = image.at<float>(x2, y1) - image.at<float>(x1, y1);
-    float beta = image.at<float>(x2, y2) - image.at<float>(x1, y2);
-
-
-    float f_x_y1 = image.at<float>(x1, y1) + alpha * (x - x1);
-    float f_x_y2 = image.at<float>(x1, y2) + beta * (x - x1);
-
-    float gamma = f_x_y2 - f_x_y1; 
-    
-
-    float v = f_x_y1 + (y - y1) * gamma;
-  
+    float v = 0;
+    interpolate(image, &y, &x, 1, &v, INTERP_BILINEAR);
     return v;
 }
 
@@ -73,16 +55,15 @@ float interpolate_bilinear(Mat image, float x, float y)
 Mat expand(Mat image, int factor, float(* interpolationFunction)(cv::Mat image, float y, float x))
 {
     assert(factor>0);
-    Mat res = Mat::zeros((image.rows -1) * factor,(image.cols -1) * factor,CV_32FC1);
-
-    for (int i = 0 ; i < res.rows; i++) {
-        for(int j = 0; j < res.cols; j++) {
-            res.at<float>(i,j) = interpolationFunction(image, (float) i  / factor, (float) j / factor);
-        }
-    }
-
-
-    return res;
+    TraceScope scope("expand");
+    traceCount(TRACE_PIXELS, (int64_t) image.total());
+    if (interpolationFunction == interpolate_nearest)
+        return resize(image, expandPlan(image.size(), factor, RESIZE_NEAREST));
+    if (interpolationFunction == interpolate_bilinear)
+        return resize(image, expandPlan(image.size(), factor, RESIZE_BILINEAR));
+
+    Size size((image.cols - 1) * factor, (image.rows - 1) * factor);
+    return warp(image, AffineMap::scaling(factor, factor), size, interpolationFunction);
 }
 
 /**
@@ -92,18 +73,30 @@ Mat expand(Mat image, int factor, float(* interpolationFunction)(cv::Mat image,
     Ouput size depends of the input image size and the rotation angle.
 
     Output pixels that map outside the input image are set to 0.
+    Multiples of 90 degrees are exact quarter turns (no interpolation) of
+    the full size, rows x cols or cols x rows, where the resampling path
+    truncated it (see tpGeometry.h).
 */
 
 Mat rotate(Mat image, float angle, float(* interpolationFunction)(cv::Mat image, float y, float x))
 {
+    TraceScope scope("rotate");
+    traceCount(TRACE_PIXELS, (int64_t) image.total());
+    if (fmod(angle, 90.0f) == 0) {
+        Mat res = rotateQuarterTurns(image, (int) (angle / 90));
+        if (res.type() != CV_32FC1)
+            res.convertTo(res, CV_32FC1);
+        return res;
+    }
+
     int height = image.rows;
     int width = image.cols;
     
     // transforming angle to alpha € [0, Pi]
     float alpha = angle * M_PI / 180; 
-    printf("alpha is %f\n", alpha);
+    traceMessage("alpha is %f", alpha);
     double twoPi = 2.0 * M_PI;
-    printf("floor is %f\n", floor(alpha / twoPi));
+    traceMessage("floor is %f", floor(alpha / twoPi));
     alpha = alpha - twoPi * floor(alpha / twoPi);
 
 
@@ -120,33 +113,9 @@ Mat rotate(Mat image, float angle, float(* interpolationFunction)(cv::Mat image,
         newHeight = int( (width - 1) * sin(alpha) - (height - 1) * cos(alpha) );
     }
 
-    Mat res = Mat::zeros(newHeight, newWidth,CV_32FC1);
-
-    //float center_x = ((width-1) * cos(alpha) + (height-1) * sin(alpha)) / 2.0;
-    //float center_y =  ((width-1) * sin(alpha) + (height-1) * cos(alpha)) / 2.0;
-
     float center_x = (float) (newWidth - 1) / 2.0;
     float center_y = (float) (newHeight - 1) / 2.0;
 
-
-    for (int i = 0 ; i < res.rows; i++) {
-        for(int j = 0; j < res.cols; j++) {
-
-            float u = ((float) j) - center_x;
-            float v = ((float) i) - center_y;
-
-            float x = u * cos(alpha) - v * sin(alpha);
-            float y = u * sin(alpha) + v * cos(alpha);
-
-            x = x + old_center_x;
-            y = y + old_center_y;
-
-            if (x > 0 && x < image.cols - 1  && y > 0 && y < image.rows - 1 ) {
-                res.at<float>(i, j) = interpolationFunction(image, y, x); 
-            }
-        }
-    }
-
-    return res;
-
-}
\ No newline at end of file
+    AffineMap map = AffineMap::rotation(angle, old_center_x, old_center_y, center_x, center_y);
+    return warp(image, map, Size(newWidth, newHeight), interpolationFunction);
+}
@@ -0,0 +1,19 @@
+#ifndef TPGEOMETRY_H
+#define TPGEOMETRY_H
+
+#include "common.h"
+
+cv::Mat transpose(cv::Mat image);
+float interpolate_nearest(cv::Mat image, float x, float y);
+float interpolate_bilinear(cv::Mat image, float x, float y);
+cv::Mat expand(cv::Mat image, int factor, float(* interpolationFunction)(cv::Mat image, float y, float x));
+/**
+    Multiples of 90 degrees are exact turns of size rows x cols (0, 180 degrees)
+    or cols x rows (90, 270 degrees). Behaviour change: the resampling path
+    used before gave (cols-1) x (rows-1) at 90 degrees, (rows-2) x (cols-2)
+    at 180 degrees and a negative size (failure) at 270 degrees, with the
+    same rows x cols at 0 degrees. Other angles keep the resampled size.
+*/
+cv::Mat rotate(cv::Mat image, float angle, float(* interpolationFunction)(cv::Mat image, float y, float x));
+
+#endif
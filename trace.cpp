@@ -0,0 +1,184 @@
+#include "trace.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+atomic<bool> tracingFlag(false);
+
+static const char *counterNames[TRACE_COUNTERS] = {"pixels", "components", "merges", "allocations"};
+static atomic<int64_t> counters[TRACE_COUNTERS];
+
+struct TraceEvent {
+    const char *name;
+    char phase;        // 'X' scope, 'C' counter, 'i' message
+    int64_t timestamp; // ns
+    int64_t value;     // duration of a scope, total of a counter
+    string text;
+};
+
+struct ThreadTrace {
+    int id = 0;
+    mutex lock; // only contended while exporting
+    vector<TraceEvent> events;
+};
+
+static mutex registryLock;
+static vector<shared_ptr<ThreadTrace>> registry; // kept after the threads end
+
+static ThreadTrace &threadTrace()
+{
+    thread_local shared_ptr<ThreadTrace> trace;
+    if (!trace) {
+        trace = make_shared<ThreadTrace>();
+        lock_guard<mutex> guard(registryLock);
+        trace->id = (int) registry.size() + 1;
+        registry.push_back(trace);
+    }
+    return *trace;
+}
+
+static void record(TraceEvent &&event)
+{
+    ThreadTrace &trace = threadTrace();
+    lock_guard<mutex> guard(trace.lock);
+    trace.events.push_back(move(event));
+}
+
+int64_t traceNow()
+{
+    static const chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+void setTracing(bool enabled)
+{
+    traceNow(); // fixes the origin
+    tracingFlag = enabled;
+}
+
+void recordTraceScope(const char *name, int64_t start)
+{
+    int64_t end = traceNow();
+    record(TraceEvent{name, 'X', start, end - start, string()});
+}
+
+void recordTraceCount(TraceCounter counter, int64_t n)
+{
+    int64_t total = counters[counter].fetch_add(n, memory_order_relaxed) + n;
+    record(TraceEvent{counterNames[counter], 'C', traceNow(), total, string()});
+}
+
+void recordTraceMessage(const char *format, ...)
+{
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    record(TraceEvent{"message", 'i', traceNow(), 0, string(buffer)});
+}
+
+int64_t traceCounter(TraceCounter counter)
+{
+    return counters[counter].load();
+}
+
+/********************************************
+                  EXPORT
+*********************************************/
+
+static void appendEscaped(string &out, const string &text)
+{
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char) c < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            out += code;
+        } else {
+            out += c;
+        }
+    }
+}
+
+string traceJson()
+{
+    string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    char number[96];
+    lock_guard<mutex> registryGuard(registryLock);
+    for (const shared_ptr<ThreadTrace> &trace : registry) {
+        lock_guard<mutex> guard(trace->lock);
+        for (const TraceEvent &e : trace->events) {
+            out += first ? "\n" : ",\n";
+            first = false;
+            out += "{\"name\":\"";
+            out += e.name;
+            snprintf(number, sizeof(number), "\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f", e.phase, trace->id,
+                     e.timestamp * 1e-3);
+            out += number;
+            if (e.phase == 'X') {
+                snprintf(number, sizeof(number), ",\"dur\":%.3f}", e.value * 1e-3);
+                out += number;
+            } else if (e.phase == 'C') {
+                snprintf(number, sizeof(number), ",\"args\":{\"%s\":%lld}}", e.name, (long long) e.value);
+                out += number;
+            } else {
+                out += ",\"s\":\"t\",\"args\":{\"text\":\"";
+                appendEscaped(out, e.text);
+                out += "\"}}";
+            }
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool writeTrace(const string &path)
+{
+    FILE *f = fopen(path.c_str(), "w");
+    if (f == nullptr)
+        return false;
+    string json = traceJson();
+    bool ok = fwrite(json.data(), 1, json.size(), f) == json.size();
+    return fclose(f) == 0 && ok;
+}
+
+void clearTrace()
+{
+    lock_guard<mutex> registryGuard(registryLock);
+    for (const shared_ptr<ThreadTrace> &trace : registry) {
+        lock_guard<mutex> guard(trace->lock);
+        trace->events.clear();
+    }
+    for (atomic<int64_t> &c : counters)
+        c = 0;
+}
+
+/**
+    IMAGES_TRACE=path turns tracing on at startup and writes the trace at exit.
+*/
+static string tracePath;
+
+static void writeTraceAtExit()
+{
+    if (!writeTrace(tracePath))
+        fprintf(stderr, "cannot write the trace to %s\n", tracePath.c_str());
+}
+
+static bool traceFromEnvironment = []() {
+    const char *path = getenv("IMAGES_TRACE");
+    if (path == nullptr || *path == 0)
+        return false;
+    tracePath = path;
+    setTracing(true);
+    atexit(writeTraceAtExit);
+    return true;
+}();
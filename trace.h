@@ -0,0 +1,111 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+    Tracing of the operators: scoped timers, counters and diagnostic messages,
+    exported in the Chrome trace event format (chrome://tracing, Perfetto).
+
+    Off by default: every entry point then reduces to the test of one flag,
+    and to nothing at all when compiled with IMAGES_NO_TRACING. It is turned
+    on by setTracing(true), or for the whole run of a program by setting the
+    environment variable IMAGES_TRACE to the path of the file written at exit.
+
+    Events are kept in a buffer per thread, so recording does not contend
+    between the workers of the pool.
+*/
+
+/**
+    Counters summed over all threads since the last clearTrace().
+
+    TRACE_PIXELS      : pixels given to the operators.
+    TRACE_COMPONENTS  : connected components found.
+    TRACE_MERGES      : unions of two different sets of the labeling forests.
+    TRACE_ALLOCATIONS : images and scratch blocks allocated (see bufferPool.h).
+*/
+enum TraceCounter {
+    TRACE_PIXELS,
+    TRACE_COMPONENTS,
+    TRACE_MERGES,
+    TRACE_ALLOCATIONS,
+    TRACE_COUNTERS
+};
+
+extern std::atomic<bool> tracingFlag;
+
+inline bool tracingEnabled()
+{
+#ifdef IMAGES_NO_TRACING
+    return false;
+#else
+    return tracingFlag.load(std::memory_order_relaxed);
+#endif
+}
+
+void setTracing(bool enabled);
+
+/**
+    Nanoseconds since the start of the program.
+*/
+int64_t traceNow();
+
+void recordTraceScope(const char *name, int64_t start);
+void recordTraceCount(TraceCounter counter, int64_t n);
+void recordTraceMessage(const char *format, ...);
+
+inline void traceCount(TraceCounter counter, int64_t n)
+{
+    if (tracingEnabled())
+        recordTraceCount(counter, n);
+}
+
+int64_t traceCounter(TraceCounter counter);
+
+/**
+    printf-like message, formatted only when tracing is on.
+*/
+template<typename... Args>
+inline void traceMessage(const char *format, Args... args)
+{
+    if (tracingEnabled())
+        recordTraceMessage(format, args...);
+}
+
+/**
+    Records the time spent from its construction to its destruction under
+    name, which must be a string literal (it is kept as a pointer).
+*/
+class TraceScope {
+public:
+    explicit TraceScope(const char *name) : name(tracingEnabled() ? name : nullptr) {
+        if (this->name != nullptr)
+            start = traceNow();
+    }
+    ~TraceScope() {
+        if (name != nullptr)
+            recordTraceScope(name, start);
+    }
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name;
+    int64_t start = 0;
+};
+
+/**
+    Events recorded so far as a Chrome trace JSON document, and the same
+    written to a file (false if it cannot be written).
+*/
+std::string traceJson();
+bool writeTrace(const std::string &path);
+
+/**
+    Drops the recorded events and resets the counters.
+*/
+void clearTrace();
+
+#endif
@@ -0,0 +1,357 @@
+#include "transposeEngine.h"
+#include "simdKernels.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_X86 0
+#endif
+
+using namespace cv;
+using namespace std;
+
+/**
+    A plane is walked from data with a signed row step in bytes, so that a
+    flipped view is the last row with a negative step.
+*/
+struct Plane {
+    uchar *data;
+    ptrdiff_t step;
+
+    uchar *at(int i, int j, int elemSize) const {
+        return data + i * step + (ptrdiff_t) j * elemSize;
+    }
+};
+
+static Plane planeOf(const Mat &image, bool flipped) {
+    Plane p;
+    p.data = (uchar *) image.ptr(flipped ? max(image.rows - 1, 0) : 0);
+    p.step = flipped ? -(ptrdiff_t) image.step : (ptrdiff_t) image.step;
+    return p;
+}
+
+/**
+    8x8 tile transposes: dst row k = src column k.
+*/
+typedef void (*Tile8Function)(const uchar *src, ptrdiff_t srcStep, uchar *dst, ptrdiff_t dstStep);
+
+#if SIMD_X86
+
+TARGET_SSE41 static void tile8x8x8Sse41(const uchar *src, ptrdiff_t srcStep, uchar *dst, ptrdiff_t dstStep) {
+    __m128i r[8];
+    for (int k = 0; k < 8; k++)
+        r[k] = _mm_loadl_epi64((const __m128i *) (src + k * srcStep));
+    __m128i a0 = _mm_unpacklo_epi8(r[0], r[1]), a1 = _mm_unpacklo_epi8(r[2], r[3]);
+    __m128i a2 = _mm_unpacklo_epi8(r[4], r[5]), a3 = _mm_unpacklo_epi8(r[6], r[7]);
+    __m128i b0 = _mm_unpacklo_epi16(a0, a1), b1 = _mm_unpackhi_epi16(a0, a1); // columns 0-3, 4-7 of rows 0-3
+    __m128i b2 = _mm_unpacklo_epi16(a2, a3), b3 = _mm_unpackhi_epi16(a2, a3); // same for rows 4-7
+    __m128i o[4] = {_mm_unpacklo_epi32(b0, b2), _mm_unpackhi_epi32(b0, b2),
+                    _mm_unpacklo_epi32(b1, b3), _mm_unpackhi_epi32(b1, b3)};
+    for (int k = 0; k < 4; k++) {
+        _mm_storel_epi64((__m128i *) (dst + (2 * k) * dstStep), o[k]);
+        _mm_storel_epi64((__m128i *) (dst + (2 * k + 1) * dstStep), _mm_srli_si128(o[k], 8));
+    }
+}
+
+TARGET_SSE41 static void tile8x8x16Sse41(const uchar *src, ptrdiff_t srcStep, uchar *dst, ptrdiff_t dstStep) {
+    __m128i r[8];
+    for (int k = 0; k < 8; k++)
+        r[k] = _mm_loadu_si128((const __m128i *) (src + k * srcStep));
+    __m128i a[8];
+    for (int k = 0; k < 4; k++) {
+        a[2 * k] = _mm_unpacklo_epi16(r[2 * k], r[2 * k + 1]);
+        a[2 * k + 1] = _mm_unpackhi_epi16(r[2 * k], r[2 * k + 1]);
+    }
+    // b[4 * h + c]: columns 2c, 2c+1 of rows 4h..4h+3
+    __m128i b[8];
+    for (int h = 0; h < 2; h++) {
+        b[4 * h] = _mm_unpacklo_epi32(a[4 * h], a[4 * h + 2]);
+        b[4 * h + 1] = _mm_unpackhi_epi32(a[4 * h], a[4 * h + 2]);
+        b[4 * h + 2] = _mm_unpacklo_epi32(a[4 * h + 1], a[4 * h + 3]);
+        b[4 * h + 3] = _mm_unpackhi_epi32(a[4 * h + 1], a[4 * h + 3]);
+    }
+    for (int c = 0; c < 4; c++) {
+        _mm_storeu_si128((__m128i *) (dst + (2 * c) * dstStep), _mm_unpacklo_epi64(b[c], b[4 + c]));
+        _mm_storeu_si128((__m128i *) (dst + (2 * c + 1) * dstStep), _mm_unpackhi_epi64(b[c], b[4 + c]));
+    }
+}
+
+TARGET_SSE41 static void tile8x8x32Sse41(const uchar *src, ptrdiff_t srcStep, uchar *dst, ptrdiff_t dstStep) {
+    for (int bi = 0; bi < 8; bi += 4) {
+        for (int bj = 0; bj < 8; bj += 4) {
+            __m128 r0 = _mm_loadu_ps((const float *) (src + (bi + 0) * srcStep + 4 * bj));
+            __m128 r1 = _mm_loadu_ps((const float *) (src + (bi + 1) * srcStep + 4 * bj));
+            __m128 r2 = _mm_loadu_ps((const float *) (src + (bi + 2) * srcStep + 4 * bj));
+            __m128 r3 = _mm_loadu_ps((const float *) (src + (bi + 3) * srcStep + 4 * bj));
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps((float *) (dst + (bj + 0) * dstStep + 4 * bi), r0);
+            _mm_storeu_ps((float *) (dst + (bj + 1) * dstStep + 4 * bi), r1);
+            _mm_storeu_ps((float *) (dst + (bj + 2) * dstStep + 4 * bi), r2);
+            _mm_storeu_ps((float *) (dst + (bj + 3) * dstStep + 4 * bi), r3);
+        }
+    }
+}
+
+TARGET_AVX2 static void tile8x8x32Avx2(const uchar *src, ptrdiff_t srcStep, uchar *dst, ptrdiff_t dstStep) {
+    __m256 r[8], t[8], s[8];
+    for (int k = 0; k < 8; k++)
+        r[k] = _mm256_loadu_ps((const float *) (src + k * srcStep));
+    for (int k = 0; k < 8; k += 2) {
+        t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+        t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+    }
+    for (int h = 0; h < 8; h += 4) {
+        s[h] = _mm256_shuffle_ps(t[h], t[h + 2], _MM_SHUFFLE(1, 0, 1, 0));
+        s[h + 1] = _mm256_shuffle_ps(t[h], t[h + 2], _MM_SHUFFLE(3, 2, 3, 2));
+        s[h + 2] = _mm256_shuffle_ps(t[h + 1], t[h + 3], _MM_SHUFFLE(1, 0, 1, 0));
+        s[h + 3] = _mm256_shuffle_ps(t[h + 1], t[h + 3], _MM_SHUFFLE(3, 2, 3, 2));
+    }
+    for (int k = 0; k < 4; k++) {
+        _mm256_storeu_ps((float *) (dst + k * dstStep), _mm256_permute2f128_ps(s[k], s[k + 4], 0x20));
+        _mm256_storeu_ps((float *) (dst + (k + 4) * dstStep), _mm256_permute2f128_ps(s[k], s[k + 4], 0x31));
+    }
+}
+
+#endif
+
+static Tile8Function tile8Function(int elemSize) {
+#if SIMD_X86
+    SimdLevel level = simdLevel();
+    if (level >= SIMD_SSE41) {
+        switch (elemSize) {
+        case 1:
+            return tile8x8x8Sse41;
+        case 2:
+            return tile8x8x16Sse41;
+        case 4:
+            return level == SIMD_AVX2 ? tile8x8x32Avx2 : tile8x8x32Sse41;
+        default:
+            break;
+        }
+    }
+#endif
+    (void) elemSize;
+    return nullptr;
+}
+
+/********************************************
+              CACHE OBLIVIOUS CORE
+*********************************************/
+
+static const int LEAF = 32;
+
+template<typename T>
+static void transposeScalar(const uchar *src, ptrdiff_t srcStep, uchar *dst, ptrdiff_t dstStep,
+                            int rows, int cols) {
+    for (int i = 0; i < rows; i++) {
+        const T *in = (const T *) (src + i * srcStep);
+        for (int j = 0; j < cols; j++)
+            memcpy(dst + j * dstStep + (ptrdiff_t) i * sizeof(T), in + j, sizeof(T));
+    }
+}
+
+template<typename T>
+static void transposeLeaf(const uchar *src, ptrdiff_t srcStep, uchar *dst, ptrdiff_t dstStep,
+                          int rows, int cols, Tile8Function tile8) {
+    int rows8 = tile8 ? rows & ~7 : 0;
+    int cols8 = tile8 ? cols & ~7 : 0;
+    for (int i = 0; i < rows8; i += 8) {
+        for (int j = 0; j < cols8; j += 8)
+            tile8(src + i * srcStep + j * sizeof(T), srcStep, dst + j * dstStep + i * sizeof(T), dstStep);
+    }
+    transposeScalar<T>(src + cols8 * sizeof(T), srcStep, dst + cols8 * dstStep, dstStep, rows8, cols - cols8);
+    transposeScalar<T>(src + rows8 * srcStep, srcStep, dst + rows8 * sizeof(T), dstStep, rows - rows8, cols);
+}
+
+/**
+    Halves the larger side (at a multiple of 8 to keep whole tiles) until the
+    block is a leaf.
+*/
+template<typename T>
+static void transposeRecursive(const uchar *src, ptrdiff_t srcStep, uchar *dst, ptrdiff_t dstStep,
+                               int rows, int cols, Tile8Function tile8) {
+    if (rows <= LEAF && cols <= LEAF) {
+        transposeLeaf<T>(src, srcStep, dst, dstStep, rows, cols, tile8);
+    }
+    else if (rows >= cols) {
+        int h = (rows / 2 + 7) & ~7;
+        transposeRecursive<T>(src, srcStep, dst, dstStep, h, cols, tile8);
+        transposeRecursive<T>(src + h * srcStep, srcStep, dst + h * sizeof(T), dstStep, rows - h, cols, tile8);
+    }
+    else {
+        int w = (cols / 2 + 7) & ~7;
+        transposeRecursive<T>(src, srcStep, dst, dstStep, rows, w, tile8);
+        transposeRecursive<T>(src + w * sizeof(T), srcStep, dst + w * dstStep, dstStep, rows, cols - w, tile8);
+    }
+}
+
+typedef void (*TransposeBlock)(const uchar *, ptrdiff_t, uchar *, ptrdiff_t, int, int, Tile8Function);
+
+static TransposeBlock transposeBlock(int elemSize) {
+    switch (elemSize) {
+    case 1:
+        return transposeRecursive<uint8_t>;
+    case 2:
+        return transposeRecursive<uint16_t>;
+    case 4:
+        return transposeRecursive<uint32_t>;
+    case 8:
+        return transposeRecursive<uint64_t>;
+    default:
+        assert(false && "transpose: pixels of 1, 2, 4 or 8 bytes only");
+        return nullptr;
+    }
+}
+
+/**
+    dst(j, i) = src(i, j) over a rows x cols source, the source being cut in
+    tiles spread over the thread pool.
+*/
+static void transposePlanes(const Plane &src, const Plane &dst, int rows, int cols, int elemSize) {
+    TransposeBlock block = transposeBlock(elemSize);
+    Tile8Function tile8 = tile8Function(elemSize);
+    parallel_for_2d(rows, cols, Size(256, 256), [&](const Rect &tile) {
+        block(src.at(tile.y, tile.x, elemSize), src.step, dst.at(tile.x, tile.y, elemSize), dst.step,
+              tile.height, tile.width, tile8);
+    });
+}
+
+void transposeImage(const Mat &src, Mat &dst)
+{
+    assert(dst.data == nullptr || dst.data != src.data);
+    dst.create(src.cols, src.rows, src.type());
+    transposePlanes(planeOf(src, false), planeOf(dst, false), src.rows, src.cols, (int) src.elemSize());
+}
+
+void transposeInPlace(Mat &image)
+{
+    assert(image.rows == image.cols);
+    int elemSize = (int) image.elemSize();
+    TransposeBlock block = transposeBlock(elemSize);
+    Tile8Function tile8 = tile8Function(elemSize);
+    Plane p = planeOf(image, false);
+    int n = image.rows;
+    int tiles = (n + LEAF - 1) / LEAF;
+
+    // tile row I swaps its tiles (I, J), J >= I, with the tiles (J, I)
+    parallel_for_1d(tiles, 1, [&](int begin, int end) {
+        uchar buffer[LEAF * LEAF * 8];
+        ptrdiff_t bufferStep = LEAF * elemSize;
+        for (int ti = begin; ti < end; ti++) {
+            int i = ti * LEAF, h = min(LEAF, n - i);
+            for (int j = i; j < n; j += LEAF) {
+                int w = min(LEAF, n - j);
+                block(p.at(i, j, elemSize), p.step, buffer, bufferStep, h, w, tile8);
+                if (j != i)
+                    block(p.at(j, i, elemSize), p.step, p.at(i, j, elemSize), p.step, w, h, tile8);
+                for (int r = 0; r < w; r++)
+                    memcpy(p.at(j + r, i, elemSize), buffer + r * bufferStep, (size_t) h * elemSize);
+            }
+        }
+    });
+}
+
+/********************************************
+                    FLIPS
+*********************************************/
+
+template<typename T>
+static void reverseRowScalar(const uchar *src, uchar *dst, int j0, int n) {
+    const T *in = (const T *) src;
+    T *out = (T *) dst;
+    for (int j = j0; j < n; j++)
+        out[n - 1 - j] = in[j];
+}
+
+#if SIMD_X86
+
+/**
+    Reverses the 16 byte chunks of the row with pshufb, the rest is scalar.
+*/
+template<typename T>
+TARGET_SSE41 static void reverseRowSse41(const uchar *src, uchar *dst, int n) {
+    alignas(16) char mask[16];
+    for (int b = 0; b < 16; b++)
+        mask[b] = (char) ((15 - b) / (int) sizeof(T) * sizeof(T) + b % sizeof(T));
+    const __m128i shuffle = _mm_load_si128((const __m128i *) mask);
+    const int lanes = 16 / sizeof(T);
+    int j = 0;
+    for (; j + lanes <= n; j += lanes) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + j * sizeof(T)));
+        _mm_storeu_si128((__m128i *) (dst + (n - j - lanes) * sizeof(T)), _mm_shuffle_epi8(v, shuffle));
+    }
+    reverseRowScalar<T>(src, dst, j, n);
+}
+
+#endif
+
+template<typename T>
+static void reverseRow(const uchar *src, uchar *dst, int n) {
+#if SIMD_X86
+    if (simdLevel() >= SIMD_SSE41)
+        return reverseRowSse41<T>(src, dst, n);
+#endif
+    reverseRowScalar<T>(src, dst, 0, n);
+}
+
+typedef void (*ReverseRowFunction)(const uchar *, uchar *, int);
+
+static ReverseRowFunction reverseRowFunction(int elemSize) {
+    switch (elemSize) {
+    case 1:
+        return reverseRow<uint8_t>;
+    case 2:
+        return reverseRow<uint16_t>;
+    case 4:
+        return reverseRow<uint32_t>;
+    case 8:
+        return reverseRow<uint64_t>;
+    default:
+        assert(false && "flip: pixels of 1, 2, 4 or 8 bytes only");
+        return nullptr;
+    }
+}
+
+Mat flipImage(Mat image, FlipMode mode)
+{
+    Mat res(image.rows, image.cols, image.type());
+    int elemSize = (int) image.elemSize();
+    size_t rowBytes = (size_t) image.cols * elemSize;
+    Plane src = planeOf(image, mode != FLIP_HORIZONTAL);
+    Plane dst = planeOf(res, false);
+    ReverseRowFunction reverse = mode == FLIP_VERTICAL ? nullptr : reverseRowFunction(elemSize);
+
+    parallel_for_1d(image.rows, max(1, (1 << 16) / max(1, image.cols)), [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            if (reverse)
+                reverse(src.at(i, 0, elemSize), dst.at(i, 0, elemSize), image.cols);
+            else
+                memcpy(dst.at(i, 0, elemSize), src.at(i, 0, elemSize), rowBytes);
+        }
+    });
+    return res;
+}
+
+Mat rotateQuarterTurns(Mat image, int turns)
+{
+    turns = ((turns % 4) + 4) % 4;
+    if (turns == 0)
+        return image.clone();
+    if (turns == 2)
+        return flipImage(image, FLIP_BOTH);
+
+    // one turn: transpose then flip the output upside down,
+    // three turns: transpose the source flipped upside down
+    Mat res(image.cols, image.rows, image.type());
+    transposePlanes(planeOf(image, turns == 3), planeOf(res, turns == 1), image.rows, image.cols,
+                    (int) image.elemSize());
+    return res;
+}
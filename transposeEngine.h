@@ -0,0 +1,45 @@
+#ifndef TRANSPOSE_ENGINE_H
+#define TRANSPOSE_ENGINE_H
+
+#include <opencv2/core.hpp>
+
+/**
+    Transposition and its relatives (quarter turns, flips) for single or multi
+    channel images of 1, 2, 4 or 8 byte pixels, whatever their depth.
+
+    The transpose splits the larger side of the image in two until blocks fit
+    in 32x32 pixels (cache oblivious: every level of the hierarchy is used
+    without knowing its size), then transposes 8x8 tiles in registers (SSE for
+    8 and 16-bit pixels, AVX for 32-bit ones, level of simdKernels.h).
+    Quarter turns are transposes of flipped views of the source or of the
+    output, which are the same pointers walked with negative row steps.
+*/
+
+/**
+    dst = transpose of src (dst is reallocated as src.cols x src.rows of the
+    type of src and must not share its data).
+*/
+void transposeImage(const cv::Mat &src, cv::Mat &dst);
+
+/**
+    Transposes a square image in place, by swapping 32x32 tiles through a
+    small buffer.
+*/
+void transposeInPlace(cv::Mat &image);
+
+enum FlipMode {
+    FLIP_VERTICAL,   // upside down: row i goes to row rows-1-i
+    FLIP_HORIZONTAL, // mirror: column j goes to column cols-1-j
+    FLIP_BOTH        // both, ie. a half turn
+};
+
+cv::Mat flipImage(cv::Mat image, FlipMode mode);
+
+/**
+    Rotation by turns * 90 degrees, in the direction of rotate (tpGeometry):
+    one turn gives dst(i, j) = src(j, cols-1-i). Exact, without interpolation,
+    and the output is cols x rows for odd turns.
+*/
+cv::Mat rotateQuarterTurns(cv::Mat image, int turns);
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef UNION_FIND_H
+#define UNION_FIND_H
+
+#include <vector>
+#include <utility>
+
+/**
+    Disjoint set forest over the integers 0..size()-1, with union by rank and
+    path compression: any sequence of n operations runs in O(n alpha(n)).
+    Set 0 is created with the forest and stands for the background label.
+*/
+class UnionFind {
+public:
+    UnionFind() : parent(1, 0), rank(1, 0) {}
+
+    void reserve(int n) {
+        parent.reserve(n);
+        rank.reserve(n);
+    }
+
+    int size() const { return (int) parent.size(); }
+
+    /**
+        Adds a singleton set and returns its element.
+    */
+    int makeSet() {
+        int x = (int) parent.size();
+        parent.push_back(x);
+        rank.push_back(0);
+        return x;
+    }
+
+    /**
+        Makes x a singleton again so that it can be recycled. No other element
+        may point to x.
+    */
+    void reset(int x) {
+        parent[x] = x;
+        rank[x] = 0;
+    }
+
+    int find(int x) {
+        int root = x;
+        while (parent[root] != root)
+            root = parent[root];
+        while (parent[x] != root) {
+            int next = parent[x];
+            parent[x] = root;
+            x = next;
+        }
+        return root;
+    }
+
+    /**
+        Merges the sets of a and b, returns the root of the union.
+    */
+    int unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return a;
+        unions++;
+        if (rank[a] < rank[b]) std::swap(a, b);
+        parent[b] = a;
+        if (rank[a] == rank[b]) rank[a]++;
+        return a;
+    }
+
+    /**
+        Number of unite() calls that merged two different sets.
+    */
+    int merges() const { return unions; }
+
+    /**
+        Points every element directly to its root: find() is then a single
+        lookup until the next unite().
+    */
+    void flatten() {
+        for (int x = 0; x < (int) parent.size(); x++)
+            parent[x] = find(x);
+    }
+
+private:
+    std::vector<int> parent;
+    std::vector<int> rank;
+    int unions = 0;
+};
+
+#endif
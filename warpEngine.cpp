@@ -0,0 +1,144 @@
+#include "warpEngine.h"
+#include "tpGeometry.h"
+#include "parallel.h"
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <cassert>
+using namespace cv;
+using namespace std;
+
+AffineMap AffineMap::fromMatrix(Mat m)
+{
+    assert(m.rows == 2 && m.cols == 3);
+    assert(m.type() == CV_32FC1 || m.type() == CV_64FC1);
+    Mat m64;
+    m.convertTo(m64, CV_64FC1);
+    AffineMap res;
+    res.a = m64.at<double>(0, 0);
+    res.b = m64.at<double>(0, 1);
+    res.c = m64.at<double>(0, 2);
+    res.d = m64.at<double>(1, 0);
+    res.e = m64.at<double>(1, 1);
+    res.f = m64.at<double>(1, 2);
+    return res;
+}
+
+AffineMap AffineMap::rotation(double angle, double srcCx, double srcCy, double dstCx, double dstCy)
+{
+    double alpha = angle * M_PI / 180;
+    double cosA = cos(alpha);
+    double sinA = sin(alpha);
+    AffineMap res;
+    res.a = cosA;
+    res.b = -sinA;
+    res.c = srcCx - dstCx * cosA + dstCy * sinA;
+    res.d = sinA;
+    res.e = cosA;
+    res.f = srcCy - dstCx * sinA - dstCy * cosA;
+    return res;
+}
+
+AffineMap AffineMap::scaling(double fx, double fy)
+{
+    assert(fx != 0 && fy != 0);
+    AffineMap res;
+    res.a = 1 / fx;
+    res.e = 1 / fy;
+    return res;
+}
+
+AffineMap AffineMap::inverse() const
+{
+    double det = a * e - b * d;
+    assert(det != 0);
+    AffineMap res;
+    res.a = e / det;
+    res.b = -b / det;
+    res.d = -d / det;
+    res.e = a / det;
+    res.c = -(res.a * c + res.b * f);
+    res.f = -(res.d * c + res.e * f);
+    return res;
+}
+
+/**
+    Fills the tile of res from map, each row of the tile being sampled in one
+    batch. Pixels whose source is outside of the image are then set to 0.
+*/
+static void warpTile(const Mat &image, Mat &res, const AffineMap &map, const Rect &tile,
+                     Interpolation interpolation, InterpolationFunction function) {
+    float maxX = (float) (image.cols - 1);
+    float maxY = (float) (image.rows - 1);
+    vector<float> xs(tile.width), ys(tile.width);
+    auto inside = [&](int k) {
+        return xs[k] >= 0 && xs[k] <= maxX && ys[k] >= 0 && ys[k] <= maxY;
+    };
+    for (int i = tile.y; i < tile.y + tile.height; i++) {
+        float *out = res.ptr<float>(i) + tile.x;
+        // from the row start for each pixel: a running sum drifts past the
+        // last column over a row, which would then be set to 0
+        double x0 = map.a * tile.x + map.b * i + map.c;
+        double y0 = map.d * tile.x + map.e * i + map.f;
+        for (int k = 0; k < tile.width; k++) {
+            xs[k] = (float) (x0 + k * map.a);
+            ys[k] = (float) (y0 + k * map.d);
+        }
+
+        if (function == nullptr) {
+            interpolate(image, xs.data(), ys.data(), tile.width, out, interpolation);
+        }
+        else {
+            for (int k = 0; k < tile.width; k++) {
+                if (inside(k))
+                    out[k] = function(image, ys[k], xs[k]);
+            }
+        }
+        for (int k = 0; k < tile.width; k++) {
+            if (!inside(k))
+                out[k] = 0;
+        }
+    }
+}
+
+static Mat warpWith(const Mat &image, const AffineMap &map, Size size,
+                    Interpolation interpolation, InterpolationFunction function) {
+    assert(image.type() == CV_32FC1 || image.type() == CV_8UC1);
+    Mat res(size, CV_32FC1);
+    if (image.empty()) {
+        res.setTo(0);
+        return res;
+    }
+    parallel_for_2d(res.rows, res.cols, 2 * sizeof(float), [&](const Rect &tile) {
+        warpTile(image, res, map, tile, interpolation, function);
+    });
+    return res;
+}
+
+Mat warp(Mat image, const AffineMap &map, Size size, Interpolation interpolation)
+{
+    return warpWith(image, map, size, interpolation, nullptr);
+}
+
+Mat warp(Mat image, const AffineMap &map, Size size, InterpolationFunction interpolation)
+{
+    if (interpolation == interpolate_nearest)
+        return warp(image, map, size, INTERP_NEAREST);
+    if (interpolation == interpolate_bilinear)
+        return warp(image, map, size, INTERP_BILINEAR);
+    return warpWith(image, map, size, INTERP_NEAREST, interpolation);
+}
+
+Mat warpAffine(Mat image, Mat transform, Size size, Interpolation interpolation)
+{
+    return warp(image, AffineMap::fromMatrix(transform).inverse(), size, interpolation);
+}
+
+Mat scale(Mat image, Size size, Interpolation interpolation)
+{
+    assert(size.width > 0 && size.height > 0);
+    AffineMap map;
+    map.a = size.width > 1 ? (image.cols - 1) / (double) (size.width - 1) : 0;
+    map.e = size.height > 1 ? (image.rows - 1) / (double) (size.height - 1) : 0;
+    return warp(image, map, size, interpolation);
+}
@@ -0,0 +1,76 @@
+#ifndef WARP_ENGINE_H
+#define WARP_ENGINE_H
+
+#include <opencv2/core.hpp>
+#include "interpolation.h"
+
+/**
+    Affine map from output pixel (x = column, y = row) to source coordinates:
+        srcX = a * x + b * y + c
+        srcY = d * x + e * y + f
+*/
+struct AffineMap {
+    double a = 1, b = 0, c = 0;
+    double d = 0, e = 1, f = 0;
+
+    /**
+        Map of a 2x3 matrix (CV_32FC1 or CV_64FC1) given in this layout.
+    */
+    static AffineMap fromMatrix(cv::Mat m);
+
+    /**
+        Rotation of angle degrees (clockwise on screen) around the source point
+        (srcCx, srcCy), which is sent to the output point (dstCx, dstCy).
+    */
+    static AffineMap rotation(double angle, double srcCx, double srcCy, double dstCx, double dstCy);
+
+    /**
+        Scaling of factors fx, fy (output = fx * source) around the origin.
+    */
+    static AffineMap scaling(double fx, double fy);
+
+    /**
+        Reverse map; the map must be invertible.
+    */
+    AffineMap inverse() const;
+};
+
+/**
+    Generic interpolation function of the tp modules: value of image at
+    (row, column).
+*/
+typedef float (*InterpolationFunction)(cv::Mat image, float y, float x);
+
+/**
+    Output of size size whose pixel (x, y) is image read at map(x, y).
+    Pixels whose source lies outside [0, cols-1] x [0, rows-1] are set to 0.
+
+    Source coordinates are computed from the start of each row (one multiply
+    add per coordinate and pixel) and the row is then sampled in one batch by
+    interpolate (interpolation.h). Rows are spread over the thread pool.
+    image is CV_32FC1 or CV_8UC1, the result is CV_32FC1.
+*/
+cv::Mat warp(cv::Mat image, const AffineMap &map, cv::Size size,
+             Interpolation interpolation = INTERP_BILINEAR);
+
+/**
+    Same as above with any interpolation function; interpolate_nearest and
+    interpolate_bilinear are recognised and routed to the batch kernels.
+*/
+cv::Mat warp(cv::Mat image, const AffineMap &map, cv::Size size,
+             InterpolationFunction interpolation);
+
+/**
+    Affine warp by a 2x3 matrix mapping source to output coordinates, as in
+    OpenCV: the matrix is inverted to sample the source.
+*/
+cv::Mat warpAffine(cv::Mat image, cv::Mat transform, cv::Size size,
+                   Interpolation interpolation = INTERP_BILINEAR);
+
+/**
+    Resamples image to size, the corner pixels of both images being aligned:
+    output pixel (x, y) reads source (x * (cols-1) / (size.width-1), ...).
+*/
+cv::Mat scale(cv::Mat image, cv::Size size, Interpolation interpolation = INTERP_BILINEAR);
+
+#endif